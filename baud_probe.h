@@ -0,0 +1,278 @@
+// RadShot - Link speed probing
+// Many USB-serial cables (CH340, CP210x) run well above 115200. The prober tries the
+// standard rates fastest first with a test capture on its own thread and keeps the
+// first one that returns exactly one valid frame.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "capture_worker.h"
+#include "port_poller.h"
+#include "response_framer.h"
+#include "serial_transport.h"
+
+constexpr uint32_t BAUD_RATES[] = { 921600, 460800, 230400, 115200, 57600, 38400, 19200, 9600 };
+constexpr int BAUD_RATE_COUNT = (int)(sizeof(BAUD_RATES) / sizeof(BAUD_RATES[0]));
+constexpr uint32_t DEFAULT_BAUD_RATE = 115200;
+constexpr uint32_t PROBE_FIRST_BYTE_MS = 400;   // A radio at another rate stays silent; don't wait long
+
+inline bool IsStandardBaudRate(uint32_t baud) {
+    for (int i = 0; i < BAUD_RATE_COUNT; i++) {
+        if (BAUD_RATES[i] == baud) return true;
+    }
+    return false;
+}
+
+enum class ProbeOutcome { Frame, NoResponse, BadFrame, OpenFailed, Cancelled };
+
+struct BaudProbeAttempt {
+    uint32_t baud;
+    ProbeOutcome outcome;
+    int bytes;             // Response bytes received, tail included
+    uint32_t elapsed_ms;
+};
+
+// A test capture on one open transport, judged the way ProbeBaudRate describes.
+// RunProbes fills in everything after `baud`.
+struct ProbeRequest {
+    ISerialTransport* transport;   // Open; closed once the outcome is decided
+    uint32_t baud;                 // Rate it was opened at; sets the deadlines
+    ProbeOutcome outcome;
+    int bytes;                     // Response bytes received, tail included
+    uint32_t latency_ms;           // Request -> first response byte (valid when bytes > 0)
+    uint32_t elapsed_ms;           // Request -> outcome decided
+};
+
+// Writes every request back to back and collects the responses from one PortPoller loop,
+// so any number of ports take one probe's time. Returns once every outcome is decided.
+// `poller` is supplied by the caller so another thread can Wake() it after setting `cancel`.
+inline void RunProbes(std::vector<ProbeRequest>& requests, PortPoller& poller,
+                      const std::atomic<bool>* cancel = nullptr) {
+    using Clock = std::chrono::steady_clock;
+
+    struct Probe {
+        ResponseFramer framer;
+        CaptureTimeouts timeouts;
+        Clock::time_point sent_at, frame_deadline;
+        bool complete = false;
+        bool done = false;
+        bool polled = false;   // Read on every pass: no wait handle, or the poller couldn't take it
+    };
+
+    auto msSince = [](Clock::time_point from, Clock::time_point to) {
+        return to <= from ? 0u : (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count();
+    };
+
+    std::vector<Probe> probes(requests.size());
+    size_t pending = 0;
+
+    auto finish = [&](size_t i, ProbeOutcome outcome, Clock::time_point now) {
+        ProbeRequest& request = requests[i];
+        request.outcome = outcome;
+        request.elapsed_ms = msSince(probes[i].sent_at, now);
+        probes[i].done = true;
+        if (!probes[i].polled) poller.Remove(request.transport->GetWaitHandle());
+        request.transport->Close();
+        pending--;
+    };
+
+    for (size_t i = 0; i < requests.size(); i++) {
+        ProbeRequest& request = requests[i];
+        Probe& probe = probes[i];
+        request.outcome = ProbeOutcome::NoResponse;
+        request.bytes = 0;
+        request.latency_ms = 0;
+        request.elapsed_ms = 0;
+        probe.timeouts = CaptureTimeouts::ForBaud(request.baud);
+        probe.framer.Configure(probe.timeouts.tail_gap_ms, probe.timeouts.inter_byte_ms);
+
+        request.transport->Purge();
+        probe.sent_at = Clock::now();
+        if (!request.transport->Write(SCREENSHOT_CMD, sizeof(SCREENSHOT_CMD))) {
+            request.outcome = ProbeOutcome::OpenFailed;
+            probe.done = true;
+            request.transport->Close();
+            continue;
+        }
+        probe.frame_deadline = probe.sent_at + std::chrono::milliseconds(probe.timeouts.frame_ms);
+        probe.framer.Open();
+        probe.polled = !poller.Add(request.transport->GetWaitHandle(), (int)i);
+        pending++;
+    }
+
+    std::vector<int> ready;
+    uint8_t temp[256];
+    while (pending > 0) {
+        if (cancel && cancel->load()) {
+            for (size_t i = 0; i < probes.size(); i++) {
+                if (!probes[i].done) finish(i, ProbeOutcome::Cancelled, Clock::now());
+            }
+            break;
+        }
+
+        // Decide whatever is due and find the next deadline
+        Clock::time_point now = Clock::now();
+        Clock::time_point next = Clock::time_point::max();
+        bool poll = false;
+        for (size_t i = 0; i < probes.size(); i++) {
+            Probe& probe = probes[i];
+            if (probe.done) continue;
+
+            probe.framer.Tick(now);
+            if (probe.complete && probe.framer.State() == FramerState::Idle) {
+                // Tail window closed: any extra bytes mean it's not the frame we asked for
+                // (at a mismatched rate the UART turns the frame into garbage of another length)
+                finish(i, probe.framer.TakeOverlong() > 0 ? ProbeOutcome::BadFrame : ProbeOutcome::Frame, now);
+                continue;
+            }
+
+            Clock::time_point deadline = probe.framer.NextDeadline();
+            if (!probe.complete) {
+                Clock::time_point gap = probe.framer.Received() == 0 ?
+                    probe.sent_at + std::chrono::milliseconds(PROBE_FIRST_BYTE_MS) :
+                    probe.framer.LastByteAt() + std::chrono::milliseconds(probe.timeouts.inter_byte_ms);
+                Clock::time_point captureDeadline = (std::min)(gap, probe.frame_deadline);
+                if (now >= captureDeadline) {
+                    finish(i, requests[i].bytes > 0 ? ProbeOutcome::BadFrame : ProbeOutcome::NoResponse, now);
+                    continue;
+                }
+                deadline = (std::min)(deadline, captureDeadline);
+            }
+            next = (std::min)(next, deadline);
+
+            if (requests[i].transport->ArmWait() || probe.polled) poll = true;
+        }
+        if (pending == 0) break;
+
+        uint32_t waitMs = next <= now ? 0 : (uint32_t)
+            std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count() + 1;
+        if (poll) waitMs = (std::min)(waitMs, POLL_FALLBACK_MS);
+
+        ready.clear();
+        if (!poller.Wait(waitMs, ready)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        // Read every open port: cheap with a zero timeout, and covers polled ones
+        for (size_t i = 0; i < probes.size(); i++) {
+            Probe& probe = probes[i];
+            if (probe.done) continue;
+            ProbeRequest& request = requests[i];
+            for (int chunk = 0; chunk < 16; chunk++) {
+                int n = request.transport->Read(temp, sizeof(temp), 0);
+                if (n < 0) {
+                    finish(i, ProbeOutcome::OpenFailed, Clock::now());
+                    break;
+                }
+                if (n == 0) break;
+                Clock::time_point arrived = Clock::now();
+                if (request.bytes == 0) request.latency_ms = msSince(probe.sent_at, arrived);
+                request.bytes += n;
+                if (probe.framer.Feed(temp, (size_t)n, arrived)) probe.complete = true;
+            }
+        }
+    }
+}
+
+// One test capture at `baud`. Only an exact BITMAP_SIZE response with no tail counts: at a
+// mismatched rate the UART turns the frame into garbage of another length. The transport
+// is closed again before returning. `poller` as for RunProbes.
+inline BaudProbeAttempt ProbeBaudRate(ISerialTransport& transport, const char* port, uint32_t baud,
+                                      PortPoller& poller, const std::atomic<bool>* cancel = nullptr) {
+    BaudProbeAttempt attempt = { baud, ProbeOutcome::OpenFailed, 0, 0 };
+    if (!transport.Open(port, baud)) return attempt;
+
+    std::vector<ProbeRequest> requests(1);
+    requests[0].transport = &transport;
+    requests[0].baud = baud;
+    RunProbes(requests, poller, cancel);
+    attempt.outcome = requests[0].outcome;
+    attempt.bytes = requests[0].bytes;
+    attempt.elapsed_ms = requests[0].elapsed_ms;
+    return attempt;
+}
+
+// Runs ProbeBaudRate over BAUD_RATES, fastest first, on a background thread.
+// The UI polls IsDone() and reads the results once it returns true.
+class BaudProber {
+public:
+    using TransportFactory = std::function<std::unique_ptr<ISerialTransport>()>;
+
+    ~BaudProber() { Cancel(); }
+
+    bool Start(const char* port, TransportFactory factory = CreatePlatformTransport) {
+        Cancel();
+        transport_ = factory();
+        if (!transport_) return false;
+
+        port_ = port;
+        attempts_.clear();
+        result_ = 0;
+        current_ = 0;
+        cancel_ = false;
+        done_ = false;
+        thread_ = std::thread(&BaudProber::Run, this);
+        return true;
+    }
+
+    // Stops the probe and waits for the thread; the port is closed afterwards
+    void Cancel() {
+        if (thread_.joinable()) {
+            cancel_ = true;
+            poller_.Wake();
+            thread_.join();
+        }
+        transport_.reset();
+    }
+
+    bool IsRunning() const { return thread_.joinable(); }
+
+    // Returns true once, when the probe has finished. Joins the thread, so the
+    // results below are safe to read afterwards.
+    bool IsDone() {
+        if (!thread_.joinable() || !done_.load()) return false;
+        thread_.join();
+        transport_.reset();
+        return true;
+    }
+
+    // Rate currently being tried (while running)
+    uint32_t CurrentBaud() const { return current_.load(); }
+
+    // Fastest rate that returned a valid frame, or 0
+    uint32_t Result() const { return result_; }
+    const std::vector<BaudProbeAttempt>& Attempts() const { return attempts_; }
+    const std::string& Port() const { return port_; }
+
+private:
+    void Run() {
+        for (int i = 0; i < BAUD_RATE_COUNT && !cancel_.load(); i++) {
+            current_ = BAUD_RATES[i];
+            BaudProbeAttempt attempt = ProbeBaudRate(*transport_, port_.c_str(), BAUD_RATES[i], poller_, &cancel_);
+            if (attempt.outcome == ProbeOutcome::Cancelled) break;
+            attempts_.push_back(attempt);
+            if (attempt.outcome == ProbeOutcome::Frame) {
+                result_ = BAUD_RATES[i];
+                break;
+            }
+        }
+        done_ = true;
+    }
+
+    std::unique_ptr<ISerialTransport> transport_;
+    std::thread thread_;
+    PortPoller poller_;
+    std::string port_;
+    std::vector<BaudProbeAttempt> attempts_;
+    uint32_t result_ = 0;
+    std::atomic<uint32_t> current_{0};
+    std::atomic<bool> cancel_{false};
+    std::atomic<bool> done_{false};
+};
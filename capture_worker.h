@@ -0,0 +1,585 @@
+// RadShot - Capture worker
+// Runs the screenshot protocol for any number of radios on one thread: each port is a
+// CaptureSession with its own framing and deadlines, and a PortPoller multiplexes their
+// I/O. The UI hands it commands and collects frames/progress through lock-free SPSC queues;
+// events the UI isn't draining wait in a bounded backlog rather than stalling the I/O.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "frame_decoder.h"
+#include "frame_hash.h"
+#include "port_poller.h"
+#include "response_framer.h"
+#include "serial_transport.h"
+#include "spsc_queue.h"
+
+// =============================================================================
+// Protocol
+// =============================================================================
+
+constexpr uint8_t SCREENSHOT_CMD[] = { 0x41, 0x41 };
+constexpr uint32_t IDLE_WAIT_MS = 250;                 // Loop wait while nothing is due (Wake() cuts it short)
+constexpr uint32_t POLL_FALLBACK_MS = 5;               // Wait cap while a session is polled
+constexpr uint32_t CAPTURE_RESPONSE_LATENCY_MS = 1000; // Radio-side time to start answering
+constexpr uint32_t CAPTURE_MIN_GAP_MS = 100;           // Covers USB-serial latency timers
+constexpr uint32_t CAPTURE_SLACK_MS = 250;
+constexpr uint32_t CAPTURE_TAIL_GAP_MIN_MS = 20;       // Outlasts FTDI's 16 ms latency timer holding back a tail
+constexpr int BURST_MAX_TIMEOUTS = 3;                  // Consecutive timeouts that end a burst
+constexpr size_t CAPTURE_EVENT_BACKLOG = 1024;         // Events held while the UI isn't draining (~1 MB)
+
+// Capture deadlines, measured on the monotonic clock from when the request is written.
+// All three scale with the link speed so a slow link isn't aborted early and a dead
+// one is reported within a known bound.
+struct CaptureTimeouts {
+    uint32_t first_byte_ms;   // Request -> first response byte
+    uint32_t inter_byte_ms;   // Longest silence once the response has started
+    uint32_t frame_ms;        // Request -> complete frame
+    uint32_t tail_gap_ms;     // Silence that ends a response; bytes inside it are an over-long tail
+
+    // Time the full frame spends on the wire at 8N1 (10 bits per byte)
+    static uint32_t WireTimeMs(uint32_t baud, uint32_t bytes) {
+        if (baud == 0) return 0;
+        return (uint32_t)(((uint64_t)bytes * 10 * 1000 + baud - 1) / baud);
+    }
+
+    static CaptureTimeouts ForBaud(uint32_t baud) {
+        CaptureTimeouts t;
+        uint32_t frameWire = WireTimeMs(baud, BITMAP_SIZE);
+        t.first_byte_ms = CAPTURE_RESPONSE_LATENCY_MS;
+        t.inter_byte_ms = (std::max)(CAPTURE_MIN_GAP_MS, WireTimeMs(baud, 64));
+        t.frame_ms = CAPTURE_RESPONSE_LATENCY_MS + 2 * frameWire + CAPTURE_SLACK_MS;
+        t.tail_gap_ms = (std::max)(CAPTURE_TAIL_GAP_MIN_MS, WireTimeMs(baud, 64));
+        return t;
+    }
+};
+
+// =============================================================================
+// Messages
+// =============================================================================
+
+enum class CaptureCommandType { Capture, Burst, StopBurst };
+
+struct CaptureCommand {
+    CaptureCommandType type;
+    int session;
+    int count;   // Burst: frames to capture, 0 = until stopped
+};
+
+// Error means the port failed and its session has been closed.
+// Overlong reports a frame that was followed by extra bytes (discarded, `bytes` = count).
+enum class CaptureEventType { Progress, Frame, Timeout, Error, BurstDone, Overlong };
+
+// Which deadline expired, for Timeout events
+enum class CaptureTimeoutKind { None, FirstByte, InterByte, Frame };
+
+struct CaptureEvent {
+    int session;                  // Id returned by CaptureWorker::AddSession
+    CaptureEventType type;
+    CaptureTimeoutKind timeout;
+    int bytes;                    // Bytes received so far
+    uint32_t elapsed_ms;          // Since the request was written (BurstDone: since the burst began)
+    int burst_frames;             // BurstDone: frames captured
+    int burst_failed;             // BurstDone: requests that timed out
+    int burst_dropped;            // BurstDone: frames dropped because the UI fell a full backlog behind
+    uint64_t hash;                // Frame: HashFrame() of the frame, computed on the worker thread
+    uint8_t frame[BITMAP_SIZE];   // Frame: the whole frame. Progress: the first `bytes` bytes
+};
+
+inline const char* CaptureTimeoutName(CaptureTimeoutKind kind) {
+    switch (kind) {
+    case CaptureTimeoutKind::FirstByte: return "no response";
+    case CaptureTimeoutKind::InterByte: return "link stalled";
+    case CaptureTimeoutKind::Frame: return "frame too slow";
+    default: return "";
+    }
+}
+
+using CaptureEventQueue = SpscQueue<CaptureEvent, 64>;
+
+// Worker side of the event queue. While the queue is full (the UI thread is in a modal
+// loop, say) events wait in a backlog here instead of blocking the thread every radio's
+// I/O runs on. Order is kept: once anything is backlogged, later events queue behind it.
+class CaptureEventOutbox {
+public:
+    explicit CaptureEventOutbox(CaptureEventQueue& queue) : queue_(queue) {}
+
+    // Returns false if the event was dropped: Progress whenever it can't go straight
+    // through, `droppable` events once the backlog is full. Others are always kept; there
+    // are at most a few per session and command.
+    bool Push(const CaptureEvent& ev, bool droppable) {
+        Flush();
+        if (backlog_.empty() && queue_.TryPush(ev)) return true;
+        if (ev.type == CaptureEventType::Progress) return false;
+        if (droppable && backlog_.size() >= CAPTURE_EVENT_BACKLOG) return false;
+        backlog_.push_back(ev);
+        return true;
+    }
+
+    // Moves backlogged events into the queue as the UI makes room
+    void Flush() {
+        while (!backlog_.empty() && queue_.TryPush(backlog_.front())) backlog_.pop_front();
+    }
+
+    bool Backlogged() const { return !backlog_.empty(); }
+    void Clear() { backlog_.clear(); }
+
+private:
+    CaptureEventQueue& queue_;
+    std::deque<CaptureEvent> backlog_;
+};
+
+// =============================================================================
+// Session
+// =============================================================================
+
+// One radio: its transport, response framing, deadlines and any burst in progress.
+// Lives on the worker thread; every event it raises carries its id.
+class CaptureSession {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CaptureSession(int id, std::unique_ptr<ISerialTransport> transport, uint32_t baud,
+                   CaptureEventOutbox& events)
+        : id_(id), transport_(std::move(transport)), events_(events) {
+        timeouts_ = CaptureTimeouts::ForBaud(baud);
+        framer_.Configure(timeouts_.tail_gap_ms, timeouts_.inter_byte_ms);
+    }
+
+    ~CaptureSession() { transport_->Close(); }
+
+    int Id() const { return id_; }
+    ISerialTransport& Transport() { return *transport_; }
+
+    // Read on every pass of the worker loop rather than when its wait handle fires: the
+    // transport has none, or the poller couldn't take it
+    bool Polled() const { return polled_; }
+    void SetPolled(bool polled) { polled_ = polled; }
+
+    // Each of these returns false if the port failed; the worker then closes the session
+    bool HandleCommand(const CaptureCommand& cmd) {
+        switch (cmd.type) {
+        case CaptureCommandType::Capture:
+            if (capturing_ || bursting_ || request_pending_) return true;
+            return SendRequest(true);
+        case CaptureCommandType::Burst:
+            if (capturing_ || bursting_ || request_pending_) return true;
+            bursting_ = true;
+            burst_stop_ = false;
+            burst_count_ = cmd.count;
+            burst_frames_ = 0;
+            burst_failed_ = 0;
+            burst_dropped_ = 0;
+            burst_timeouts_ = 0;
+            burst_start_ = Clock::now();
+            return SendRequest(true);
+        case CaptureCommandType::StopBurst:
+            burst_stop_ = true;
+            if (bursting_ && request_pending_) {
+                // Next request not on the wire yet; end the burst here
+                request_pending_ = false;
+                bursting_ = false;
+                burst_done_ = true;
+                ReportBurstDone();
+            }
+            return true;
+        }
+        return true;
+    }
+
+    // Time-driven work: framer transitions, held-back requests and capture deadlines
+    bool Service(Clock::time_point now) {
+        framer_.Tick(now);
+        int overlong = framer_.TakeOverlong();
+        if (overlong > 0) Push(CaptureEventType::Overlong, overlong);
+        if (request_pending_ && !SendRequest(pending_purge_)) return false;
+        if (!capturing_) return true;
+
+        Clock::time_point deadline = CaptureDeadline();
+        if (now < deadline) return true;
+
+        int received = framer_.Received();
+        CaptureTimeoutKind kind = deadline == frame_deadline_ ? CaptureTimeoutKind::Frame :
+            received == 0 ? CaptureTimeoutKind::FirstByte : CaptureTimeoutKind::InterByte;
+        capturing_ = false;
+        framer_.Abort(now);
+        Push(CaptureEventType::Timeout, received, MsBetween(sent_at_, now), kind);
+        bool sent = ContinueBurst(false);
+        ReportBurstDone();
+        return sent;
+    }
+
+    // Drains whatever the transport has buffered without blocking
+    bool OnReadable() {
+        uint8_t temp[256];
+        for (int chunk = 0; chunk < 16; chunk++) {
+            int bytesRead = transport_->Read(temp, sizeof(temp), 0);
+            if (bytesRead < 0) return false;
+            if (bytesRead == 0) return true;
+            if (!OnBytes(temp, bytesRead)) return false;
+        }
+        return true;
+    }
+
+    // When Service() next has something to do, or time_point::max()
+    Clock::time_point NextDeadline() const {
+        Clock::time_point deadline = framer_.NextDeadline();
+        if (capturing_) deadline = (std::min)(deadline, CaptureDeadline());
+        return deadline;
+    }
+
+    void ReportError() { Push(CaptureEventType::Error, framer_.Received()); }
+
+private:
+    static uint32_t MsBetween(Clock::time_point from, Clock::time_point to) {
+        if (to <= from) return 0;
+        return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count();
+    }
+
+    Clock::time_point CaptureDeadline() const {
+        Clock::time_point gapDeadline = framer_.Received() == 0 ?
+            sent_at_ + std::chrono::milliseconds(timeouts_.first_byte_ms) :
+            framer_.LastByteAt() + std::chrono::milliseconds(timeouts_.inter_byte_ms);
+        return (std::min)(gapDeadline, frame_deadline_);
+    }
+
+    bool OnBytes(const uint8_t* data, int size) {
+        // The framer drops stale bytes and splits off over-long tails
+        Clock::time_point arrived = Clock::now();
+        if (framer_.Feed(data, (size_t)size, arrived)) {
+            // A burst queues its next request; it goes out once the tail gap has passed
+            capturing_ = false;
+            Push(CaptureEventType::Frame, BITMAP_SIZE, MsBetween(sent_at_, arrived),
+                 CaptureTimeoutKind::None, framer_.Frame());
+            bool sent = ContinueBurst(true);
+            ReportBurstDone();
+            return sent;
+        }
+        if (capturing_ && framer_.Received() > 0) {
+            // Carries the partial frame so the UI can show each band as it lands.
+            // A dropped Progress is harmless: the next one holds the same prefix and more.
+            Push(CaptureEventType::Progress, framer_.Received(), MsBetween(sent_at_, arrived),
+                 CaptureTimeoutKind::None, framer_.Frame());
+        }
+        return true;
+    }
+
+    void Push(CaptureEventType type, int bytes, uint32_t elapsed_ms = 0,
+              CaptureTimeoutKind timeout = CaptureTimeoutKind::None, const uint8_t* frame = nullptr) {
+        CaptureEvent ev;
+        ev.session = id_;
+        ev.type = type;
+        ev.timeout = timeout;
+        ev.bytes = bytes;
+        ev.elapsed_ms = elapsed_ms;
+        ev.burst_frames = burst_frames_;
+        ev.burst_failed = burst_failed_;
+        ev.burst_dropped = burst_dropped_;
+        ev.hash = 0;
+        if (frame) memcpy(ev.frame, frame, bytes);
+        if (type == CaptureEventType::Frame) ev.hash = HashFrame(ev.frame);
+
+        // Progress is best-effort. A burst runs unattended and can outlast any backlog, so
+        // its frames may be dropped (and counted); everything else reaches the UI.
+        bool droppable = bursting_ && type != CaptureEventType::Error && type != CaptureEventType::BurstDone;
+        if (!events_.Push(ev, droppable) && type == CaptureEventType::Frame) burst_dropped_++;
+    }
+
+    // Writes a screenshot request and opens a capture. The request is held back until the
+    // framer sees a quiet line: the tail gap after a frame, longer after an aborted one.
+    // Bursts skip the purge between good frames.
+    bool SendRequest(bool purge) {
+        Clock::time_point now = Clock::now();
+        if (!framer_.CanOpen(now)) {
+            request_pending_ = true;
+            pending_purge_ = purge;
+            return true;
+        }
+        request_pending_ = false;
+        if (purge) transport_->Purge();
+        if (!transport_->Write(SCREENSHOT_CMD, sizeof(SCREENSHOT_CMD))) return false;
+        capturing_ = true;
+        sent_at_ = Clock::now();
+        frame_deadline_ = sent_at_ + std::chrono::milliseconds(timeouts_.frame_ms);
+        framer_.Open();
+        return true;
+    }
+
+    // Decides what follows a finished (or failed) burst request and sends it.
+    // Returns false if the port failed. When the burst ends, burst_done_ is set and the
+    // caller reports it after the frame/timeout event so the UI sees them in order.
+    bool ContinueBurst(bool gotFrame) {
+        if (!bursting_) return true;
+        if (gotFrame) {
+            burst_frames_++;
+            burst_timeouts_ = 0;
+        } else {
+            burst_failed_++;
+            burst_timeouts_++;
+        }
+
+        bool done = burst_stop_ || burst_timeouts_ >= BURST_MAX_TIMEOUTS ||
+                    (burst_count_ > 0 && burst_frames_ >= burst_count_);
+        if (!done) return SendRequest(!gotFrame);
+
+        bursting_ = false;
+        burst_done_ = true;
+        return true;
+    }
+
+    void ReportBurstDone() {
+        if (!burst_done_) return;
+        burst_done_ = false;
+        Push(CaptureEventType::BurstDone, 0, MsBetween(burst_start_, Clock::now()));
+    }
+
+    int id_;
+    std::unique_ptr<ISerialTransport> transport_;
+    CaptureEventOutbox& events_;
+    CaptureTimeouts timeouts_;
+    ResponseFramer framer_;
+    bool polled_ = false;
+
+    bool capturing_ = false;
+    bool request_pending_ = false;   // Held back until the line is quiet
+    bool pending_purge_ = false;
+    Clock::time_point sent_at_, frame_deadline_;
+
+    bool bursting_ = false;
+    bool burst_stop_ = false;
+    bool burst_done_ = false;
+    int burst_count_ = 0;
+    int burst_frames_ = 0;
+    int burst_failed_ = 0;
+    int burst_dropped_ = 0;
+    int burst_timeouts_ = 0;
+    Clock::time_point burst_start_;
+};
+
+// =============================================================================
+// Worker
+// =============================================================================
+
+// Owns every session and the one thread that serves them. Sessions are added and
+// removed from the UI thread; commands and events go through SPSC queues.
+class CaptureWorker {
+public:
+    ~CaptureWorker() { Stop(); }
+
+    // Takes ownership of an open transport and starts serving it (and the thread, if needed).
+    // `baud` is the rate the transport was opened at; deadlines are derived from it.
+    // Returns the session id used by commands and events, or -1.
+    int AddSession(std::unique_ptr<ISerialTransport> transport, uint32_t baud) {
+        if (!transport || !transport->IsOpen()) return -1;
+
+        if (!thread_.joinable()) {
+            // Discard anything left over from a previous run (no thread is running yet)
+            CaptureCommand cmd;
+            CaptureEvent ev;
+            while (commands_.TryPop(cmd)) {}
+            while (events_.TryPop(ev)) {}
+            outbox_.Clear();
+            stop_ = false;
+            running_ = true;
+            thread_ = std::thread(&CaptureWorker::Run, this);
+        }
+
+        int id = next_id_++;
+        {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            to_add_.emplace_back(new CaptureSession(id, std::move(transport), baud, outbox_));
+        }
+        poller_.Wake();
+        return id;
+    }
+
+    // Closes one session. Returns once its transport is closed, so the port can be reopened.
+    void RemoveSession(int id) {
+        if (!thread_.joinable()) return;
+        std::unique_lock<std::mutex> lock(control_mutex_);
+        to_remove_.push_back(id);
+        poller_.Wake();
+        control_cv_.wait(lock, [&] { return to_remove_.empty() || !running_.load(); });
+    }
+
+    // Stops the thread and closes every session
+    void Stop() {
+        if (!thread_.joinable()) return;
+        stop_ = true;
+        poller_.Wake();
+        thread_.join();
+    }
+
+    bool IsRunning() const { return thread_.joinable(); }
+
+    // UI thread: queue a screenshot request; it goes on the wire immediately
+    bool RequestCapture(int session) { return Send(CaptureCommandType::Capture, session); }
+
+    // UI thread: capture `count` frames back to back (0 = until StopBurst).
+    // Each request goes out as soon as the previous frame's tail gap has passed.
+    bool RequestBurst(int session, int count) { return Send(CaptureCommandType::Burst, session, count); }
+
+    // UI thread: end a burst once the frame in flight completes
+    bool RequestStopBurst(int session) { return Send(CaptureCommandType::StopBurst, session); }
+
+    // UI thread: fetch the next event, if any
+    bool PollEvent(CaptureEvent& ev) { return events_.TryPop(ev); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool Send(CaptureCommandType type, int session, int count = 0) {
+        if (!IsRunning()) return false;
+        CaptureCommand cmd = { type, session, count };
+        if (!commands_.TryPush(cmd)) return false;
+        poller_.Wake();
+        return true;
+    }
+
+    CaptureSession* Find(int id) {
+        for (auto& session : sessions_) {
+            if (session->Id() == id) return session.get();
+        }
+        return nullptr;
+    }
+
+    void Close(CaptureSession* session, bool failed) {
+        if (failed) session->ReportError();
+        if (!session->Polled()) poller_.Remove(session->Transport().GetWaitHandle());
+        for (size_t i = 0; i < sessions_.size(); i++) {
+            if (sessions_[i].get() == session) {
+                sessions_.erase(sessions_.begin() + i);
+                return;
+            }
+        }
+    }
+
+    // Applies AddSession/RemoveSession requests from the UI thread
+    void ApplyControl() {
+        std::lock_guard<std::mutex> lock(control_mutex_);
+        for (auto& session : to_add_) {
+            // Transports without a wait handle, or beyond what the poller can wait on
+            // (64 handles on Windows) or register, are polled instead
+            session->SetPolled(!poller_.Add(session->Transport().GetWaitHandle(), session->Id()));
+            sessions_.push_back(std::move(session));
+        }
+        to_add_.clear();
+        if (to_remove_.empty()) return;
+        for (int id : to_remove_) {
+            CaptureSession* session = Find(id);
+            if (session) Close(session, false);
+        }
+        to_remove_.clear();
+        control_cv_.notify_all();
+    }
+
+    void Run() {
+        std::vector<int> ready;
+        std::vector<CaptureSession*> readable;
+        std::vector<CaptureCommand> commands;
+
+        while (!stop_.load()) {
+            // Commands are taken before sessions are added: one sent right after AddSession()
+            // then finds its session instead of being dropped
+            CaptureCommand cmd;
+            commands.clear();
+            while (commands_.TryPop(cmd)) commands.push_back(cmd);
+            ApplyControl();
+            outbox_.Flush();
+
+            for (const CaptureCommand& command : commands) {
+                CaptureSession* session = Find(command.session);
+                if (session && !session->HandleCommand(command)) Close(session, true);
+            }
+
+            // Deadlines first, then work out how long the loop may sleep
+            Clock::time_point now = Clock::now();
+            Clock::time_point deadline = Clock::time_point::max();
+            for (size_t i = 0; i < sessions_.size();) {
+                CaptureSession* session = sessions_[i].get();
+                if (!session->Service(now)) {
+                    Close(session, true);
+                    continue;
+                }
+                deadline = (std::min)(deadline, session->NextDeadline());
+                i++;
+            }
+
+            uint32_t waitMs = IDLE_WAIT_MS;
+            if (deadline != Clock::time_point::max()) {
+                waitMs = deadline <= now ? 0 : (std::min)(waitMs, (uint32_t)
+                    std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1);
+            }
+            // Popping doesn't wake us, so a backlog is retried on the polling interval
+            if (outbox_.Backlogged()) waitMs = (std::min)(waitMs, POLL_FALLBACK_MS);
+
+            // Sessions with bytes already buffered, or polled ones, are read regardless
+            readable.clear();
+            for (auto& session : sessions_) {
+                if (session->Transport().ArmWait()) {
+                    readable.push_back(session.get());
+                    waitMs = 0;
+                } else if (session->Polled()) {
+                    readable.push_back(session.get());
+                    waitMs = (std::min)(waitMs, POLL_FALLBACK_MS);
+                }
+            }
+
+            ready.clear();
+            if (!poller_.Wait(waitMs, ready)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            for (int id : ready) {
+                CaptureSession* session = Find(id);
+                if (session && std::find(readable.begin(), readable.end(), session) == readable.end()) {
+                    readable.push_back(session);
+                }
+            }
+            for (CaptureSession* session : readable) {
+                if (!session->OnReadable()) Close(session, true);
+            }
+        }
+
+        // Close everything; a RemoveSession() waiting on us is released
+        {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            running_ = false;
+            to_add_.clear();
+            to_remove_.clear();
+        }
+        control_cv_.notify_all();
+        for (auto& session : sessions_) {
+            if (!session->Polled()) poller_.Remove(session->Transport().GetWaitHandle());
+        }
+        sessions_.clear();
+    }
+
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> running_{false};
+    PortPoller poller_;
+    SpscQueue<CaptureCommand, 32> commands_;   // UI -> worker
+    CaptureEventQueue events_;                 // Worker -> UI
+    CaptureEventOutbox outbox_{events_};       // Worker thread only, except between runs
+    int next_id_ = 1;
+
+    // Worker thread only
+    std::vector<std::unique_ptr<CaptureSession>> sessions_;
+
+    // Session add/remove requests, guarded by control_mutex_
+    std::mutex control_mutex_;
+    std::condition_variable control_cv_;
+    std::vector<std::unique_ptr<CaptureSession>> to_add_;
+    std::vector<int> to_remove_;
+};
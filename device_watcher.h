@@ -0,0 +1,236 @@
+// RadShot - Serial device watcher
+// Keeps the serial port list cached on a background thread so the UI never waits on
+// enumeration (SetupDi can take hundreds of milliseconds with many USB devices).
+// The list is refreshed on hot-plug: device interface notifications on Windows,
+// inotify on /dev on Linux, and a slow rescan on other systems.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "port_poller.h"
+#include "serial_transport.h"
+
+#ifdef _WIN32
+#include <dbt.h>
+#elif defined(RADSHOT_POLLER_EPOLL)
+#include <sys/inotify.h>
+#endif
+
+constexpr uint32_t DEVICE_SETTLE_MS = 250;    // Quiet time after a change before enumerating
+constexpr uint32_t DEVICE_RESCAN_MS = 2000;   // Rescan period without change notifications
+
+class DeviceWatcher {
+public:
+    ~DeviceWatcher() { Stop(); }
+
+    // Starts the thread; the first enumeration happens right away on it
+    void Start() {
+        if (thread_.joinable()) return;
+        stop_ = false;
+        refresh_ = true;
+#ifdef _WIN32
+        wake_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+#endif
+        thread_ = std::thread(&DeviceWatcher::Run, this);
+    }
+
+    void Stop() {
+        if (!thread_.joinable()) return;
+        stop_ = true;
+        Wake();
+        thread_.join();
+#ifdef _WIN32
+        CloseHandle(wake_);
+        wake_ = nullptr;
+#endif
+    }
+
+    // Asks for a fresh enumeration (the Refresh button). Returns immediately.
+    void Refresh() {
+        refresh_ = true;
+        Wake();
+    }
+
+    // UI thread: copies the latest list into `ports` if it changed since the last call
+    bool TakePorts(std::vector<std::string>& ports) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!changed_) return false;
+        ports = ports_;
+        changed_ = false;
+        return true;
+    }
+
+    // Enumerations done so far, for diagnostics
+    uint32_t Scans() const { return scans_.load(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void Wake() {
+#ifdef _WIN32
+        if (wake_) SetEvent(wake_);
+#else
+        poller_.Wake();
+#endif
+    }
+
+    // Enumerates and publishes the list if it differs from the last one.
+    // The first list is always published, even when empty.
+    void Scan() {
+        std::vector<std::string> ports = EnumerateSerialPorts();
+        bool first = scans_++ == 0;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!first && ports == ports_) return;
+        ports_.swap(ports);
+        changed_ = true;
+    }
+
+    // Milliseconds until `deadline`, rounded up, or `idle` if there is none
+    static uint32_t WaitMs(Clock::time_point deadline, uint32_t idle) {
+        if (deadline == Clock::time_point::max()) return idle;
+        Clock::time_point now = Clock::now();
+        if (deadline <= now) return 0;
+        return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+    }
+
+#ifdef _WIN32
+    static LRESULT CALLBACK NotifyProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+        if (msg == WM_DEVICECHANGE &&
+            (wParam == DBT_DEVICEARRIVAL || wParam == DBT_DEVICEREMOVECOMPLETE || wParam == DBT_DEVNODES_CHANGED)) {
+            DeviceWatcher* self = (DeviceWatcher*)GetWindowLongPtrW(hWnd, GWLP_USERDATA);
+            if (self) self->dirty_ = true;
+            return TRUE;
+        }
+        return DefWindowProcW(hWnd, msg, wParam, lParam);
+    }
+
+    void Run() {
+        // A message-only window receives the COM port interface notifications
+        HINSTANCE instance = GetModuleHandleW(nullptr);
+        WNDCLASSEXW wc = { sizeof(wc) };
+        wc.lpfnWndProc = NotifyProc;
+        wc.hInstance = instance;
+        wc.lpszClassName = L"RadShotDeviceWatcher";
+        RegisterClassExW(&wc);
+        HWND hWnd = CreateWindowExW(0, wc.lpszClassName, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, instance, nullptr);
+        HDEVNOTIFY notify = nullptr;
+        if (hWnd) {
+            SetWindowLongPtrW(hWnd, GWLP_USERDATA, (LONG_PTR)this);
+            DEV_BROADCAST_DEVICEINTERFACE_W filter = {};
+            filter.dbcc_size = sizeof(filter);
+            filter.dbcc_devicetype = DBT_DEVTYP_DEVICEINTERFACE;
+            filter.dbcc_classguid = GUID_DEVINTERFACE_COMPORT;
+            notify = RegisterDeviceNotificationW(hWnd, &filter, DEVICE_NOTIFY_WINDOW_HANDLE);
+        }
+        // Without notifications, fall back to rescanning
+        uint32_t idleMs = notify ? INFINITE : DEVICE_RESCAN_MS;
+
+        Clock::time_point scanAt = Clock::time_point::max();
+        while (!stop_.load()) {
+            if (refresh_.exchange(false)) {
+                Scan();
+                scanAt = Clock::time_point::max();
+            }
+            if (dirty_.exchange(false)) {
+                // Devices arrive in several steps; enumerate once they settle
+                scanAt = Clock::now() + std::chrono::milliseconds(DEVICE_SETTLE_MS);
+            }
+            if (scanAt != Clock::time_point::max() && Clock::now() >= scanAt) {
+                Scan();
+                scanAt = Clock::time_point::max();
+            }
+
+            DWORD wait = MsgWaitForMultipleObjects(1, &wake_, FALSE, WaitMs(scanAt, idleMs), QS_ALLINPUT);
+            if (wait == WAIT_TIMEOUT && !notify) refresh_ = true;
+
+            MSG msg;
+            while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
+                TranslateMessage(&msg);
+                DispatchMessageW(&msg);
+            }
+        }
+
+        if (notify) UnregisterDeviceNotification(notify);
+        if (hWnd) DestroyWindow(hWnd);
+        UnregisterClassW(wc.lpszClassName, instance);
+    }
+#else
+    void Run() {
+        int watch = -1;
+#ifdef RADSHOT_POLLER_EPOLL
+        watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (watch >= 0 && inotify_add_watch(watch, "/dev",
+                IN_CREATE | IN_DELETE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO) < 0) {
+            close(watch);
+            watch = -1;
+        }
+        if (watch >= 0) poller_.Add(watch, 0);
+#endif
+        uint32_t idleMs = watch >= 0 ? 60 * 1000 : DEVICE_RESCAN_MS;
+
+        Clock::time_point scanAt = Clock::time_point::max();
+        std::vector<int> ready;
+        while (!stop_.load()) {
+            if (refresh_.exchange(false)) {
+                Scan();
+                scanAt = Clock::time_point::max();
+            }
+            if (scanAt != Clock::time_point::max() && Clock::now() >= scanAt) {
+                Scan();
+                scanAt = Clock::time_point::max();
+            }
+
+            ready.clear();
+            uint32_t waitMs = WaitMs(scanAt, idleMs);
+            poller_.Wait(waitMs, ready);
+            if (ready.empty()) {
+                if (watch < 0 && scanAt == Clock::time_point::max() && !stop_.load()) refresh_ = true;
+                continue;
+            }
+#ifdef RADSHOT_POLLER_EPOLL
+            // Only serial device nodes matter; /dev sees plenty of other traffic
+            alignas(inotify_event) char buf[4096];
+            ssize_t len;
+            while ((len = read(watch, buf, sizeof(buf))) > 0) {
+                for (char* p = buf; p < buf + len;) {
+                    inotify_event* ev = (inotify_event*)p;
+                    if (ev->len > 0 && (strncmp(ev->name, "ttyUSB", 6) == 0 || strncmp(ev->name, "ttyACM", 6) == 0)) {
+                        scanAt = Clock::now() + std::chrono::milliseconds(DEVICE_SETTLE_MS);
+                    }
+                    p += sizeof(inotify_event) + ev->len;
+                }
+            }
+#endif
+        }
+
+        if (watch >= 0) {
+            poller_.Remove(watch);
+            close(watch);
+        }
+    }
+
+    PortPoller poller_;
+#endif
+
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> refresh_{false};
+    std::atomic<uint32_t> scans_{0};
+#ifdef _WIN32
+    HANDLE wake_ = nullptr;
+    std::atomic<bool> dirty_{false};
+#endif
+
+    // Published list, guarded by mutex_
+    std::mutex mutex_;
+    std::vector<std::string> ports_;
+    bool changed_ = false;
+};
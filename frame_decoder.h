@@ -0,0 +1,541 @@
+// RadShot - RT-4D frame decoder
+// Converts a controller's 1bpp framebuffer straight to RGBA in a single pass.
+// Portable header (no Win32 dependencies) so it can be built and checked on any platform.
+//
+// FrameDecoder<Width, Height, Layout, Scale> is specialized at compile time for one
+// display geometry and controller layout: all per-row loops are unrolled and the
+// pixel tables are constexpr. A new LCD variant is a new instantiation, e.g.
+//     using St7920Decoder = FrameDecoder<128, 64, RowLayoutMsbLeft, 4>;
+// tests/decoder_diff.cpp checks that one and other layouts and geometries pixel by pixel.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#ifdef _MSC_VER
+#define RADSHOT_FORCEINLINE __forceinline
+#define RADSHOT_INLINE_LAMBDA
+#else
+#define RADSHOT_FORCEINLINE inline __attribute__((always_inline))
+#define RADSHOT_INLINE_LAMBDA __attribute__((always_inline))
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define RADSHOT_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define RADSHOT_TARGET_AVX2
+#define RADSHOT_AVX2_LAMBDA
+#else
+#define RADSHOT_TARGET_AVX2 __attribute__((target("avx2")))
+#define RADSHOT_AVX2_LAMBDA __attribute__((always_inline, target("avx2")))
+#endif
+#endif
+
+// Color palette from original (BGR format in BMP, but we use RGBA here). Other palettes
+// are in palette.h; the decoder takes any of them as a PixelLut.
+constexpr uint8_t COLOR_LIGHT[4] = { 0xDE, 0xEB, 0xFF, 0xFF }; // Light blue tint
+constexpr uint8_t COLOR_DARK[4] = { 0x00, 0x00, 0x00, 0xFF };  // Black
+
+// =============================================================================
+// Compile-time Helpers
+// =============================================================================
+
+template <typename F, size_t... I>
+RADSHOT_FORCEINLINE void UnrollImpl(F& f, std::index_sequence<I...>) {
+    int expand[] = { 0, (f(std::integral_constant<int, (int)I>()), 0)... };
+    (void)expand;
+}
+
+// Calls f(integral_constant<int, 0>) ... f(integral_constant<int, N-1>) with no loop.
+// Bodies should be marked RADSHOT_INLINE_LAMBDA so they are expanded in place.
+template <int N, typename F>
+RADSHOT_FORCEINLINE void Unroll(F&& f) {
+    UnrollImpl(f, std::make_index_sequence<N>());
+}
+
+#ifdef RADSHOT_X86
+// Same as Unroll, for bodies inside AVX2 functions (marked RADSHOT_AVX2_LAMBDA).
+// GCC and Clang refuse to inline AVX2 code through a helper compiled without it.
+template <typename F, size_t... I>
+RADSHOT_TARGET_AVX2 RADSHOT_FORCEINLINE void UnrollImplAVX2(F& f, std::index_sequence<I...>) {
+    int expand[] = { 0, (f(std::integral_constant<int, (int)I>()), 0)... };
+    (void)expand;
+}
+
+template <int N, typename F>
+RADSHOT_TARGET_AVX2 RADSHOT_FORCEINLINE void UnrollAVX2(F&& f) {
+    UnrollImplAVX2(f, std::make_index_sequence<N>());
+}
+#endif
+
+// Packs an RGBA color into a little-endian pixel word (memory order R, G, B, A).
+constexpr uint32_t PackColor(const uint8_t* c) {
+    return (uint32_t)c[0] | ((uint32_t)c[1] << 8) | ((uint32_t)c[2] << 16) | ((uint32_t)c[3] << 24);
+}
+
+// Byte -> 8 pixels, bit 0 is the leftmost pixel. Set bits are dark.
+struct PixelLut {
+    alignas(32) uint32_t px[256][8];
+    uint32_t light;
+    uint32_t dark;
+};
+
+constexpr PixelLut MakePixelLut(const uint8_t* light, const uint8_t* dark) {
+    PixelLut lut{};
+    lut.light = PackColor(light);
+    lut.dark = PackColor(dark);
+    for (int b = 0; b < 256; b++) {
+        for (int i = 0; i < 8; i++) {
+            lut.px[b][i] = ((b >> i) & 1) ? lut.dark : lut.light;
+        }
+    }
+    return lut;
+}
+
+inline const PixelLut& GetPixelLut() {
+    static constexpr PixelLut lut = MakePixelLut(COLOR_LIGHT, COLOR_DARK);
+    return lut;
+}
+
+// Byte -> 8 palette indices (0 light, 255 dark), for single-channel textures that get
+// their colours when drawn
+struct IndexLut {
+    alignas(8) uint8_t px[256][8];
+};
+
+constexpr IndexLut MakeIndexLut() {
+    IndexLut lut{};
+    for (int b = 0; b < 256; b++) {
+        for (int i = 0; i < 8; i++) {
+            lut.px[b][i] = ((b >> i) & 1) ? 0xFF : 0x00;
+        }
+    }
+    return lut;
+}
+
+inline const IndexLut& GetIndexLut() {
+    static constexpr IndexLut lut = MakeIndexLut();
+    return lut;
+}
+
+struct BitReverseTable {
+    uint8_t v[256];
+};
+
+constexpr BitReverseTable MakeBitReverseTable() {
+    BitReverseTable t{};
+    for (int b = 0; b < 256; b++) {
+        int r = 0;
+        for (int i = 0; i < 8; i++) r |= ((b >> i) & 1) << (7 - i);
+        t.v[b] = (uint8_t)r;
+    }
+    return t;
+}
+
+inline const BitReverseTable& GetBitReverseTable() {
+    static constexpr BitReverseTable table = MakeBitReverseTable();
+    return table;
+}
+
+// =============================================================================
+// Decoder Dispatch
+// =============================================================================
+
+enum class DecoderPath { Scalar, SSE2, AVX2 };
+
+inline DecoderPath DetectDecoderPath() {
+#ifdef RADSHOT_X86
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] >= 7) {
+        __cpuid(regs, 1);
+        bool osxsave = (regs[2] & (1 << 27)) != 0;
+        bool avx = (regs[2] & (1 << 28)) != 0;
+        if (osxsave && avx && (_xgetbv(0) & 6) == 6) {
+            __cpuidex(regs, 7, 0);
+            if (regs[1] & (1 << 5)) return DecoderPath::AVX2;
+        }
+    }
+    return DecoderPath::SSE2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return DecoderPath::AVX2;
+    return DecoderPath::SSE2;
+#endif
+#else
+    return DecoderPath::Scalar;
+#endif
+}
+
+inline DecoderPath ActiveDecoderPath() {
+    static const DecoderPath path = DetectDecoderPath();
+    return path;
+}
+
+// =============================================================================
+// Controller Layouts
+// =============================================================================
+// A layout unpacks one band of 8 display rows into packed rows with the leftmost
+// pixel in bit 0. All SIMD-specific work lives here; row expansion is shared.
+
+// Transposes an 8x8 bit matrix held as 8 little-endian bytes: on return, bit i
+// of byte r is what bit r of byte i was.
+inline uint64_t Transpose8x8(uint64_t x) {
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAull;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCull;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ull;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+// Vertical pages of Width bytes; each byte covers 8 rows of one column.
+// MsbTop selects whether bit 7 (some clone controllers) or bit 0 (RT-4D, ST7565, SSD1306)
+// is the top row of the page.
+template <bool MsbTop>
+struct PageLayout {
+    template <int Width>
+    static void UnpackBand(const uint8_t* raw, int band, uint8_t (*rows)[Width / 8], DecoderPath path) {
+        const uint8_t* page = raw + band * Width;
+        switch (path) {
+#ifdef RADSHOT_X86
+        case DecoderPath::AVX2:
+            if (Width % 32 == 0) { UnpackAVX2<Width>(page, rows); return; }
+            // fallthrough
+        case DecoderPath::SSE2:
+            if (Width % 16 == 0) { UnpackSSE2<Width>(page, rows); return; }
+            break;
+#endif
+        default:
+            break;
+        }
+        UnpackScalar<Width>(page, rows);
+    }
+
+    static constexpr int Row(int bit) { return MsbTop ? 7 - bit : bit; }
+
+    template <int Width>
+    static void UnpackScalar(const uint8_t* page, uint8_t (*rows)[Width / 8]) {
+        Unroll<Width / 8>([&](auto g) RADSHOT_INLINE_LAMBDA {
+            constexpr int G = decltype(g)::value;
+            uint64_t x = 0;
+            Unroll<8>([&](auto i) RADSHOT_INLINE_LAMBDA {
+                constexpr int I = decltype(i)::value;
+                x |= (uint64_t)page[G * 8 + I] << (I * 8);
+            });
+            x = Transpose8x8(x);
+            Unroll<8>([&](auto r) RADSHOT_INLINE_LAMBDA {
+                constexpr int R = decltype(r)::value;
+                rows[Row(R)][G] = (uint8_t)(x >> (R * 8));
+            });
+        });
+    }
+
+#ifdef RADSHOT_X86
+    // movemask gathers bit 7 of each byte, so shifting the column bytes left
+    // by (7 - r) yields row r for 16 (SSE2) or 32 (AVX2) columns at once.
+    template <int Width>
+    static void UnpackSSE2(const uint8_t* page, uint8_t (*rows)[Width / 8]) {
+        Unroll<Width / 16>([&](auto c) RADSHOT_INLINE_LAMBDA {
+            constexpr int C = decltype(c)::value;
+            const __m128i v = _mm_loadu_si128((const __m128i*)(page + C * 16));
+            Unroll<8>([&](auto r) RADSHOT_INLINE_LAMBDA {
+                constexpr int R = decltype(r)::value;
+                uint16_t mask = (uint16_t)_mm_movemask_epi8(_mm_slli_epi64(v, 7 - R));
+                memcpy(&rows[Row(R)][C * 2], &mask, 2);
+            });
+        });
+    }
+
+    template <int Width>
+    RADSHOT_TARGET_AVX2 static void UnpackAVX2(const uint8_t* page, uint8_t (*rows)[Width / 8]) {
+        UnrollAVX2<Width / 32>([&](auto c) RADSHOT_AVX2_LAMBDA {
+            constexpr int C = decltype(c)::value;
+            const __m256i v = _mm256_loadu_si256((const __m256i*)(page + C * 32));
+            UnrollAVX2<8>([&](auto r) RADSHOT_AVX2_LAMBDA {
+                constexpr int R = decltype(r)::value;
+                uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_slli_epi64(v, 7 - R));
+                memcpy(&rows[Row(R)][C * 4], &mask, 4);
+            });
+        });
+    }
+#endif
+};
+
+using PageLayoutLsbTop = PageLayout<false>;
+using PageLayoutMsbTop = PageLayout<true>;
+
+// Horizontal rows of Width/8 bytes, leftmost pixel in bit 7 (ST7920 style).
+struct RowLayoutMsbLeft {
+    template <int Width>
+    static void UnpackBand(const uint8_t* raw, int band, uint8_t (*rows)[Width / 8], DecoderPath) {
+        const BitReverseTable& rev = GetBitReverseTable();
+        const uint8_t* src = raw + band * Width;
+        Unroll<8>([&](auto r) RADSHOT_INLINE_LAMBDA {
+            constexpr int R = decltype(r)::value;
+            Unroll<Width / 8>([&](auto g) RADSHOT_INLINE_LAMBDA {
+                constexpr int G = decltype(g)::value;
+                rows[R][G] = rev.v[src[R * (Width / 8) + G]];
+            });
+        });
+    }
+};
+
+// =============================================================================
+// Frame Decoder
+// =============================================================================
+
+template <int Width, int Height, typename Layout, int Scale>
+struct FrameDecoder {
+    static_assert(Width % 8 == 0 && Height % 8 == 0, "Display must be a whole number of 8x8 blocks");
+    static_assert(Scale >= 1, "Scale must be positive");
+
+    static constexpr int WIDTH = Width;
+    static constexpr int HEIGHT = Height;
+    static constexpr int SCALE = Scale;
+    static constexpr int FRAME_BYTES = Width * Height / 8;
+    static constexpr int BANDS = Height / 8;
+    static constexpr int GROUPS = Width / 8;  // 8-pixel groups per row
+    static constexpr int PREVIEW_WIDTH = Width * Scale;
+    static constexpr int PREVIEW_HEIGHT = Height * Scale;
+    static constexpr size_t THUMB_STRIDE = (size_t)Width * 4;
+    static constexpr size_t PREVIEW_STRIDE = THUMB_STRIDE * Scale;
+    static constexpr size_t THUMB_BYTES = THUMB_STRIDE * Height;
+    static constexpr size_t PREVIEW_BYTES = PREVIEW_STRIDE * PREVIEW_HEIGHT;
+
+    // Bands are 8 rows and arrive in order: band b is complete once
+    // (b + 1) * BAND_BYTES bytes of the frame have been received
+    static constexpr int BAND_BYTES = FRAME_BYTES / BANDS;
+    static constexpr size_t BAND_THUMB_BYTES = THUMB_STRIDE * 8;
+    static constexpr size_t BAND_PREVIEW_BYTES = PREVIEW_STRIDE * 8 * Scale;
+
+    // Decodes a raw frame (FRAME_BYTES) into RGBA in the colours of `lut`. rgba_preview is
+    // PREVIEW_WIDTH x PREVIEW_HEIGHT, rgba_thumb is Width x Height. Either may be null.
+    static void Decode(const uint8_t* raw, uint8_t* rgba_preview, uint8_t* rgba_thumb,
+                       const PixelLut& lut = GetPixelLut(), DecoderPath path = ActiveDecoderPath()) {
+        for (int band = 0; band < BANDS; band++) {
+            DecodeBand(raw, band,
+                       rgba_preview ? rgba_preview + band * BAND_PREVIEW_BYTES : nullptr,
+                       rgba_thumb ? rgba_thumb + band * BAND_THUMB_BYTES : nullptr, lut, path);
+        }
+    }
+
+    // Decodes band `band` alone into band-sized RGBA (8 * Scale preview rows, 8 thumbnail
+    // rows). Reads only the frame prefix the band lives in, so it works on a partial frame.
+    static void DecodeBand(const uint8_t* raw, int band, uint8_t* rgba_preview, uint8_t* rgba_thumb,
+                           const PixelLut& lut = GetPixelLut(), DecoderPath path = ActiveDecoderPath()) {
+        uint8_t rows[8][GROUPS];
+        Layout::template UnpackBand<Width>(raw, band, rows, path);
+
+        Unroll<8>([&](auto r) RADSHOT_INLINE_LAMBDA {
+            constexpr int R = decltype(r)::value;
+            uint8_t* thumb_row = rgba_thumb ? rgba_thumb + R * THUMB_STRIDE : nullptr;
+            uint8_t* preview_row = rgba_preview ? rgba_preview + R * Scale * PREVIEW_STRIDE : nullptr;
+            ExpandRow(rows[R], thumb_row, preview_row, lut, path);
+        });
+    }
+
+    // Decodes at any integer scale straight into `rgba`, rows `stride` bytes apart (negative
+    // for a bottom-up image): Width * scale x Height * scale pixels. Each display row is
+    // expanded once into its first output row and the other scale - 1 are copies of it, so
+    // there's no buffer between the frame and the destination.
+    static void DecodeScaled(const uint8_t* raw, int scale, uint8_t* rgba, ptrdiff_t stride,
+                             const PixelLut& lut = GetPixelLut(), DecoderPath path = ActiveDecoderPath()) {
+        const size_t rowBytes = (size_t)Width * scale * 4;
+        for (int band = 0; band < BANDS; band++) {
+            uint8_t rows[8][GROUPS];
+            Layout::template UnpackBand<Width>(raw, band, rows, path);
+            for (int r = 0; r < 8; r++) {
+                uint8_t* row = rgba + (ptrdiff_t)(band * 8 + r) * scale * stride;
+                ExpandRowScaled(rows[r], scale, row, lut, path);
+                for (int i = 1; i < scale; i++) memcpy(row + i * stride, row, rowBytes);
+            }
+        }
+    }
+
+    static void ExpandRowScaled(const uint8_t* bits, int scale, uint8_t* dst, const PixelLut& lut, DecoderPath path) {
+        if (scale == Scale) {
+            // The preview scale has unrolled and vector expansions already
+            switch (path) {
+#ifdef RADSHOT_X86
+            case DecoderPath::AVX2: ExpandRowAVX2(bits, nullptr, dst, lut); return;
+            case DecoderPath::SSE2: ExpandRowSSE2(bits, nullptr, dst, lut); return;
+#endif
+            default: ExpandRowScalar(bits, nullptr, dst, lut); return;
+            }
+        }
+        for (int g = 0; g < GROUPS; g++) {
+            const uint32_t* src = lut.px[bits[g]];
+            if (scale == 1) {
+                memcpy(dst + g * 32, src, 32);
+                continue;
+            }
+            for (int i = 0; i < 8; i++) {
+                for (int k = 0; k < scale; k++) {
+                    memcpy(dst, &src[i], 4);
+                    dst += 4;
+                }
+            }
+        }
+    }
+
+    // One byte per pixel at display size (0 light, 255 dark): the GL_R8 texture format
+    static constexpr size_t INDEX_BYTES = (size_t)Width * Height;
+    static constexpr size_t BAND_INDEX_BYTES = (size_t)Width * 8;
+
+    static void DecodeIndex(const uint8_t* raw, uint8_t* index, DecoderPath path = ActiveDecoderPath()) {
+        for (int band = 0; band < BANDS; band++) {
+            DecodeIndexBand(raw, band, index + band * BAND_INDEX_BYTES, path);
+        }
+    }
+
+    // Band-sized (8 rows) index decode; like DecodeBand it works on a partial frame
+    static void DecodeIndexBand(const uint8_t* raw, int band, uint8_t* index,
+                                DecoderPath path = ActiveDecoderPath()) {
+        uint8_t rows[8][GROUPS];
+        Layout::template UnpackBand<Width>(raw, band, rows, path);
+
+        const IndexLut& lut = GetIndexLut();
+        Unroll<8>([&](auto r) RADSHOT_INLINE_LAMBDA {
+            constexpr int R = decltype(r)::value;
+            Unroll<GROUPS>([&](auto g) RADSHOT_INLINE_LAMBDA {
+                constexpr int G = decltype(g)::value;
+                memcpy(index + R * Width + G * 8, lut.px[rows[R][G]], 8);
+            });
+        });
+    }
+
+    static void ExpandRow(const uint8_t* bits, uint8_t* thumb_row, uint8_t* preview_row, const PixelLut& lut,
+                          DecoderPath path) {
+        switch (path) {
+#ifdef RADSHOT_X86
+        case DecoderPath::AVX2: ExpandRowAVX2(bits, thumb_row, preview_row, lut); break;
+        case DecoderPath::SSE2: ExpandRowSSE2(bits, thumb_row, preview_row, lut); break;
+#endif
+        default: ExpandRowScalar(bits, thumb_row, preview_row, lut); break;
+        }
+        if (preview_row) {
+            // Replicate the expanded row for the remaining Scale - 1 preview rows
+            Unroll<Scale - 1>([&](auto i) RADSHOT_INLINE_LAMBDA {
+                constexpr int I = decltype(i)::value;
+                memcpy(preview_row + (I + 1) * PREVIEW_STRIDE, preview_row, PREVIEW_STRIDE);
+            });
+        }
+    }
+
+    static void ExpandRowScalar(const uint8_t* bits, uint8_t* thumb_row, uint8_t* preview_row, const PixelLut& lut) {
+        if (thumb_row) {
+            Unroll<GROUPS>([&](auto g) RADSHOT_INLINE_LAMBDA {
+                constexpr int G = decltype(g)::value;
+                memcpy(thumb_row + G * 32, lut.px[bits[G]], 32);
+            });
+        }
+        if (preview_row) {
+            uint32_t* dst = (uint32_t*)preview_row;
+            Unroll<GROUPS>([&](auto g) RADSHOT_INLINE_LAMBDA {
+                constexpr int G = decltype(g)::value;
+                const uint32_t* src = lut.px[bits[G]];
+                Unroll<8 * Scale>([&](auto i) RADSHOT_INLINE_LAMBDA {
+                    constexpr int I = decltype(i)::value;
+                    dst[G * 8 * Scale + I] = src[I / Scale];
+                });
+            });
+        }
+    }
+
+#ifdef RADSHOT_X86
+    // Immediate for _mm_shuffle_epi32 producing scaled output register K from
+    // the 4-pixel half that holds its first source pixel.
+    static constexpr int ShuffleImm(int k) {
+        int imm = 0;
+        for (int j = 0; j < 4; j++) imm |= (((k * 4 + j) / Scale) & 3) << (j * 2);
+        return imm;
+    }
+
+    static void ExpandRowSSE2(const uint8_t* bits, uint8_t* thumb_row, uint8_t* preview_row, const PixelLut& lut) {
+        Unroll<GROUPS>([&](auto g) RADSHOT_INLINE_LAMBDA {
+            constexpr int G = decltype(g)::value;
+            const __m128i half[2] = {
+                _mm_load_si128((const __m128i*)lut.px[bits[G]]),
+                _mm_load_si128((const __m128i*)(lut.px[bits[G]] + 4)),
+            };
+            if (thumb_row) {
+                _mm_storeu_si128((__m128i*)(thumb_row + G * 32), half[0]);
+                _mm_storeu_si128((__m128i*)(thumb_row + G * 32 + 16), half[1]);
+            }
+            if (preview_row) {
+                __m128i* dst = (__m128i*)(preview_row + G * 32 * Scale);
+                // Four consecutive scaled pixels never straddle the two halves
+                Unroll<2 * Scale>([&](auto k) RADSHOT_INLINE_LAMBDA {
+                    constexpr int K = decltype(k)::value;
+                    constexpr int IMM = ShuffleImm(K);
+                    _mm_storeu_si128(dst + K, _mm_shuffle_epi32(half[(K * 4 / Scale) / 4], IMM));
+                });
+            }
+        });
+    }
+
+    RADSHOT_TARGET_AVX2
+    static void ExpandRowAVX2(const uint8_t* bits, uint8_t* thumb_row, uint8_t* preview_row, const PixelLut& lut) {
+        const __m256i select = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        const __m256i light = _mm256_set1_epi32((int)lut.light);
+        const __m256i dark = _mm256_set1_epi32((int)lut.dark);
+
+        UnrollAVX2<GROUPS>([&](auto g) RADSHOT_AVX2_LAMBDA {
+            constexpr int G = decltype(g)::value;
+            __m256i v = _mm256_set1_epi32(bits[G]);
+            __m256i set = _mm256_cmpeq_epi32(_mm256_and_si256(v, select), select);
+            __m256i px = _mm256_blendv_epi8(light, dark, set);
+            if (thumb_row) {
+                _mm256_storeu_si256((__m256i*)(thumb_row + G * 32), px);
+            }
+            if (preview_row) {
+                __m256i* dst = (__m256i*)(preview_row + G * 32 * Scale);
+                UnrollAVX2<Scale>([&](auto k) RADSHOT_AVX2_LAMBDA {
+                    constexpr int K = decltype(k)::value;
+                    const __m256i spread = _mm256_setr_epi32(
+                        (K * 8 + 0) / Scale, (K * 8 + 1) / Scale, (K * 8 + 2) / Scale, (K * 8 + 3) / Scale,
+                        (K * 8 + 4) / Scale, (K * 8 + 5) / Scale, (K * 8 + 6) / Scale, (K * 8 + 7) / Scale);
+                    _mm256_storeu_si256(dst + K, _mm256_permutevar8x32_epi32(px, spread));
+                });
+            }
+        });
+    }
+#endif
+};
+
+// =============================================================================
+// RT-4D Display
+// =============================================================================
+
+using Rt4dDecoder = FrameDecoder<128, 64, PageLayoutLsbTop, 4>;
+
+constexpr int DISPLAY_WIDTH = Rt4dDecoder::WIDTH;
+constexpr int DISPLAY_HEIGHT = Rt4dDecoder::HEIGHT;
+constexpr int BITMAP_SIZE = Rt4dDecoder::FRAME_BYTES;
+constexpr int PREVIEW_SCALE = Rt4dDecoder::SCALE;
+
+// Decodes a raw RT-4D frame at any integer scale; see FrameDecoder::DecodeScaled
+inline void DecodeFrameScaled(const uint8_t* raw, int scale, uint8_t* rgba, ptrdiff_t stride,
+                              const PixelLut& lut = GetPixelLut(), DecoderPath path = ActiveDecoderPath()) {
+    Rt4dDecoder::DecodeScaled(raw, scale, rgba, stride, lut, path);
+}
+
+// Decodes a raw RT-4D frame into palette indices, DISPLAY_WIDTH x DISPLAY_HEIGHT bytes
+inline void DecodeFrameIndex(const uint8_t* raw, uint8_t* index, DecoderPath path = ActiveDecoderPath()) {
+    Rt4dDecoder::DecodeIndex(raw, index, path);
+}
+
+inline void DecodeFrameIndexBand(const uint8_t* raw, int band, uint8_t* index,
+                                 DecoderPath path = ActiveDecoderPath()) {
+    Rt4dDecoder::DecodeIndexBand(raw, band, index, path);
+}
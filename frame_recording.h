@@ -0,0 +1,507 @@
+// RadShot - Frame recording
+// Compact container for long captures (timelapses of thousands of frames). Each frame is
+// XORed against the one before it and the residual is run-length coded, so an unchanged
+// screen costs only its chunk header and a typical UI change a few dozen bytes. Every
+// RECORDING_KEYFRAME_INTERVAL frames a keyframe codes the frame itself, which bounds the
+// cost of a seek to one keyframe plus the deltas after it.
+//
+// Layout: header, then a stream of chunks (keyframe, delta or index), then a trailer.
+// Index chunks hold up to RECORDING_INDEX_BLOCK keyframe offsets and link back to the
+// previous one, so the writer never holds more than one block and the reader finds them
+// all from the trailer. A recording cut short by a crash has no trailer; the reader
+// rebuilds the index by scanning and keeps every frame that decodes and checks out.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "frame_decoder.h"
+#include "frame_hash.h"
+#include "session_archive.h"
+
+constexpr char RECORDING_MAGIC[8] = { 'R', 'A', 'D', 'S', 'H', 'R', 'E', 'C' };
+constexpr char RECORDING_END_MAGIC[8] = { 'R', 'S', 'R', 'E', 'C', 'E', 'N', 'D' };
+constexpr uint32_t RECORDING_VERSION = 1;
+constexpr uint32_t RECORDING_KEYFRAME_INTERVAL = 32;   // Frames per keyframe, the longest seek
+constexpr uint32_t RECORDING_INDEX_BLOCK = 256;        // Keyframes per index chunk
+constexpr size_t RECORDING_WRITE_BUFFER = 64 * 1024;
+
+// Worst case for the coder: all literals, one token per 64 bytes
+constexpr size_t RECORDING_MAX_PAYLOAD = BITMAP_SIZE + BITMAP_SIZE / 64;
+
+enum class RecordingChunkType : uint8_t { Key = 1, Delta = 2, Index = 3 };
+
+struct RecordingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t frame_bytes;
+    uint32_t keyframe_interval;
+    uint32_t reserved0;
+    ArchiveTime start;             // Wall clock at the first frame
+    char port[32];                 // Radio it was recorded from
+    uint8_t reserved[56];
+};
+
+struct RecordingChunkHeader {
+    uint8_t type;                  // RecordingChunkType
+    uint8_t reserved;
+    uint16_t size;                 // Payload bytes that follow
+    uint32_t time_ms;              // Since the start of the recording
+    uint32_t check;                // Low half of HashFrame (frames) or HashBytes (index)
+};
+
+struct RecordingIndexEntry {
+    uint32_t frame;
+    uint32_t reserved;
+    uint64_t offset;               // Of the keyframe's chunk header
+};
+
+struct RecordingTrailer {
+    uint64_t index_offset;         // Last index chunk, 0 if there is none
+    uint32_t frames;
+    uint32_t duration_ms;
+    uint32_t keyframes;
+    uint32_t reserved;
+    char magic[8];
+};
+
+static_assert(sizeof(RecordingHeader) == 128, "RecordingHeader layout");
+static_assert(sizeof(RecordingChunkHeader) == 12, "RecordingChunkHeader layout");
+static_assert(sizeof(RecordingIndexEntry) == 16, "RecordingIndexEntry layout");
+static_assert(sizeof(RecordingTrailer) == 32, "RecordingTrailer layout");
+static_assert(RECORDING_MAX_PAYLOAD <= 0xFFFF &&
+              8 + RECORDING_INDEX_BLOCK * sizeof(RecordingIndexEntry) <= 0xFFFF, "Chunk size field");
+
+// =============================================================================
+// Residual coder
+// =============================================================================
+
+// Tokens: 0x00-0x7F  run of 1-128 zero bytes
+//         0x80-0xBF  1-64 literal bytes follow
+//         0xC0-0xFF  run of 3-66 copies of the byte that follows
+// Trailing zeros are not coded; the decoder fills them in. An unchanged frame is empty.
+inline size_t RecordingEncode(const uint8_t* in, uint8_t* out) {
+    size_t end = BITMAP_SIZE;
+    while (end > 0 && in[end - 1] == 0) end--;
+
+    size_t o = 0;
+    size_t i = 0;
+    while (i < end) {
+        if (in[i] == 0) {
+            size_t run = 1;
+            while (i + run < end && run < 128 && in[i + run] == 0) run++;
+            out[o++] = (uint8_t)(run - 1);
+            i += run;
+            continue;
+        }
+        size_t run = 1;
+        while (i + run < end && run < 66 && in[i + run] == in[i]) run++;
+        if (run >= 3) {
+            out[o++] = (uint8_t)(0xC0 | (run - 3));
+            out[o++] = in[i];
+            i += run;
+            continue;
+        }
+        // Literals until a zero pair, a run of three or 64 bytes
+        size_t n = 0;
+        while (i + n < end && n < 64) {
+            const uint8_t* p = in + i + n;
+            size_t left = end - (i + n);
+            if (p[0] == 0 && (left == 1 || p[1] == 0)) break;
+            if (left >= 3 && p[0] == p[1] && p[1] == p[2]) break;
+            n++;
+        }
+        out[o++] = (uint8_t)(0x80 | (n - 1));
+        memcpy(out + o, in + i, n);
+        o += n;
+        i += n;
+    }
+    return o;
+}
+
+// Returns false if the payload is malformed or overruns the frame
+inline bool RecordingDecode(const uint8_t* in, size_t size, uint8_t* out) {
+    size_t o = 0;
+    size_t i = 0;
+    while (i < size) {
+        uint8_t token = in[i++];
+        if (token < 0x80) {
+            size_t run = (size_t)token + 1;
+            if (o + run > BITMAP_SIZE) return false;
+            memset(out + o, 0, run);
+            o += run;
+        } else if (token < 0xC0) {
+            size_t n = (size_t)(token & 0x3F) + 1;
+            if (o + n > BITMAP_SIZE || i + n > size) return false;
+            memcpy(out + o, in + i, n);
+            o += n;
+            i += n;
+        } else {
+            size_t run = (size_t)(token & 0x3F) + 3;
+            if (o + run > BITMAP_SIZE || i >= size) return false;
+            memset(out + o, in[i++], run);
+            o += run;
+        }
+    }
+    memset(out + o, 0, BITMAP_SIZE - o);
+    return true;
+}
+
+inline uint32_t RecordingFrameCheck(const uint8_t* frame) {
+    return (uint32_t)HashFrame(frame);
+}
+
+// =============================================================================
+// Writer
+// =============================================================================
+
+// Streams frames to a recording. Memory stays constant however long it runs: the
+// previous frame, one index block and a write buffer, flushed at every keyframe so a
+// crash loses at most the frames since the last one.
+class RecordingWriter {
+public:
+    ~RecordingWriter() { Close(); }
+
+    // Creates (or overwrites) the recording at `path`
+    bool Open(const char* path, const ArchiveTime& start, const char* port, std::string& error) {
+        Close();
+        if (!file_.Open(path) || !file_.Truncate(0)) {
+            file_.Close();
+            error = "cannot create recording file";
+            return false;
+        }
+        RecordingHeader header = {};
+        memcpy(header.magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+        header.version = RECORDING_VERSION;
+        header.frame_bytes = BITMAP_SIZE;
+        header.keyframe_interval = RECORDING_KEYFRAME_INTERVAL;
+        header.start = start;
+        strncpy(header.port, port, sizeof(header.port) - 1);
+
+        open_ = true;
+        failed_ = false;
+        file_offset_ = 0;
+        buffered_ = 0;
+        frames_ = 0;
+        keyframes_ = 0;
+        last_time_ms_ = 0;
+        index_count_ = 0;
+        last_index_offset_ = 0;
+        Put(&header, sizeof(header));
+        if (!FlushBuffer()) {
+            Close();
+            error = "cannot write recording file";
+            return false;
+        }
+        return true;
+    }
+
+    // Appends the next frame. `time_ms` counts from the start of the recording.
+    bool Append(const uint8_t* frame, uint32_t time_ms) {
+        if (!open_ || failed_) return false;
+
+        bool key = frames_ % RECORDING_KEYFRAME_INTERVAL == 0;
+        if (key) {
+            // Keep everything before the keyframe on disk
+            if (!FlushBuffer()) return false;
+            index_[index_count_].frame = frames_;
+            index_[index_count_].reserved = 0;
+            index_[index_count_].offset = Tell();
+            index_count_++;
+            keyframes_++;
+        }
+
+        const uint8_t* residual = frame;
+        if (!key) {
+            for (int i = 0; i < BITMAP_SIZE; i++) residual_[i] = frame[i] ^ prev_[i];
+            residual = residual_;
+        }
+        size_t size = RecordingEncode(residual, payload_);
+        WriteChunk(key ? RecordingChunkType::Key : RecordingChunkType::Delta, time_ms,
+                   RecordingFrameCheck(frame), payload_, size);
+        memcpy(prev_, frame, BITMAP_SIZE);
+        frames_++;
+        last_time_ms_ = time_ms;
+
+        if (index_count_ == RECORDING_INDEX_BLOCK) WriteIndex();
+        return !failed_;
+    }
+
+    // Writes the index tail and trailer. Returns false if any write failed.
+    bool Close() {
+        if (!open_) return true;
+        if (!failed_) {
+            if (index_count_ > 0) WriteIndex();
+            RecordingTrailer trailer = {};
+            trailer.index_offset = last_index_offset_;
+            trailer.frames = frames_;
+            trailer.duration_ms = last_time_ms_;
+            trailer.keyframes = keyframes_;
+            memcpy(trailer.magic, RECORDING_END_MAGIC, sizeof(RECORDING_END_MAGIC));
+            Put(&trailer, sizeof(trailer));
+            if (FlushBuffer() && !file_.Flush()) failed_ = true;
+        }
+        file_.Close();
+        open_ = false;
+        return !failed_;
+    }
+
+    bool IsOpen() const { return open_; }
+    bool Failed() const { return failed_; }
+    uint32_t Frames() const { return frames_; }
+    uint64_t Bytes() const { return Tell(); }
+
+private:
+    uint64_t Tell() const { return file_offset_ + buffered_; }
+
+    void Put(const void* data, size_t size) {
+        if (buffered_ + size > RECORDING_WRITE_BUFFER && !FlushBuffer()) return;
+        memcpy(buffer_ + buffered_, data, size);
+        buffered_ += size;
+    }
+
+    bool FlushBuffer() {
+        if (failed_) return false;
+        if (buffered_ == 0) return true;
+        if (!file_.WriteAt(file_offset_, buffer_, buffered_)) {
+            failed_ = true;
+            return false;
+        }
+        file_offset_ += buffered_;
+        buffered_ = 0;
+        return true;
+    }
+
+    void WriteChunk(RecordingChunkType type, uint32_t time_ms, uint32_t check, const uint8_t* payload, size_t size) {
+        RecordingChunkHeader chunk = {};
+        chunk.type = (uint8_t)type;
+        chunk.size = (uint16_t)size;
+        chunk.time_ms = time_ms;
+        chunk.check = check;
+        Put(&chunk, sizeof(chunk));
+        Put(payload, size);
+    }
+
+    // Payload: offset of the previous index chunk, then the entries
+    void WriteIndex() {
+        uint8_t payload[8 + RECORDING_INDEX_BLOCK * sizeof(RecordingIndexEntry)];
+        memcpy(payload, &last_index_offset_, 8);
+        memcpy(payload + 8, index_, index_count_ * sizeof(RecordingIndexEntry));
+        size_t size = 8 + index_count_ * sizeof(RecordingIndexEntry);
+        last_index_offset_ = Tell();
+        WriteChunk(RecordingChunkType::Index, last_time_ms_, (uint32_t)HashBytes(payload, size), payload, size);
+        index_count_ = 0;
+    }
+
+    ArchiveFile file_;
+    bool open_ = false;
+    bool failed_ = false;
+    uint64_t file_offset_ = 0;     // Where buffer_ goes
+    size_t buffered_ = 0;
+    uint32_t frames_ = 0;
+    uint32_t keyframes_ = 0;
+    uint32_t last_time_ms_ = 0;
+    uint32_t index_count_ = 0;
+    uint64_t last_index_offset_ = 0;
+
+    uint8_t prev_[BITMAP_SIZE];
+    uint8_t residual_[BITMAP_SIZE];
+    uint8_t payload_[RECORDING_MAX_PAYLOAD];
+    RecordingIndexEntry index_[RECORDING_INDEX_BLOCK];
+    uint8_t buffer_[RECORDING_WRITE_BUFFER];
+};
+
+// =============================================================================
+// Reader
+// =============================================================================
+
+// Random access to a recording's frames. Holds the keyframe index and the last decoded
+// frame, so paging forward costs one delta and any other jump at most one keyframe
+// plus RECORDING_KEYFRAME_INTERVAL - 1 deltas.
+class RecordingReader {
+public:
+    bool Open(const char* path, std::string& error) {
+        Close();
+        if (!file_.Open(path, true)) {
+            error = "cannot open recording";
+            return false;
+        }
+        size_ = file_.Size();
+        if (size_ < sizeof(header_) || !file_.ReadAt(0, &header_, sizeof(header_)) ||
+            memcmp(header_.magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) != 0) {
+            Close();
+            error = "not a RadShot recording";
+            return false;
+        }
+        if (header_.version != RECORDING_VERSION || header_.frame_bytes != BITMAP_SIZE ||
+            header_.keyframe_interval == 0) {
+            Close();
+            error = "unsupported recording version";
+            return false;
+        }
+        if (!LoadIndex()) {
+            // No usable trailer: the recording was cut short
+            recovered_ = true;
+            Scan();
+        }
+        open_ = true;
+        return true;
+    }
+
+    void Close() {
+        file_.Close();
+        open_ = false;
+        keyframes_.clear();
+        frames_ = 0;
+        duration_ms_ = 0;
+        recovered_ = false;
+        current_ = UINT32_MAX;
+    }
+
+    bool IsOpen() const { return open_; }
+    uint32_t Count() const { return frames_; }
+    uint32_t DurationMs() const { return duration_ms_; }
+    uint32_t Keyframes() const { return (uint32_t)keyframes_.size(); }
+    uint64_t FileSize() const { return size_; }
+    const RecordingHeader& Header() const { return header_; }
+    bool Recovered() const { return recovered_; }   // Index rebuilt by scanning
+
+    // Decodes frame `index` into `frame` (BITMAP_SIZE bytes). Returns false past the end
+    // or if the file is damaged there.
+    bool Read(uint32_t index, uint8_t* frame, uint32_t* time_ms = nullptr) {
+        if (index >= frames_) return false;
+        if (current_ == UINT32_MAX || index < current_ || index - current_ > KeyDistance(index)) {
+            // Restart from the nearest keyframe at or before `index`
+            auto it = std::upper_bound(keyframes_.begin(), keyframes_.end(), index,
+                [](uint32_t f, const RecordingIndexEntry& e) { return f < e.frame; });
+            if (it == keyframes_.begin()) return false;
+            --it;
+            current_ = UINT32_MAX;
+            next_offset_ = it->offset;
+            next_frame_ = it->frame;
+        }
+        while (current_ != index) {
+            if (!Step()) {
+                current_ = UINT32_MAX;
+                return false;
+            }
+        }
+        memcpy(frame, frame_, BITMAP_SIZE);
+        if (time_ms) *time_ms = current_time_ms_;
+        return true;
+    }
+
+private:
+    // Frames from the keyframe at or before `index` to `index`
+    uint32_t KeyDistance(uint32_t index) const {
+        return index % header_.keyframe_interval;
+    }
+
+    // Reads a chunk's header and payload. Sizes come from the file, so a damaged one is
+    // refused before anything is read into payload_.
+    bool ReadChunk(uint64_t offset, RecordingChunkHeader& chunk) {
+        if (offset + sizeof(chunk) > size_ || !file_.ReadAt(offset, &chunk, sizeof(chunk))) return false;
+        if (chunk.size > sizeof(payload_) || offset + sizeof(chunk) + chunk.size > size_) return false;
+        if (chunk.type != (uint8_t)RecordingChunkType::Index && chunk.size > RECORDING_MAX_PAYLOAD) return false;
+        return chunk.size == 0 || file_.ReadAt(offset + sizeof(chunk), payload_, chunk.size);
+    }
+
+    // Decodes the frame chunk at next_offset_, skipping index chunks
+    bool Step() {
+        RecordingChunkHeader chunk;
+        for (;;) {
+            if (!ReadChunk(next_offset_, chunk)) return false;
+            current_offset_ = next_offset_;
+            next_offset_ += sizeof(chunk) + chunk.size;
+            if (chunk.type != (uint8_t)RecordingChunkType::Index) break;
+        }
+        bool key = chunk.type == (uint8_t)RecordingChunkType::Key;
+        if (!key && (chunk.type != (uint8_t)RecordingChunkType::Delta || current_ == UINT32_MAX)) return false;
+        if (!RecordingDecode(payload_, chunk.size, residual_)) return false;
+        if (key) {
+            memcpy(frame_, residual_, BITMAP_SIZE);
+        } else {
+            for (int i = 0; i < BITMAP_SIZE; i++) frame_[i] ^= residual_[i];
+        }
+        if (RecordingFrameCheck(frame_) != chunk.check) return false;
+        current_ = next_frame_++;
+        current_time_ms_ = chunk.time_ms;
+        current_key_ = key;
+        return true;
+    }
+
+    // Follows the index chain back from the trailer
+    bool LoadIndex() {
+        RecordingTrailer trailer;
+        if (size_ < sizeof(header_) + sizeof(trailer) ||
+            !file_.ReadAt(size_ - sizeof(trailer), &trailer, sizeof(trailer)) ||
+            memcmp(trailer.magic, RECORDING_END_MAGIC, sizeof(RECORDING_END_MAGIC)) != 0) {
+            return false;
+        }
+        std::vector<RecordingIndexEntry> index;
+        index.reserve(trailer.keyframes);
+        uint64_t offset = trailer.index_offset;
+        RecordingChunkHeader chunk;
+        while (offset != 0) {
+            if (offset < sizeof(header_) || !ReadChunk(offset, chunk) ||
+                chunk.type != (uint8_t)RecordingChunkType::Index || chunk.size < 8 ||
+                (chunk.size - 8) % sizeof(RecordingIndexEntry) != 0 ||
+                (uint32_t)HashBytes(payload_, chunk.size) != chunk.check) {
+                return false;
+            }
+            size_t n = (chunk.size - 8) / sizeof(RecordingIndexEntry);
+            const RecordingIndexEntry* entries = (const RecordingIndexEntry*)(payload_ + 8);
+            index.insert(index.begin(), entries, entries + n);   // Blocks come newest first
+            memcpy(&offset, payload_, 8);
+        }
+        if (index.size() != trailer.keyframes) return false;
+        keyframes_.swap(index);
+        frames_ = trailer.frames;
+        duration_ms_ = trailer.duration_ms;
+        return true;
+    }
+
+    // Decodes every chunk from the start, indexing keyframes, until the data runs out
+    // or stops checking out
+    void Scan() {
+        keyframes_.clear();
+        frames_ = 0;
+        current_ = UINT32_MAX;
+        next_offset_ = sizeof(header_);
+        next_frame_ = 0;
+        while (Step()) {
+            if (current_key_) {
+                RecordingIndexEntry entry = { current_, 0, current_offset_ };
+                keyframes_.push_back(entry);
+            }
+            frames_ = current_ + 1;
+            duration_ms_ = current_time_ms_;
+        }
+        current_ = UINT32_MAX;
+    }
+
+    ArchiveFile file_;
+    bool open_ = false;
+    uint64_t size_ = 0;
+    RecordingHeader header_ = {};
+    std::vector<RecordingIndexEntry> keyframes_;
+    uint32_t frames_ = 0;
+    uint32_t duration_ms_ = 0;
+    bool recovered_ = false;
+
+    // Decode position
+    uint32_t current_ = UINT32_MAX;   // Frame held in frame_, UINT32_MAX if none
+    uint32_t current_time_ms_ = 0;
+    uint64_t current_offset_ = 0;     // Of current_'s chunk
+    bool current_key_ = false;
+    uint32_t next_frame_ = 0;
+    uint64_t next_offset_ = 0;
+    uint8_t frame_[BITMAP_SIZE];
+    uint8_t residual_[BITMAP_SIZE];
+    uint8_t payload_[8 + RECORDING_INDEX_BLOCK * sizeof(RecordingIndexEntry)];
+};
@@ -0,0 +1,58 @@
+// RadShot - Palettes
+// The LCD is two colours, so a palette is just those two. Nothing on screen is re-decoded
+// for another palette (the palette shader recolours textures at draw time), and exports
+// that need pixels decode through a byte -> 8 pixels table (MakePixelLut) in a single pass
+// with no per-pixel branching; the clipboard's tables are built once per preset.
+// Portable header (no Win32 dependencies).
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "frame_decoder.h"
+
+struct PalettePreset {
+    const char* name;
+    uint8_t light[4];   // RGBA for clear pixels
+    uint8_t dark[4];    // RGBA for set pixels
+};
+
+constexpr PalettePreset PALETTE_PRESETS[] = {
+    { "Original",      { COLOR_LIGHT[0], COLOR_LIGHT[1], COLOR_LIGHT[2], COLOR_LIGHT[3] },
+                       { COLOR_DARK[0], COLOR_DARK[1], COLOR_DARK[2], COLOR_DARK[3] } },
+    { "Green LCD",     { 0x9B, 0xBC, 0x0F, 0xFF }, { 0x0F, 0x38, 0x0F, 0xFF } },
+    { "Inverted",      { COLOR_DARK[0], COLOR_DARK[1], COLOR_DARK[2], COLOR_DARK[3] },
+                       { COLOR_LIGHT[0], COLOR_LIGHT[1], COLOR_LIGHT[2], COLOR_LIGHT[3] } },
+    { "High Contrast", { 0xFF, 0xFF, 0xFF, 0xFF }, { 0x00, 0x00, 0x00, 0xFF } },
+    // White under the alpha so formats without one (the clipboard's DIB) get a white background
+    { "Transparent",   { 0xFF, 0xFF, 0xFF, 0x00 }, { 0x00, 0x00, 0x00, 0xFF } },
+};
+
+constexpr int PALETTE_COUNT = (int)(sizeof(PALETTE_PRESETS) / sizeof(PALETTE_PRESETS[0]));
+
+// Pixel table for preset `index` in the clipboard DIB's BGRX: red and blue swapped and
+// opaque, as BI_RGB has no alpha. All of them are built on first use (8 KB each).
+inline const PixelLut& GetPaletteBgrxLut(int index) {
+    struct Tables {
+        PixelLut luts[PALETTE_COUNT];
+        Tables() {
+            for (int i = 0; i < PALETTE_COUNT; i++) {
+                const PalettePreset& preset = PALETTE_PRESETS[i];
+                const uint8_t light[4] = { preset.light[2], preset.light[1], preset.light[0], 0xFF };
+                const uint8_t dark[4] = { preset.dark[2], preset.dark[1], preset.dark[0], 0xFF };
+                luts[i] = MakePixelLut(light, dark);
+            }
+        }
+    };
+    static const Tables tables;
+    return tables.luts[index >= 0 && index < PALETTE_COUNT ? index : 0];
+}
+
+// Preset index by name, -1 if there's none
+inline int FindPalette(const char* name) {
+    for (int i = 0; i < PALETTE_COUNT; i++) {
+        if (strcmp(PALETTE_PRESETS[i].name, name) == 0) return i;
+    }
+    return -1;
+}
@@ -0,0 +1,267 @@
+// RadShot - Palette shader
+// Screenshot textures are single channel (GL_R8, see DecodeFrameIndex): 0 where an LCD
+// pixel is clear, 255 where it is set. The two colours are applied when drawing by a
+// shader that stands in for ImGui's own between two draw-list callbacks, so a texture is
+// a quarter the size of RGBA and a palette change doesn't touch any texture.
+//
+// The shader is ImGui's with one line changed in the fragment stage, written for the same
+// GLSL version string ImGui_ImplOpenGL3_Init is given. It's linked the first time it's
+// used, from inside a callback, so it can take its attribute locations and projection
+// from the ImGui program that is current at that point. If it can't be built, ImGui's
+// own shader draws the textures; SetTextureSwizzle makes that a greyscale negative.
+// Portable header: include after the platform's GL header. GL 2.0+ entry points are
+// looked up through the caller's function (wglGetProcAddress, eglGetProcAddress).
+// tests/palette_shader_test.cpp renders through it headlessly.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+#ifndef GL_RED
+#define GL_RED 0x1903
+#endif
+#ifndef GL_R8
+#define GL_R8 0x8229
+#endif
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#endif
+#ifndef GL_VERTEX_SHADER
+#define GL_VERTEX_SHADER 0x8B31
+#endif
+#ifndef GL_COMPILE_STATUS
+#define GL_COMPILE_STATUS 0x8B81
+#endif
+#ifndef GL_LINK_STATUS
+#define GL_LINK_STATUS 0x8B82
+#endif
+#ifndef GL_CURRENT_PROGRAM
+#define GL_CURRENT_PROGRAM 0x8B8D
+#endif
+#ifndef GL_TEXTURE_SWIZZLE_RGBA
+#define GL_TEXTURE_SWIZZLE_RGBA 0x8E46
+#endif
+
+// For a screenshot texture, while bound to GL_TEXTURE_2D: reads the index into all three
+// colour channels, so that without the palette shader it draws as a grey negative rather
+// than in red.
+// GL 3.3 or ARB_texture_swizzle; older drivers ignore it.
+inline void SetTextureSwizzle() {
+    static const GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+}
+
+class PaletteShader {
+public:
+    typedef void* (*ProcLookup)(const char* name);
+
+    // Looks up the GL entry points; call once the context is current. `glslVersion` is
+    // the string given to ImGui_ImplOpenGL3_Init (null for its default, "#version 130").
+    bool Load(ProcLookup lookup, const char* glslVersion = nullptr) {
+        glsl_version_ = glslVersion ? glslVersion : "#version 130";
+        bool ok = true;
+        ok &= Get(lookup, "glCreateShader", gl_.CreateShader);
+        ok &= Get(lookup, "glShaderSource", gl_.ShaderSource);
+        ok &= Get(lookup, "glCompileShader", gl_.CompileShader);
+        ok &= Get(lookup, "glGetShaderiv", gl_.GetShaderiv);
+        ok &= Get(lookup, "glGetShaderInfoLog", gl_.GetShaderInfoLog);
+        ok &= Get(lookup, "glDeleteShader", gl_.DeleteShader);
+        ok &= Get(lookup, "glCreateProgram", gl_.CreateProgram);
+        ok &= Get(lookup, "glAttachShader", gl_.AttachShader);
+        ok &= Get(lookup, "glBindAttribLocation", gl_.BindAttribLocation);
+        ok &= Get(lookup, "glLinkProgram", gl_.LinkProgram);
+        ok &= Get(lookup, "glGetProgramiv", gl_.GetProgramiv);
+        ok &= Get(lookup, "glGetProgramInfoLog", gl_.GetProgramInfoLog);
+        ok &= Get(lookup, "glDeleteProgram", gl_.DeleteProgram);
+        ok &= Get(lookup, "glUseProgram", gl_.UseProgram);
+        ok &= Get(lookup, "glGetAttribLocation", gl_.GetAttribLocation);
+        ok &= Get(lookup, "glGetUniformLocation", gl_.GetUniformLocation);
+        ok &= Get(lookup, "glGetUniformfv", gl_.GetUniformfv);
+        ok &= Get(lookup, "glUniform1i", gl_.Uniform1i);
+        ok &= Get(lookup, "glUniform4fv", gl_.Uniform4fv);
+        ok &= Get(lookup, "glUniformMatrix4fv", gl_.UniformMatrix4fv);
+        failed_ = !ok;
+        if (!ok) error_ = "OpenGL 2.0 shader functions not available";
+        return ok;
+    }
+
+    // RGBA colours for index 0 (clear) and 255 (set)
+    void SetColors(const uint8_t* light, const uint8_t* dark) {
+        for (int i = 0; i < 4; i++) {
+            light_[i] = light[i] / 255.0f;
+            dark_[i] = dark[i] / 255.0f;
+        }
+    }
+
+    // Call from an ImDrawList callback: switches from ImGui's program to this one until
+    // the next ImDrawCallback_ResetRenderState. Does nothing if the shader can't be built.
+    void Use() {
+        if (failed_ || !gl_.UseProgram) return;
+        int imguiProgram = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &imguiProgram);
+        if (imguiProgram == 0) return;
+        if (!program_ && !Build((unsigned)imguiProgram)) return;
+
+        float projection[16];
+        gl_.GetUniformfv((unsigned)imguiProgram, gl_.GetUniformLocation((unsigned)imguiProgram, "ProjMtx"), projection);
+        gl_.UseProgram(program_);
+        gl_.UniformMatrix4fv(loc_projection_, 1, 0, projection);
+        gl_.Uniform1i(loc_texture_, 0);
+        gl_.Uniform4fv(loc_light_, 1, light_);
+        gl_.Uniform4fv(loc_dark_, 1, dark_);
+    }
+
+    void Destroy() {
+        if (program_) gl_.DeleteProgram(program_);
+        program_ = 0;
+    }
+
+    // Set once the shader can't be built; textures then draw without the palette
+    bool Failed() const { return failed_; }
+    const std::string& Error() const { return error_; }
+
+private:
+    struct Functions {
+        unsigned (APIENTRY* CreateShader)(unsigned type);
+        void (APIENTRY* ShaderSource)(unsigned shader, int count, const char* const* source, const int* length);
+        void (APIENTRY* CompileShader)(unsigned shader);
+        void (APIENTRY* GetShaderiv)(unsigned shader, unsigned pname, int* params);
+        void (APIENTRY* GetShaderInfoLog)(unsigned shader, int size, int* length, char* log);
+        void (APIENTRY* DeleteShader)(unsigned shader);
+        unsigned (APIENTRY* CreateProgram)();
+        void (APIENTRY* AttachShader)(unsigned program, unsigned shader);
+        void (APIENTRY* BindAttribLocation)(unsigned program, unsigned index, const char* name);
+        void (APIENTRY* LinkProgram)(unsigned program);
+        void (APIENTRY* GetProgramiv)(unsigned program, unsigned pname, int* params);
+        void (APIENTRY* GetProgramInfoLog)(unsigned program, int size, int* length, char* log);
+        void (APIENTRY* DeleteProgram)(unsigned program);
+        void (APIENTRY* UseProgram)(unsigned program);
+        int (APIENTRY* GetAttribLocation)(unsigned program, const char* name);
+        int (APIENTRY* GetUniformLocation)(unsigned program, const char* name);
+        void (APIENTRY* GetUniformfv)(unsigned program, int location, float* params);
+        void (APIENTRY* Uniform1i)(int location, int v0);
+        void (APIENTRY* Uniform4fv)(int location, int count, const float* value);
+        void (APIENTRY* UniformMatrix4fv)(int location, int count, unsigned char transpose, const float* value);
+    };
+
+    template <typename F>
+    static bool Get(ProcLookup lookup, const char* name, F& fn) {
+        fn = (F)lookup(name);
+        return fn != nullptr;
+    }
+
+    // `prelude` maps the source's IN/OUT/TEXTURE onto the GLSL version in use
+    unsigned Compile(unsigned type, const char* prelude, const char* source) {
+        const char* sources[] = { glsl_version_.c_str(), "\n", prelude, source };
+        unsigned shader = gl_.CreateShader(type);
+        gl_.ShaderSource(shader, 4, sources, nullptr);
+        gl_.CompileShader(shader);
+        int ok = 0;
+        gl_.GetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            char log[512] = {0};
+            gl_.GetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            error_ = log;
+            gl_.DeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    // Links against ImGui's attribute locations, so its vertex layout feeds this program too
+    bool Build(unsigned imguiProgram) {
+        static const char* VERTEX =
+            "uniform mat4 ProjMtx;\n"
+            "IN vec2 Position;\n"
+            "IN vec2 UV;\n"
+            "IN vec4 Color;\n"
+            "OUT vec2 Frag_UV;\n"
+            "OUT vec4 Frag_Color;\n"
+            "void main() {\n"
+            "    Frag_UV = UV;\n"
+            "    Frag_Color = Color;\n"
+            "    gl_Position = ProjMtx * vec4(Position.xy, 0, 1);\n"
+            "}\n";
+        static const char* FRAGMENT =
+            "uniform sampler2D Texture;\n"
+            "uniform vec4 Light;\n"
+            "uniform vec4 Dark;\n"
+            "IN vec2 Frag_UV;\n"
+            "IN vec4 Frag_Color;\n"
+            "void main() {\n"
+            "    Out_Color = Frag_Color * mix(Light, Dark, TEXTURE(Texture, Frag_UV.st).r);\n"
+            "}\n";
+
+        // GLSL 1.30 and ES 3.00 on use in/out; before that, attribute/varying and the
+        // built-in output. ES also needs a default float precision.
+        int version = atoi(glsl_version_.c_str() + strlen("#version"));
+        bool es = strstr(glsl_version_.c_str(), " es") != nullptr;
+        bool modern = es ? version >= 300 : version >= 130;
+        std::string vertexPrelude = modern ? "#define IN in\n#define OUT out\n"
+                                           : "#define IN attribute\n#define OUT varying\n";
+        std::string fragmentPrelude = es ? "precision mediump float;\n" : "";
+        fragmentPrelude += modern ? "#define IN in\n#define TEXTURE texture\nout vec4 Out_Color;\n"
+                                  : "#define IN varying\n#define TEXTURE texture2D\n#define Out_Color gl_FragColor\n";
+
+        failed_ = true;
+        unsigned vertex = Compile(GL_VERTEX_SHADER, vertexPrelude.c_str(), VERTEX);
+        if (!vertex) return false;
+        unsigned fragment = Compile(GL_FRAGMENT_SHADER, fragmentPrelude.c_str(), FRAGMENT);
+        if (!fragment) {
+            gl_.DeleteShader(vertex);
+            return false;
+        }
+
+        unsigned program = gl_.CreateProgram();
+        gl_.AttachShader(program, vertex);
+        gl_.AttachShader(program, fragment);
+        const char* attributes[] = { "Position", "UV", "Color" };
+        for (const char* name : attributes) {
+            int location = gl_.GetAttribLocation(imguiProgram, name);
+            if (location >= 0) gl_.BindAttribLocation(program, (unsigned)location, name);
+        }
+        gl_.LinkProgram(program);
+        gl_.DeleteShader(vertex);
+        gl_.DeleteShader(fragment);
+
+        int ok = 0;
+        gl_.GetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok) {
+            char log[512] = {0};
+            gl_.GetProgramInfoLog(program, sizeof(log), nullptr, log);
+            error_ = log;
+            gl_.DeleteProgram(program);
+            return false;
+        }
+
+        program_ = program;
+        loc_projection_ = gl_.GetUniformLocation(program, "ProjMtx");
+        loc_texture_ = gl_.GetUniformLocation(program, "Texture");
+        loc_light_ = gl_.GetUniformLocation(program, "Light");
+        loc_dark_ = gl_.GetUniformLocation(program, "Dark");
+        failed_ = false;
+        return true;
+    }
+
+    Functions gl_ = {};
+    std::string glsl_version_;
+    bool failed_ = false;
+    std::string error_;
+    unsigned program_ = 0;
+    int loc_projection_ = -1;
+    int loc_texture_ = -1;
+    int loc_light_ = -1;
+    int loc_dark_ = -1;
+    float light_[4] = { 1, 1, 1, 1 };
+    float dark_[4] = { 0, 0, 0, 1 };
+};
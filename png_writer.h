@@ -0,0 +1,129 @@
+// RadShot - Indexed PNG writer
+// A screenshot is two colours, so it's saved as what it is: a bit depth 1 image with a
+// 2-entry PLTE (plus tRNS when a colour isn't opaque), packed straight from the LCD frame
+// at any integer scale. Compared with 8-bit RGBA that is 1/32 of the data to filter and
+// compress. Every row uses filter None, which is what suits sub-byte palette images, and
+// the scale - 1 repeats of a row are copies that deflate turns into one back-reference.
+// Portable header. Compression is stb_image_write's zlib (its implementation is compiled
+// into radshot.cpp, and tests/stb_image_write.cpp for the tests).
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "frame_decoder.h"
+
+extern "C" unsigned char* stbi_zlib_compress(unsigned char* data, int data_len, int* out_len, int quality);
+
+constexpr int PNG_ZLIB_QUALITY = 8;   // stb_image_write's default for its own PNGs
+
+struct PngCrcTable {
+    uint32_t v[256];
+};
+
+constexpr PngCrcTable MakePngCrcTable() {
+    PngCrcTable t{};
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        t.v[n] = c;
+    }
+    return t;
+}
+
+inline uint32_t PngCrc(const uint8_t* data, size_t size) {
+    static constexpr PngCrcTable table = MakePngCrcTable();
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) c = table.v[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+inline void PngPut32(std::vector<uint8_t>& out, uint32_t v) {
+    uint8_t b[4] = { (uint8_t)(v >> 24), (uint8_t)(v >> 16), (uint8_t)(v >> 8), (uint8_t)v };
+    out.insert(out.end(), b, b + 4);
+}
+
+inline void PngChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size) {
+    PngPut32(out, (uint32_t)size);
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (size) out.insert(out.end(), data, data + size);
+    PngPut32(out, PngCrc(out.data() + start, size + 4));
+}
+
+// Encodes `raw` (BITMAP_SIZE bytes) as a DISPLAY_WIDTH * scale x DISPLAY_HEIGHT * scale
+// indexed PNG into `png`: index 0 is `light`, 1 is `dark` (RGBA). `png` is reused, so a
+// batch allocates once.
+inline bool EncodeIndexedPng(const uint8_t* raw, int scale, const uint8_t* light, const uint8_t* dark,
+                             std::vector<uint8_t>& png) {
+    const int width = DISPLAY_WIDTH * scale;
+    const int height = DISPLAY_HEIGHT * scale;
+    const size_t rowBytes = 1 + ((size_t)width + 7) / 8;   // Filter byte + packed pixels
+
+    uint8_t index[Rt4dDecoder::INDEX_BYTES];
+    DecodeFrameIndex(raw, index);
+
+    // Each LCD row is packed once (MSB is the leftmost pixel) and copied for the rest
+    std::vector<uint8_t> rows(rowBytes * height);
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        uint8_t* row = &rows[(size_t)y * scale * rowBytes];
+        row[0] = 0;   // Filter None
+        uint32_t acc = 0;
+        int bits = 0;
+        size_t out = 1;
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            uint32_t bit = index[y * DISPLAY_WIDTH + x] ? 1 : 0;
+            for (int k = 0; k < scale; k++) {
+                acc = (acc << 1) | bit;
+                if (++bits == 8) {
+                    row[out++] = (uint8_t)acc;
+                    acc = 0;
+                    bits = 0;
+                }
+            }
+        }
+        if (bits) row[out] = (uint8_t)(acc << (8 - bits));
+        for (int i = 1; i < scale; i++) memcpy(row + i * rowBytes, row, rowBytes);
+    }
+
+    int zlibSize = 0;
+    unsigned char* zlib = stbi_zlib_compress(rows.data(), (int)rows.size(), &zlibSize, PNG_ZLIB_QUALITY);
+    if (!zlib) return false;
+
+    static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    png.assign(SIGNATURE, SIGNATURE + 8);
+
+    uint8_t ihdr[13] = {
+        (uint8_t)(width >> 24), (uint8_t)(width >> 16), (uint8_t)(width >> 8), (uint8_t)width,
+        (uint8_t)(height >> 24), (uint8_t)(height >> 16), (uint8_t)(height >> 8), (uint8_t)height,
+        1,   // Bit depth
+        3,   // Colour type: indexed
+        0, 0, 0,   // Deflate, adaptive filtering, no interlace
+    };
+    PngChunk(png, "IHDR", ihdr, sizeof(ihdr));
+    uint8_t plte[6] = { light[0], light[1], light[2], dark[0], dark[1], dark[2] };
+    PngChunk(png, "PLTE", plte, sizeof(plte));
+    if (light[3] != 0xFF || dark[3] != 0xFF) {
+        uint8_t trns[2] = { light[3], dark[3] };
+        PngChunk(png, "tRNS", trns, sizeof(trns));
+    }
+    PngChunk(png, "IDAT", zlib, (size_t)zlibSize);
+    PngChunk(png, "IEND", nullptr, 0);
+    free(zlib);
+    return true;
+}
+
+// EncodeIndexedPng to a file; `png` is the encode buffer, reusable across calls
+inline bool WriteIndexedPng(const char* path, const uint8_t* raw, int scale, const uint8_t* light,
+                            const uint8_t* dark, std::vector<uint8_t>& png) {
+    if (!EncodeIndexedPng(raw, scale, light, dark, png)) return false;
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(png.data(), 1, png.size(), f) == png.size();
+    ok &= fclose(f) == 0;
+    return ok;
+}
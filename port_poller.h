@@ -0,0 +1,174 @@
+// RadShot - Port poller
+// Waits on many serial transports from one thread: epoll on Linux,
+// WaitForMultipleObjects on Windows, poll() on other POSIX systems.
+// Handles come from ISerialTransport::GetWaitHandle(); each is registered with a key
+// that Wait() reports back when the handle is ready.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "serial_transport.h"
+
+#if !defined(_WIN32) && defined(__linux__)
+#define RADSHOT_POLLER_EPOLL 1
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+class PortPoller {
+public:
+#ifdef _WIN32
+    // One slot is taken by the wake event
+    static constexpr int MAX_HANDLES = MAXIMUM_WAIT_OBJECTS - 1;
+#else
+    static constexpr int MAX_HANDLES = 1024;
+#endif
+
+    PortPoller() {
+#ifdef _WIN32
+        wake_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+#elif defined(RADSHOT_POLLER_EPOLL)
+        epoll_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = WAKE_KEY;
+        epoll_ctl(epoll_, EPOLL_CTL_ADD, wake_, &ev);
+#else
+        if (pipe(wake_pipe_) == 0) {
+            fcntl(wake_pipe_[0], F_SETFL, O_NONBLOCK);
+            fcntl(wake_pipe_[1], F_SETFL, O_NONBLOCK);
+        } else {
+            wake_pipe_[0] = wake_pipe_[1] = -1;
+        }
+#endif
+    }
+
+    ~PortPoller() {
+#ifdef _WIN32
+        CloseHandle(wake_);
+#elif defined(RADSHOT_POLLER_EPOLL)
+        close(wake_);
+        close(epoll_);
+#else
+        if (wake_pipe_[0] >= 0) close(wake_pipe_[0]);
+        if (wake_pipe_[1] >= 0) close(wake_pipe_[1]);
+#endif
+    }
+
+    PortPoller(const PortPoller&) = delete;
+    PortPoller& operator=(const PortPoller&) = delete;
+
+    bool Add(WaitHandle handle, int key) {
+        if (handle == INVALID_WAIT_HANDLE || (int)entries_.size() >= MAX_HANDLES) return false;
+#if defined(RADSHOT_POLLER_EPOLL)
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = (uint32_t)key;
+        if (epoll_ctl(epoll_, EPOLL_CTL_ADD, handle, &ev) != 0) return false;
+#endif
+        entries_.push_back({ handle, key });
+        return true;
+    }
+
+    void Remove(WaitHandle handle) {
+        for (size_t i = 0; i < entries_.size(); i++) {
+            if (entries_[i].handle != handle) continue;
+#if defined(RADSHOT_POLLER_EPOLL)
+            epoll_ctl(epoll_, EPOLL_CTL_DEL, handle, nullptr);
+#endif
+            entries_.erase(entries_.begin() + i);
+            return;
+        }
+    }
+
+    // Waits up to timeout_ms for any handle (or Wake()) and appends the keys of ready
+    // handles to `ready`. Returns false if the wait itself failed.
+    bool Wait(uint32_t timeout_ms, std::vector<int>& ready) {
+#ifdef _WIN32
+        HANDLE handles[MAXIMUM_WAIT_OBJECTS];
+        handles[0] = wake_;
+        for (size_t i = 0; i < entries_.size(); i++) handles[i + 1] = entries_[i].handle;
+        DWORD count = (DWORD)entries_.size() + 1;
+
+        DWORD wait = WaitForMultipleObjects(count, handles, FALSE, timeout_ms);
+        if (wait == WAIT_TIMEOUT || wait == WAIT_OBJECT_0) return true;
+        if (wait == WAIT_FAILED || wait >= WAIT_OBJECT_0 + count) return false;
+
+        // Only the lowest signalled index is reported; check the rest without blocking
+        for (DWORD i = wait - WAIT_OBJECT_0; i < count; i++) {
+            if (i == 0) continue;
+            if (i == wait - WAIT_OBJECT_0 || WaitForSingleObject(handles[i], 0) == WAIT_OBJECT_0) {
+                ready.push_back(entries_[i - 1].key);
+            }
+        }
+        return true;
+#elif defined(RADSHOT_POLLER_EPOLL)
+        epoll_event events[64];
+        int n = epoll_wait(epoll_, events, 64, (int)timeout_ms);
+        if (n < 0) return errno == EINTR;
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.u64 == WAKE_KEY) {
+                uint64_t drain;
+                ssize_t ignored = read(wake_, &drain, sizeof(drain));
+                (void)ignored;
+                continue;
+            }
+            ready.push_back((int)events[i].data.u64);
+        }
+        return true;
+#else
+        std::vector<pollfd> pfds;
+        pfds.reserve(entries_.size() + 1);
+        pfds.push_back({ wake_pipe_[0], POLLIN, 0 });
+        for (const Entry& e : entries_) pfds.push_back({ e.handle, POLLIN, 0 });
+
+        int n = poll(pfds.data(), (nfds_t)pfds.size(), (int)timeout_ms);
+        if (n < 0) return errno == EINTR;
+        if (pfds[0].revents & POLLIN) {
+            char drain[16];
+            while (read(wake_pipe_[0], drain, sizeof(drain)) > 0) {}
+        }
+        for (size_t i = 1; i < pfds.size(); i++) {
+            if (pfds[i].revents) ready.push_back(entries_[i - 1].key);
+        }
+        return true;
+#endif
+    }
+
+    // Makes a blocked Wait() return early. Safe to call from any thread.
+    void Wake() {
+#ifdef _WIN32
+        SetEvent(wake_);
+#elif defined(RADSHOT_POLLER_EPOLL)
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_, &one, sizeof(one));
+        (void)ignored;
+#else
+        if (wake_pipe_[1] >= 0) {
+            char c = 0;
+            ssize_t ignored = write(wake_pipe_[1], &c, 1);
+            (void)ignored;
+        }
+#endif
+    }
+
+private:
+    struct Entry {
+        WaitHandle handle;
+        int key;
+    };
+
+    std::vector<Entry> entries_;
+#ifdef _WIN32
+    HANDLE wake_ = nullptr;
+#elif defined(RADSHOT_POLLER_EPOLL)
+    static constexpr uint64_t WAKE_KEY = ~0ull;
+    int epoll_ = -1;
+    int wake_ = -1;
+#else
+    int wake_pipe_[2];
+#endif
+};
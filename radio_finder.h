@@ -0,0 +1,146 @@
+// RadShot - Radio finder
+// Finds screenshot-capable radios among the serial ports. Every candidate is opened at
+// once and sent one screenshot request; RunProbes collects the responses in one PortPoller
+// loop, so the whole search takes one capture timeout however many ports there are.
+// Ports are ranked valid frame first, then by response latency.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "baud_probe.h"
+#include "port_poller.h"
+#include "serial_transport.h"
+
+struct PortProbeResult {
+    std::string port;
+    uint32_t baud;
+    ProbeOutcome outcome;
+    int bytes;                 // Response bytes received, tail included
+    uint32_t latency_ms;       // Request -> first response byte (valid when bytes > 0)
+    uint32_t elapsed_ms;       // Request -> outcome decided
+};
+
+// Best first: valid frames by latency, then ports that answered with something,
+// then silent ones, then ports that could not be opened
+inline bool ProbeResultBefore(const PortProbeResult& a, const PortProbeResult& b) {
+    auto rank = [](ProbeOutcome outcome) {
+        switch (outcome) {
+        case ProbeOutcome::Frame:      return 0;
+        case ProbeOutcome::BadFrame:   return 1;
+        case ProbeOutcome::NoResponse: return 2;
+        default:                       return 3;
+        }
+    };
+    if (rank(a.outcome) != rank(b.outcome)) return rank(a.outcome) < rank(b.outcome);
+    if (a.outcome == ProbeOutcome::Frame && a.latency_ms != b.latency_ms) return a.latency_ms < b.latency_ms;
+    return a.port < b.port;
+}
+
+// Probes every (port, baud) pair concurrently from the calling thread (see RunProbes) and
+// returns the results ranked. `poller` is supplied by the caller so another thread can
+// Wake() it after setting `cancel`.
+inline std::vector<PortProbeResult> ProbePorts(
+        const std::vector<std::pair<std::string, uint32_t>>& ports,
+        const std::function<std::unique_ptr<ISerialTransport>()>& factory,
+        PortPoller& poller, const std::atomic<bool>* cancel = nullptr) {
+    std::vector<PortProbeResult> results(ports.size());
+    std::vector<std::unique_ptr<ISerialTransport>> transports;
+    std::vector<ProbeRequest> requests;
+    std::vector<size_t> requested;   // Port of each request
+
+    // Open everything first, so the requests go out back to back
+    for (size_t i = 0; i < ports.size(); i++) {
+        results[i] = { ports[i].first, ports[i].second, ProbeOutcome::OpenFailed, 0, 0, 0 };
+        std::unique_ptr<ISerialTransport> transport = factory();
+        if (!transport || !transport->Open(ports[i].first.c_str(), ports[i].second)) continue;
+        ProbeRequest request = {};
+        request.transport = transport.get();
+        request.baud = ports[i].second;
+        requests.push_back(request);
+        requested.push_back(i);
+        transports.push_back(std::move(transport));
+    }
+
+    RunProbes(requests, poller, cancel);
+    for (size_t r = 0; r < requests.size(); r++) {
+        PortProbeResult& result = results[requested[r]];
+        result.outcome = requests[r].outcome;
+        result.bytes = requests[r].bytes;
+        result.latency_ms = requests[r].latency_ms;
+        result.elapsed_ms = requests[r].elapsed_ms;
+    }
+
+    std::stable_sort(results.begin(), results.end(), ProbeResultBefore);
+    return results;
+}
+
+// Runs ProbePorts on a background thread, like BaudProber.
+// The UI polls IsDone() and reads Results() once it returns true.
+class RadioFinder {
+public:
+    using TransportFactory = BaudProber::TransportFactory;
+
+    ~RadioFinder() { Cancel(); }
+
+    // `ports` pairs each port with the baud rate to try it at
+    bool Start(std::vector<std::pair<std::string, uint32_t>> ports,
+               TransportFactory factory = CreatePlatformTransport) {
+        Cancel();
+        if (ports.empty() || !factory) return false;
+
+        ports_ = std::move(ports);
+        factory_ = std::move(factory);
+        results_.clear();
+        cancel_ = false;
+        done_ = false;
+        thread_ = std::thread(&RadioFinder::Run, this);
+        return true;
+    }
+
+    // Stops the search and waits for the thread; every port is closed afterwards
+    void Cancel() {
+        if (thread_.joinable()) {
+            cancel_ = true;
+            poller_.Wake();
+            thread_.join();
+        }
+    }
+
+    bool IsRunning() const { return thread_.joinable(); }
+
+    // Returns true once, when the search has finished. Joins the thread, so
+    // Results() is safe to read afterwards.
+    bool IsDone() {
+        if (!thread_.joinable() || !done_.load()) return false;
+        thread_.join();
+        return true;
+    }
+
+    size_t PortCount() const { return ports_.size(); }
+
+    // Every probed port, best first (see ProbeResultBefore)
+    const std::vector<PortProbeResult>& Results() const { return results_; }
+
+private:
+    void Run() {
+        results_ = ProbePorts(ports_, factory_, poller_, &cancel_);
+        done_ = true;
+    }
+
+    std::thread thread_;
+    PortPoller poller_;
+    TransportFactory factory_;
+    std::vector<std::pair<std::string, uint32_t>> ports_;
+    std::vector<PortProbeResult> results_;
+    std::atomic<bool> cancel_{false};
+    std::atomic<bool> done_{false};
+};
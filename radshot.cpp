@@ -32,6 +32,22 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 
+#include "frame_decoder.h"
+#include "frame_hash.h"
+#include "serial_transport.h"
+#include "capture_worker.h"
+#include "baud_probe.h"
+#include "radio_finder.h"
+#include "device_watcher.h"
+#include "session_archive.h"
+#include "frame_recording.h"
+#include "screenshot_store.h"
+#include "texture_cache.h"
+#include "thumb_atlas.h"
+#include "palette.h"
+#include "palette_shader.h"
+#include "png_writer.h"
+
 // Forward declare message handler from imgui_impl_win32.cpp
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -40,94 +56,57 @@ extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg
 // =============================================================================
 
 constexpr const char* APP_VERSION = "0.1";
+constexpr const char* GLSL_VERSION = "#version 130";   // For ImGui's shaders and the palette shader
 
-constexpr int DISPLAY_WIDTH = 128;
-constexpr int DISPLAY_HEIGHT = 64;
-constexpr int BITMAP_SIZE = 1024;
-constexpr DWORD BAUDRATE = 115200;
-constexpr uint8_t SCREENSHOT_CMD[] = { 0x41, 0x41 };
-constexpr int PREVIEW_SCALE = 4;
 constexpr int GALLERY_COLUMNS = 4;
-constexpr int MAX_RETRIES = 100;
+constexpr int PREFETCH_RADIUS = 2;       // Previews kept ready either side of the selection
+constexpr int MAX_EXPORT_SCALE = 16;
+constexpr int EXPORT_SCALES[] = { 1, 2, 4, 8, 16 };
+constexpr double RESUME_RETRY_S = 1.0;   // Reopen attempts for a radio whose port failed
+
+// What to do with a frame identical to the previous screenshot from the same radio
+enum class DuplicateMode { Keep, Drop, Fold };
+constexpr const char* DUPLICATE_MODE_NAMES[] = { "Keep", "Drop", "Fold" };
+
+// =============================================================================
+// Connected Radios
+// =============================================================================
 
-// Color palette from original (BGR format in BMP, but we use RGBA here)
-constexpr uint8_t COLOR_LIGHT[4] = { 0xDE, 0xEB, 0xFF, 0xFF }; // Light blue tint
-constexpr uint8_t COLOR_DARK[4] = { 0x00, 0x00, 0x00, 0xFF };  // Black
+// One connected port. Capture state mirrors its CaptureSession on the worker thread.
+struct Radio {
+    int session = -1;
+    char port[32] = {0};
+    uint32_t baud = 0;
 
-// GUID for COM ports
-static const GUID GUID_DEVINTERFACE_COMPORT =
-    { 0x86E0D1E0L, 0x8089, 0x11D0, { 0x9C, 0xE4, 0x08, 0x00, 0x3E, 0x30, 0x1F, 0x73 } };
+    // Port failed (e.g. cable pulled): no session, reopened once the port is back
+    bool lost = false;
+    double resume_at = 0.0;
+
+    bool is_capturing = false;
+    int capture_progress = 0;
+    bool is_bursting = false;
+    int burst_frames = 0;          // Frames received in the current burst
+    double burst_start_time = 0.0;
+    ScreenshotHandle last_screenshot;   // Predecessor for duplicate checks
+    int duplicates = 0;            // Unchanged frames dropped or folded, this capture/burst
+
+    // Capture in progress: bands are decoded and uploaded as they arrive, into a
+    // texture and atlas cell the finished screenshot then adopts
+    GLuint live_preview = 0;
+    uint32_t live_thumb = 0;       // Atlas cell
+    int live_bands = 0;
+};
 
 // =============================================================================
-// Screenshot Structure
+// Gallery Labels
 // =============================================================================
 
-struct Screenshot {
-    int id;
-    char name[256];
-    uint8_t raw_bitmap[BITMAP_SIZE];
-    uint8_t* rgba_preview;  // DISPLAY_WIDTH*PREVIEW_SCALE x DISPLAY_HEIGHT*PREVIEW_SCALE x 4
-    uint8_t* rgba_thumb;    // DISPLAY_WIDTH x DISPLAY_HEIGHT x 4
-    GLuint texture_preview;
-    GLuint texture_thumb;
-    SYSTEMTIME timestamp;
-
-    Screenshot() : id(0), rgba_preview(nullptr), rgba_thumb(nullptr),
-                   texture_preview(0), texture_thumb(0) {
-        name[0] = 0;
-        memset(raw_bitmap, 0, BITMAP_SIZE);
-        memset(&timestamp, 0, sizeof(timestamp));
-    }
-
-    ~Screenshot() {
-        if (rgba_preview) delete[] rgba_preview;
-        if (rgba_thumb) delete[] rgba_thumb;
-        if (texture_preview) glDeleteTextures(1, &texture_preview);
-        if (texture_thumb) glDeleteTextures(1, &texture_thumb);
-    }
-
-    // Prevent copying
-    Screenshot(const Screenshot&) = delete;
-    Screenshot& operator=(const Screenshot&) = delete;
-
-    // Allow moving
-    Screenshot(Screenshot&& other) noexcept {
-        id = other.id;
-        strcpy(name, other.name);
-        memcpy(raw_bitmap, other.raw_bitmap, BITMAP_SIZE);
-        rgba_preview = other.rgba_preview;
-        rgba_thumb = other.rgba_thumb;
-        texture_preview = other.texture_preview;
-        texture_thumb = other.texture_thumb;
-        timestamp = other.timestamp;
-        other.rgba_preview = nullptr;
-        other.rgba_thumb = nullptr;
-        other.texture_preview = 0;
-        other.texture_thumb = 0;
-    }
-
-    Screenshot& operator=(Screenshot&& other) noexcept {
-        if (this != &other) {
-            if (rgba_preview) delete[] rgba_preview;
-            if (rgba_thumb) delete[] rgba_thumb;
-            if (texture_preview) glDeleteTextures(1, &texture_preview);
-            if (texture_thumb) glDeleteTextures(1, &texture_thumb);
-
-            id = other.id;
-            strcpy(name, other.name);
-            memcpy(raw_bitmap, other.raw_bitmap, BITMAP_SIZE);
-            rgba_preview = other.rgba_preview;
-            rgba_thumb = other.rgba_thumb;
-            texture_preview = other.texture_preview;
-            texture_thumb = other.texture_thumb;
-            timestamp = other.timestamp;
-            other.rgba_preview = nullptr;
-            other.rgba_thumb = nullptr;
-            other.texture_preview = 0;
-            other.texture_thumb = 0;
-        }
-        return *this;
-    }
+// A thumbnail's caption, laid out once and reused until the name or repeat count changes
+struct GalleryLabel {
+    uint32_t generation = UINT32_MAX;
+    uint32_t revision = 0;
+    char text[32] = {0};
+    float offset = 0.0f;    // Indent that centres it under the thumbnail
 };
 
 // =============================================================================
@@ -144,23 +123,49 @@ struct AppState {
     bool running = true;
 
     // Serial
-    std::vector<std::string> com_ports;
+    std::vector<std::string> com_ports;        // Cached by device_watcher
     int selected_port = -1;
-    HANDLE serial_handle = INVALID_HANDLE_VALUE;
-    bool is_connected = false;
+    uint32_t baud_rate = DEFAULT_BAUD_RATE;   // For the selected port
     char status_message[256] = "Disconnected";
 
-    // Capture
-    bool is_capturing = false;
-    int capture_progress = 0;
-    uint8_t capture_buffer[BITMAP_SIZE];
-    int capture_bytes = 0;
-    int capture_retries = 0;
+    // Capture (serial I/O for every radio runs on the worker's thread; it owns the transports)
+    std::vector<Radio> radios;
+    int live_session = -1;         // Radio whose capture the preview follows
+    int burst_count = 10;          // Frames per burst, 0 = until stopped
+    DuplicateMode duplicate_mode = DuplicateMode::Keep;
+    CaptureWorker capture_worker;
+    BaudProber baud_prober;
+    DeviceWatcher device_watcher;
+    RadioFinder radio_finder;
+    std::vector<PortProbeResult> found_ports;   // Last Find, best first
 
     // Screenshots
-    std::vector<Screenshot*> screenshots;
+    ScreenshotStore screenshots;
     int next_id = 1;
-    int selected_screenshot = -1;
+    int selected_screenshot = -1;      // Gallery position
+    std::vector<GalleryLabel> gallery_labels;   // By store slot
+    AtlasGrid thumb_atlas{ATLAS_PAGE_SIZE, DISPLAY_WIDTH, DISPLAY_HEIGHT};
+    std::vector<GLuint> atlas_pages;   // One texture per thumb_atlas page
+    TextureLru texture_lru{DEFAULT_TEXTURE_BUDGET_MB << 20};   // Screenshot textures, evicted over budget
+    PaletteShader palette_shader;   // Colours the single-channel screenshot textures
+    bool palette_shader_reported = false;
+    int palette = 0;                  // PALETTE_PRESETS index shown
+    int export_palette = -1;          // For Save/Save All/Copy, -1 = as shown
+    int export_scale = PREVIEW_SCALE; // Pixels per LCD pixel in Save/Save All/Copy, 1..MAX_EXPORT_SCALE
+    SessionArchive archive;   // Every capture, reloaded on the next start
+
+    // Recording: every frame from one radio, delta-coded to a file (see frame_recording.h)
+    RecordingWriter recorder;
+    char recording_port[32] = {0};
+    char recording_path[MAX_PATH] = {0};
+    ULONGLONG recording_start = 0;    // GetTickCount64 when it started
+
+    // Playback of an opened recording in the preview
+    RecordingReader player;
+    int player_frame = 0;
+    int player_shown = -1;            // Frame currently in player_texture
+    GLuint player_texture = 0;
+    uint8_t player_raw[BITMAP_SIZE] = {0};
 
     // UI
     char rename_buffer[256] = {0};
@@ -172,6 +177,7 @@ struct AppState {
     // Settings persistence
     char last_save_directory[MAX_PATH] = {0};
     char last_port_name[32] = {0};
+    std::vector<std::pair<std::string, uint32_t>> port_bauds;  // Per-port link speed
     int window_x = CW_USEDEFAULT;
     int window_y = CW_USEDEFAULT;
 };
@@ -182,6 +188,23 @@ static AppState g_state;
 // Settings Persistence
 // =============================================================================
 
+static uint32_t GetPortBaud(const char* port) {
+    for (const auto& entry : g_state.port_bauds) {
+        if (entry.first == port) return entry.second;
+    }
+    return DEFAULT_BAUD_RATE;
+}
+
+static void SetPortBaud(const char* port, uint32_t baud) {
+    for (auto& entry : g_state.port_bauds) {
+        if (entry.first == port) {
+            entry.second = baud;
+            return;
+        }
+    }
+    g_state.port_bauds.emplace_back(port, baud);
+}
+
 static void GetSettingsPath(char* path, size_t pathSize) {
     char exePath[MAX_PATH];
     GetModuleFileNameA(nullptr, exePath, MAX_PATH);
@@ -197,6 +220,14 @@ static void GetSettingsPath(char* path, size_t pathSize) {
     path[pathSize - 1] = 0;
 }
 
+// The session archive sits next to the .ini
+static void GetArchivePath(char* path, size_t pathSize) {
+    GetSettingsPath(path, pathSize);
+    char* dot = strrchr(path, '.');
+    if (dot) *dot = 0;
+    strncat(path, ".session", pathSize - strlen(path) - 1);
+}
+
 static void LoadSettings() {
     char iniPath[MAX_PATH];
     GetSettingsPath(iniPath, sizeof(iniPath));
@@ -232,6 +263,25 @@ static void LoadSettings() {
             strncpy(g_state.last_port_name, value, sizeof(g_state.last_port_name) - 1);
         } else if (strcmp(key, "last_save_directory") == 0) {
             strncpy(g_state.last_save_directory, value, sizeof(g_state.last_save_directory) - 1);
+        } else if (strcmp(key, "duplicates") == 0) {
+            for (int i = 0; i < 3; i++) {
+                if (strcmp(value, DUPLICATE_MODE_NAMES[i]) == 0) g_state.duplicate_mode = (DuplicateMode)i;
+            }
+        } else if (strcmp(key, "palette") == 0) {
+            int palette = FindPalette(value);
+            if (palette >= 0) g_state.palette = palette;
+        } else if (strcmp(key, "export_palette") == 0) {
+            g_state.export_palette = FindPalette(value);
+        } else if (strcmp(key, "export_scale") == 0) {
+            int scale = atoi(value);
+            if (scale >= 1 && scale <= MAX_EXPORT_SCALE) g_state.export_scale = scale;
+        } else if (strcmp(key, "texture_budget_mb") == 0) {
+            int mb = atoi(value);
+            if (mb >= 4 && mb <= 4096) g_state.texture_lru.SetBudget((size_t)mb << 20);
+        } else if (strncmp(key, "baud.", 5) == 0) {
+            // baud.<port>=<rate>
+            uint32_t baud = (uint32_t)strtoul(value, nullptr, 10);
+            if (key[5] != 0 && IsStandardBaudRate(baud)) SetPortBaud(key + 5, baud);
         }
     }
     fclose(f);
@@ -250,242 +300,617 @@ static void SaveSettings() {
     fprintf(f, "window_height=%d\n", g_state.window_height);
     fprintf(f, "last_port=%s\n", g_state.last_port_name);
     fprintf(f, "last_save_directory=%s\n", g_state.last_save_directory);
+    fprintf(f, "duplicates=%s\n", DUPLICATE_MODE_NAMES[(int)g_state.duplicate_mode]);
+    fprintf(f, "palette=%s\n", PALETTE_PRESETS[g_state.palette].name);
+    fprintf(f, "export_palette=%s\n", g_state.export_palette < 0 ? "" : PALETTE_PRESETS[g_state.export_palette].name);
+    fprintf(f, "export_scale=%d\n", g_state.export_scale);
+    fprintf(f, "texture_budget_mb=%d\n", (int)(g_state.texture_lru.Budget() >> 20));
+    for (const auto& entry : g_state.port_bauds) {
+        fprintf(f, "baud.%s=%u\n", entry.first.c_str(), entry.second);
+    }
     fclose(f);
 }
 
 // =============================================================================
-// Bitmap Processing (matching Python implementation)
+// Textures
 // =============================================================================
 
-inline int GetPixel(const uint8_t* bitmap, int x, int y) {
-    return (bitmap[x + ((y / 8) * DISPLAY_WIDTH)] >> (y & 7)) & 1;
+// Screenshot textures hold palette indices (DecodeFrameIndex), one byte per LCD pixel, at
+// display size: nearest filtering makes the 4x preview from the same texels. Colours come
+// from the palette shader at draw time, so draw them with PaletteImage or between
+// UsePaletteShader and ImDrawCallback_ResetRenderState callbacks.
+GLuint CreateTexture(const uint8_t* index, int width, int height) {
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    SetTextureSwizzle();
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, index);
+    return tex;
 }
 
-inline void SetPixel(uint8_t* buffer, int x, int y, int color) {
-    buffer[(x / 8) + ((DISPLAY_HEIGHT - 1 - y) * 16)] |= (color << (7 - (x & 7)));
+static void UsePaletteShader(const ImDrawList*, const ImDrawCmd*) {
+    g_state.palette_shader.Use();
 }
 
-void ProcessBitmap(const uint8_t* raw, uint8_t* rgba_preview, uint8_t* rgba_thumb) {
-    // Convert raw device format to standard format
-    uint8_t processed[BITMAP_SIZE] = {0};
-    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
-        for (int x = 0; x < DISPLAY_WIDTH; x++) {
-            SetPixel(processed, x, y, GetPixel(raw, x, y));
-        }
+// ImGui::Image for a screenshot texture
+static void PaletteImage(GLuint texture, const ImVec2& size) {
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->AddCallback(UsePaletteShader, nullptr);
+    ImGui::Image((ImTextureID)(intptr_t)texture, size);
+    drawList->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+}
+
+static void* GetGlProc(const char* name) {
+    // Some drivers return small integers rather than null for a missing function
+    intptr_t proc = (intptr_t)wglGetProcAddress(name);
+    return (proc >= -1 && proc <= 3) ? nullptr : (void*)proc;
+}
+
+// Takes a thumbnail cell, creating its atlas page if it is a new one
+static uint32_t AllocThumb() {
+    uint32_t cell = g_state.thumb_atlas.Alloc();
+    while ((int)g_state.atlas_pages.size() < g_state.thumb_atlas.Pages()) {
+        g_state.atlas_pages.push_back(CreateTexture(nullptr, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE));
     }
+    return cell;
+}
 
-    // Generate preview (4x upscaled) and thumbnail
-    int preview_w = DISPLAY_WIDTH * PREVIEW_SCALE;
-    int preview_h = DISPLAY_HEIGHT * PREVIEW_SCALE;
+static void FreeThumb(uint32_t cell) {
+    g_state.thumb_atlas.Free(cell);
+}
 
-    for (int sy = 0; sy < DISPLAY_HEIGHT; sy++) {
-        for (int sx = 0; sx < DISPLAY_WIDTH; sx++) {
-            // Read from processed bitmap
-            int byte_idx = (sx / 8) + ((DISPLAY_HEIGHT - 1 - sy) * 16);
-            int bit_idx = 7 - (sx & 7);
-            int pixel = (processed[byte_idx] >> bit_idx) & 1;
+// Uploads `rows` thumbnail rows starting at `row` into an atlas cell
+static void UploadThumbRows(uint32_t cell, int row, int rows, const uint8_t* index) {
+    int x, y;
+    g_state.thumb_atlas.Origin(cell, x, y);
+    glBindTexture(GL_TEXTURE_2D, g_state.atlas_pages[g_state.thumb_atlas.Page(cell)]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y + row, DISPLAY_WIDTH, rows, GL_RED, GL_UNSIGNED_BYTE, index);
+}
 
-            const uint8_t* color = pixel ? COLOR_DARK : COLOR_LIGHT;
+static void ReleaseThumbAtlas() {
+    if (!g_state.atlas_pages.empty()) {
+        glDeleteTextures((GLsizei)g_state.atlas_pages.size(), g_state.atlas_pages.data());
+    }
+    g_state.atlas_pages.clear();
+    g_state.thumb_atlas.Clear();
+}
 
-            // Write to thumbnail (1x)
-            int thumb_idx = (sy * DISPLAY_WIDTH + sx) * 4;
-            memcpy(rgba_thumb + thumb_idx, color, 4);
+// Decodes one band of `raw` and uploads it into a radio's live texture and thumbnail cell
+static void UploadLiveBand(Radio& radio, const uint8_t* raw, int band) {
+    uint8_t index[Rt4dDecoder::BAND_INDEX_BYTES];
+    DecodeFrameIndexBand(raw, band, index);
 
-            // Write to preview (4x upscaled with nearest neighbor)
-            for (int py = 0; py < PREVIEW_SCALE; py++) {
-                for (int px = 0; px < PREVIEW_SCALE; px++) {
-                    int preview_x = sx * PREVIEW_SCALE + px;
-                    int preview_y = sy * PREVIEW_SCALE + py;
-                    int preview_idx = (preview_y * preview_w + preview_x) * 4;
-                    memcpy(rgba_preview + preview_idx, color, 4);
-                }
-            }
-        }
+    glBindTexture(GL_TEXTURE_2D, radio.live_preview);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, band * 8, DISPLAY_WIDTH, 8, GL_RED, GL_UNSIGNED_BYTE, index);
+    UploadThumbRows(radio.live_thumb, band * 8, 8, index);
+}
+
+// Uploads every band completed within the first `bytes` of `raw` that isn't on the GPU yet
+static void UpdateLiveTextures(Radio& radio, const uint8_t* raw, int bytes) {
+    int bands = bytes / Rt4dDecoder::BAND_BYTES;
+    if (bands <= radio.live_bands) return;
+
+    if (!radio.live_preview) {
+        // Fresh textures start as a blank screen that fills in from the top
+        static const uint8_t blank[BITMAP_SIZE] = {};
+        radio.live_preview = CreateTexture(nullptr, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+        radio.live_thumb = AllocThumb();
+        for (int band = bands; band < Rt4dDecoder::BANDS; band++) UploadLiveBand(radio, blank, band);
     }
+
+    for (int band = radio.live_bands; band < bands; band++) UploadLiveBand(radio, raw, band);
+    radio.live_bands = bands;
 }
 
-GLuint CreateTexture(const uint8_t* rgba, int width, int height) {
-    GLuint tex;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
-    return tex;
+// Drops a partial capture's textures (timeout, disconnect)
+static void DiscardLiveTextures(Radio& radio) {
+    if (radio.live_preview) glDeleteTextures(1, &radio.live_preview);
+    FreeThumb(radio.live_thumb);
+    radio.live_preview = 0;
+    radio.live_thumb = 0;
+    radio.live_bands = 0;
 }
 
 // =============================================================================
 // Serial Port Functions
 // =============================================================================
 
-void EnumerateComPorts() {
-    g_state.com_ports.clear();
-
-    HDEVINFO hDevInfo = SetupDiGetClassDevs(
-        &GUID_DEVINTERFACE_COMPORT, nullptr, nullptr,
-        DIGCF_PRESENT | DIGCF_DEVICEINTERFACE
-    );
+static Radio* FindRadio(int session) {
+    if (session < 0) return nullptr;
+    for (Radio& radio : g_state.radios) {
+        if (radio.session == session) return &radio;
+    }
+    return nullptr;
+}
 
-    if (hDevInfo == INVALID_HANDLE_VALUE) return;
+static bool IsPortConnected(const std::string& port) {
+    for (const Radio& radio : g_state.radios) {
+        if (port == radio.port) return true;
+    }
+    return false;
+}
 
-    SP_DEVINFO_DATA devInfo = { sizeof(SP_DEVINFO_DATA) };
+static bool AnyRadioCapturing() {
+    for (const Radio& radio : g_state.radios) {
+        if (radio.is_capturing) return true;
+    }
+    return false;
+}
 
-    for (DWORD i = 0; SetupDiEnumDeviceInfo(hDevInfo, i, &devInfo); i++) {
-        HKEY hKey = SetupDiOpenDevRegKey(
-            hDevInfo, &devInfo, DICS_FLAG_GLOBAL, 0, DIREG_DEV, KEY_READ
-        );
+// Opens another radio; it joins the others on the capture thread
+bool SerialConnect(const char* portName) {
+    if (IsPortConnected(portName)) return false;
 
-        if (hKey != INVALID_HANDLE_VALUE) {
-            char portName[256];
-            DWORD size = sizeof(portName);
-            DWORD type;
+    std::unique_ptr<ISerialTransport> transport = CreatePlatformTransport();
+    if (!transport->Open(portName, g_state.baud_rate)) {
+        strncpy(g_state.status_message, transport->LastError(), sizeof(g_state.status_message) - 1);
+        return false;
+    }
 
-            if (RegQueryValueExA(hKey, "PortName", nullptr, &type,
-                                 (LPBYTE)portName, &size) == ERROR_SUCCESS) {
-                if (strncmp(portName, "COM", 3) == 0) {
-                    g_state.com_ports.push_back(portName);
-                }
-            }
-            RegCloseKey(hKey);
-        }
+    int session = g_state.capture_worker.AddSession(std::move(transport), g_state.baud_rate);
+    if (session < 0) {
+        strcpy(g_state.status_message, "Failed to start capture session");
+        return false;
     }
 
-    SetupDiDestroyDeviceInfoList(hDevInfo);
+    Radio radio;
+    radio.session = session;
+    strncpy(radio.port, portName, sizeof(radio.port) - 1);
+    radio.baud = g_state.baud_rate;
+    g_state.radios.push_back(radio);
 
-    // Natural sort
-    std::sort(g_state.com_ports.begin(), g_state.com_ports.end(),
-        [](const std::string& a, const std::string& b) {
-            return atoi(a.c_str() + 3) < atoi(b.c_str() + 3);
-        });
+    strncpy(g_state.last_port_name, portName, sizeof(g_state.last_port_name) - 1);
+    SetPortBaud(portName, g_state.baud_rate);
+    snprintf(g_state.status_message, sizeof(g_state.status_message),
+             "Connected to %s at %u baud", portName, g_state.baud_rate);
+    return true;
 }
 
-bool SerialConnect(const char* portName) {
-    char fullPath[32];
-    snprintf(fullPath, sizeof(fullPath), "\\\\.\\%s", portName);
+void SerialDisconnect(size_t index) {
+    Radio& radio = g_state.radios[index];
+    if (!radio.lost) g_state.capture_worker.RemoveSession(radio.session);
+    DiscardLiveTextures(radio);
+    snprintf(g_state.status_message, sizeof(g_state.status_message), "Disconnected %s", radio.port);
+    g_state.radios.erase(g_state.radios.begin() + index);
+}
 
-    g_state.serial_handle = CreateFileA(
-        fullPath, GENERIC_READ | GENERIC_WRITE, 0, nullptr,
-        OPEN_EXISTING, 0, nullptr
-    );
+void DisconnectAll() {
+    while (!g_state.radios.empty()) SerialDisconnect(g_state.radios.size() - 1);
+    strcpy(g_state.status_message, "Disconnected");
+}
+
+// The radio's session has failed and been closed by the worker. The radio stays in the
+// list, holding its port, until the port can be reopened.
+static void LoseRadio(Radio& radio) {
+    DiscardLiveTextures(radio);
+    radio.session = -1;
+    radio.lost = true;
+    radio.resume_at = ImGui::GetTime() + RESUME_RETRY_S;
+    radio.is_capturing = false;
+    radio.is_bursting = false;
+    radio.capture_progress = 0;
+}
 
-    if (g_state.serial_handle == INVALID_HANDLE_VALUE) {
+// Reopens lost radios whose port is listed again; called once per UI frame
+static void ResumeLostRadios() {
+    double now = ImGui::GetTime();
+    for (Radio& radio : g_state.radios) {
+        if (!radio.lost || now < radio.resume_at) continue;
+        if (std::find(g_state.com_ports.begin(), g_state.com_ports.end(), radio.port) == g_state.com_ports.end()) continue;
+
+        // The port can be listed a moment before it opens; try again shortly if it fails
+        radio.resume_at = now + RESUME_RETRY_S;
+        std::unique_ptr<ISerialTransport> transport = CreatePlatformTransport();
+        if (!transport->Open(radio.port, radio.baud)) continue;
+        int session = g_state.capture_worker.AddSession(std::move(transport), radio.baud);
+        if (session < 0) continue;
+
+        radio.session = session;
+        radio.lost = false;
         snprintf(g_state.status_message, sizeof(g_state.status_message),
-                 "Failed to open %s", portName);
-        return false;
+                 "Resumed %s at %u baud", radio.port, radio.baud);
     }
+}
 
-    DCB dcb = { sizeof(DCB) };
-    if (!GetCommState(g_state.serial_handle, &dcb)) {
-        CloseHandle(g_state.serial_handle);
-        g_state.serial_handle = INVALID_HANDLE_VALUE;
-        strcpy(g_state.status_message, "Failed to get port state");
-        return false;
+// Picks up port list changes from the watcher thread; called once per UI frame
+void PollDeviceWatcher() {
+    std::vector<std::string> ports;
+    if (g_state.device_watcher.TakePorts(ports)) {
+        // Keep the selection by name; with none, select the last port used if it is present
+        bool hadSelection = g_state.selected_port >= 0;
+        std::string keep = hadSelection ? g_state.com_ports[g_state.selected_port] : g_state.last_port_name;
+        g_state.com_ports.swap(ports);
+        g_state.selected_port = -1;
+        for (int i = 0; i < (int)g_state.com_ports.size(); i++) {
+            if (g_state.com_ports[i] == keep) g_state.selected_port = i;
+        }
+        if (!hadSelection && g_state.selected_port >= 0) g_state.baud_rate = GetPortBaud(keep.c_str());
+
+        // A returning port is retried straight away
+        for (Radio& radio : g_state.radios) {
+            if (radio.lost) radio.resume_at = 0.0;
+        }
     }
+    ResumeLostRadios();
+}
 
-    dcb.BaudRate = BAUDRATE;
-    dcb.ByteSize = 8;
-    dcb.Parity = NOPARITY;
-    dcb.StopBits = ONESTOPBIT;
-    dcb.fBinary = TRUE;
-    dcb.fDtrControl = DTR_CONTROL_ENABLE;
-    dcb.fRtsControl = RTS_CONTROL_ENABLE;
+// Tries each standard rate, fastest first, with a test capture (see baud_probe.h)
+void StartBaudProbe() {
+    if (g_state.selected_port < 0 || g_state.baud_prober.IsRunning() || g_state.radio_finder.IsRunning()) return;
 
-    if (!SetCommState(g_state.serial_handle, &dcb)) {
-        CloseHandle(g_state.serial_handle);
-        g_state.serial_handle = INVALID_HANDLE_VALUE;
-        strcpy(g_state.status_message, "Failed to configure port");
-        return false;
+    const char* port = g_state.com_ports[g_state.selected_port].c_str();
+    if (IsPortConnected(port)) return;
+    if (!g_state.baud_prober.Start(port)) return;
+    snprintf(g_state.status_message, sizeof(g_state.status_message), "Probing %s...", port);
+}
+
+// Sends one screenshot request to every unconnected port at once (see radio_finder.h)
+void StartFindRadios() {
+    if (g_state.radio_finder.IsRunning() || g_state.baud_prober.IsRunning()) return;
+
+    g_state.found_ports.clear();
+
+    std::vector<std::pair<std::string, uint32_t>> ports;
+    for (const std::string& port : g_state.com_ports) {
+        if (!IsPortConnected(port)) ports.push_back(std::make_pair(port, GetPortBaud(port.c_str())));
     }
+    if (!g_state.radio_finder.Start(std::move(ports))) {
+        strcpy(g_state.status_message, "No free serial ports to search");
+        return;
+    }
+    snprintf(g_state.status_message, sizeof(g_state.status_message),
+             "Searching %d ports for radios...", (int)g_state.radio_finder.PortCount());
+}
 
-    COMMTIMEOUTS timeouts = {0};
-    timeouts.ReadIntervalTimeout = MAXDWORD;
-    timeouts.ReadTotalTimeoutMultiplier = 0;
-    timeouts.ReadTotalTimeoutConstant = 0;
-    timeouts.WriteTotalTimeoutMultiplier = 0;
-    timeouts.WriteTotalTimeoutConstant = 1000;
-    SetCommTimeouts(g_state.serial_handle, &timeouts);
+// Returns the last Find's result for `port`, if it was probed
+static const PortProbeResult* FoundPort(const std::string& port) {
+    for (const PortProbeResult& result : g_state.found_ports) {
+        if (result.port == port) return &result;
+    }
+    return nullptr;
+}
 
-    PurgeComm(g_state.serial_handle, PURGE_RXCLEAR | PURGE_TXCLEAR);
+// Called once per UI frame
+void PollFindRadios() {
+    if (!g_state.radio_finder.IsRunning() || !g_state.radio_finder.IsDone()) return;
 
-    g_state.is_connected = true;
-    strncpy(g_state.last_port_name, portName, sizeof(g_state.last_port_name) - 1);
+    g_state.found_ports = g_state.radio_finder.Results();
+    int radios = 0;
+    for (const PortProbeResult& result : g_state.found_ports) {
+        if (result.outcome == ProbeOutcome::Frame) radios++;
+    }
+    if (radios == 0) {
+        snprintf(g_state.status_message, sizeof(g_state.status_message),
+                 "No radio answered on %d ports", (int)g_state.found_ports.size());
+        return;
+    }
+
+    // Select the best-ranked radio, ready to connect
+    const PortProbeResult& best = g_state.found_ports.front();
+    for (int i = 0; i < (int)g_state.com_ports.size(); i++) {
+        if (g_state.com_ports[i] != best.port) continue;
+        g_state.selected_port = i;
+        g_state.baud_rate = best.baud;
+    }
     snprintf(g_state.status_message, sizeof(g_state.status_message),
-             "Connected to %s", portName);
-    return true;
+             "Found %d radio%s, selected %s (%u ms)", radios, radios == 1 ? "" : "s",
+             best.port.c_str(), best.latency_ms);
 }
 
-void SerialDisconnect() {
-    if (g_state.serial_handle != INVALID_HANDLE_VALUE) {
-        CloseHandle(g_state.serial_handle);
-        g_state.serial_handle = INVALID_HANDLE_VALUE;
+// Called once per UI frame
+void PollBaudProbe() {
+    if (!g_state.baud_prober.IsRunning()) return;
+
+    if (!g_state.baud_prober.IsDone()) {
+        snprintf(g_state.status_message, sizeof(g_state.status_message), "Probing %s at %u baud...",
+                 g_state.baud_prober.Port().c_str(), g_state.baud_prober.CurrentBaud());
+        return;
     }
-    g_state.is_connected = false;
-    g_state.is_capturing = false;
-    strcpy(g_state.status_message, "Disconnected");
+
+    uint32_t baud = g_state.baud_prober.Result();
+    const char* port = g_state.baud_prober.Port().c_str();
+    if (baud == 0) {
+        snprintf(g_state.status_message, sizeof(g_state.status_message),
+                 "No valid frame from %s at any baud rate", port);
+        return;
+    }
+
+    SetPortBaud(port, baud);
+    if (g_state.selected_port >= 0 && g_state.com_ports[g_state.selected_port] == port) {
+        g_state.baud_rate = baud;
+    }
+    snprintf(g_state.status_message, sizeof(g_state.status_message),
+             "%s: %u baud (test frame in %u ms)", port, baud,
+             g_state.baud_prober.Attempts().back().elapsed_ms);
 }
 
+// Takes one screenshot from every idle radio
 void StartCapture() {
-    if (!g_state.is_connected || g_state.is_capturing) return;
+    for (Radio& radio : g_state.radios) {
+        if (radio.lost || radio.is_capturing || !g_state.capture_worker.RequestCapture(radio.session)) continue;
+        radio.is_capturing = true;
+        radio.capture_progress = 0;
+        radio.duplicates = 0;
+    }
+}
 
-    PurgeComm(g_state.serial_handle, PURGE_RXCLEAR | PURGE_TXCLEAR);
+// Captures frames back to back on every idle radio
+void StartBurst() {
+    for (Radio& radio : g_state.radios) {
+        if (radio.lost || radio.is_capturing || !g_state.capture_worker.RequestBurst(radio.session, g_state.burst_count)) continue;
+        radio.is_capturing = true;
+        radio.is_bursting = true;
+        radio.capture_progress = 0;
+        radio.burst_frames = 0;
+        radio.burst_start_time = ImGui::GetTime();
+        radio.duplicates = 0;
+    }
+}
 
-    DWORD written;
-    WriteFile(g_state.serial_handle, SCREENSHOT_CMD, sizeof(SCREENSHOT_CMD), &written, nullptr);
-    FlushFileBuffers(g_state.serial_handle);
+void StopBurst() {
+    for (Radio& radio : g_state.radios) {
+        if (radio.is_bursting) g_state.capture_worker.RequestStopBurst(radio.session);
+    }
+}
 
-    g_state.is_capturing = true;
-    g_state.capture_bytes = 0;
-    g_state.capture_retries = 0;
-    g_state.capture_progress = 0;
-    memset(g_state.capture_buffer, 0, BITMAP_SIZE);
+// Best case at a given baud: the frame's time on the wire and nothing else
+static double LinkMaxFps(uint32_t baud) {
+    uint32_t wireMs = CaptureTimeouts::WireTimeMs(baud, BITMAP_SIZE);
+    return wireMs ? 1000.0 / wireMs : 0.0;
 }
 
-void UpdateCapture() {
-    if (!g_state.is_capturing) return;
+// Handle of the selected screenshot, null if none
+static ScreenshotHandle SelectedScreenshot() {
+    if (g_state.selected_screenshot < 0) return ScreenshotHandle();
+    return g_state.screenshots.At((size_t)g_state.selected_screenshot);
+}
 
-    uint8_t temp[256];
-    DWORD bytesRead;
+static void SelectScreenshot(int pos) {
+    g_state.selected_screenshot = pos;
+    if (pos >= 0) {
+        g_state.screenshots.Name(g_state.screenshots.At((size_t)pos), g_state.rename_buffer, sizeof(g_state.rename_buffer));
+    } else {
+        g_state.rename_buffer[0] = 0;
+    }
+}
 
-    if (ReadFile(g_state.serial_handle, temp, sizeof(temp), &bytesRead, nullptr) && bytesRead > 0) {
-        int toCopy = (std::min)((int)bytesRead, BITMAP_SIZE - g_state.capture_bytes);
-        memcpy(g_state.capture_buffer + g_state.capture_bytes, temp, toCopy);
-        g_state.capture_bytes += toCopy;
-        g_state.capture_progress = (g_state.capture_bytes * 100) / BITMAP_SIZE;
-        g_state.capture_retries = 0;
+// Returns true if the frame repeats the radio's previous screenshot and has been dropped
+// or folded into it, per g_state.duplicate_mode
+static bool HandleDuplicate(Radio& radio, const uint8_t* raw, uint64_t hash) {
+    if (g_state.duplicate_mode == DuplicateMode::Keep) return false;
+
+    // The hash rules out nearly every changed frame; the compare makes a match certain
+    ScreenshotStore& store = g_state.screenshots;
+    ScreenshotHandle prev = radio.last_screenshot;
+    if (!store.Valid(prev) || store.Hash(prev) != hash || memcmp(store.Frame(prev), raw, BITMAP_SIZE) != 0) return false;
+
+    // The live textures are kept for the next capture to draw over
+    radio.live_bands = 0;
+    radio.duplicates++;
+    if (g_state.duplicate_mode == DuplicateMode::Fold) {
+        store.SetRepeatCount(prev, store.RepeatCount(prev) + 1);
+        g_state.archive.SetRepeatCount(store.ArchiveIndex(prev), store.RepeatCount(prev));
+    }
+    return true;
+}
 
-        if (g_state.capture_bytes >= BITMAP_SIZE) {
-            // Create new screenshot
-            Screenshot* ss = new Screenshot();
-            ss->id = g_state.next_id++;
-            snprintf(ss->name, sizeof(ss->name), "screenshot_%03d", ss->id);
-            GetLocalTime(&ss->timestamp);
-            memcpy(ss->raw_bitmap, g_state.capture_buffer, BITMAP_SIZE);
+// Adds a screenshot of `raw` to the gallery and the archive and selects it.
+// Textures are left to the caller (or created on first view).
+static ScreenshotHandle NewScreenshot(const char* port, const uint8_t* raw, uint64_t hash, const SYSTEMTIME& timestamp) {
+    int id = g_state.next_id++;
+    char name[256];
+    if (g_state.radios.size() > 1) {
+        // Several radios: lead with the port name (basename on POSIX paths)
+        const char* slash = strrchr(port, '/');
+        snprintf(name, sizeof(name), "%s_screenshot_%03d", slash ? slash + 1 : port, id);
+    } else {
+        snprintf(name, sizeof(name), "screenshot_%03d", id);
+    }
 
-            // Allocate and process
-            int preview_w = DISPLAY_WIDTH * PREVIEW_SCALE;
-            int preview_h = DISPLAY_HEIGHT * PREVIEW_SCALE;
-            ss->rgba_preview = new uint8_t[preview_w * preview_h * 4];
-            ss->rgba_thumb = new uint8_t[DISPLAY_WIDTH * DISPLAY_HEIGHT * 4];
+    ArchiveTime archiveTime;
+    static_assert(sizeof(archiveTime) == sizeof(timestamp), "ArchiveTime mirrors SYSTEMTIME");
+    memcpy(&archiveTime, &timestamp, sizeof(archiveTime));
+    ScreenshotHandle h = g_state.screenshots.Add(id, name, port, archiveTime, hash, 1, raw);
+    g_state.screenshots.SetArchiveIndex(h, g_state.archive.Append((uint32_t)id, archiveTime, port, name, hash, 1,
+                                                                  g_state.screenshots.Frame(h)));
 
-            ProcessBitmap(ss->raw_bitmap, ss->rgba_preview, ss->rgba_thumb);
+    SelectScreenshot((int)g_state.screenshots.Count() - 1);
+    return h;
+}
+
+static void AddScreenshot(Radio& radio, const uint8_t* raw, uint64_t hash) {
+    SYSTEMTIME now;
+    GetLocalTime(&now);
+    ScreenshotHandle h = NewScreenshot(radio.port, raw, hash, now);
+    radio.last_screenshot = h;
+
+    // The live textures already hold the whole frame, decoded band by band while it arrived
+    UpdateLiveTextures(radio, raw, BITMAP_SIZE);
+    g_state.screenshots.SetTextures(h, radio.live_preview, radio.live_thumb);
+    g_state.texture_lru.Touch(h, TextureKind::Preview, Rt4dDecoder::INDEX_BYTES);
+    g_state.texture_lru.Touch(h, TextureKind::Thumb, Rt4dDecoder::INDEX_BYTES);
+    radio.live_preview = 0;
+    radio.live_thumb = 0;
+    radio.live_bands = 0;
+}
 
-            ss->texture_preview = CreateTexture(ss->rgba_preview, preview_w, preview_h);
-            ss->texture_thumb = CreateTexture(ss->rgba_thumb, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+// Opens the session archive and rebuilds the gallery from it. Frames stay in the mapping;
+// textures are created when a screenshot is first shown (EnsureTextures).
+static void LoadArchive() {
+    char path[MAX_PATH];
+    GetArchivePath(path, sizeof(path));
+
+    std::string error;
+    if (!g_state.archive.Open(path, error)) {
+        snprintf(g_state.status_message, sizeof(g_state.status_message), "Session not saved: %s", error.c_str());
+        return;
+    }
 
-            g_state.screenshots.push_back(ss);
-            g_state.selected_screenshot = (int)g_state.screenshots.size() - 1;
-            strcpy(g_state.rename_buffer, ss->name);
+    // Built from the index entries; a record is only read when its screenshot is shown
+    uint64_t count = g_state.archive.MappedCount();
+    g_state.screenshots.Reserve((size_t)count);
+    for (uint64_t i = 0; i < count; i++) {
+        const ArchiveIndexEntry& entry = g_state.archive.MappedEntry(i);
+        if (entry.flags & ARCHIVE_FLAG_DELETED) continue;
+
+        ScreenshotHandle h = g_state.screenshots.AddArchived((int)entry.id, &g_state.archive.Mapped(i),
+                                                             entry.repeat_count > 0 ? entry.repeat_count : 1);
+        g_state.screenshots.SetArchiveIndex(h, (int64_t)i);
+        if ((int)entry.id >= g_state.next_id) g_state.next_id = (int)entry.id + 1;
+    }
+
+    ArchiveStats stats = g_state.archive.Stats();
+    if (stats.recovered > 0 || stats.discarded > 0) {
+        snprintf(g_state.status_message, sizeof(g_state.status_message),
+                 "Session restored: %d screenshots (%llu recovered, %llu damaged dropped)",
+                 (int)g_state.screenshots.Count(), (unsigned long long)stats.recovered,
+                 (unsigned long long)stats.discarded);
+    } else if (!g_state.screenshots.Empty()) {
+        snprintf(g_state.status_message, sizeof(g_state.status_message),
+                 "Session restored: %d screenshots", (int)g_state.screenshots.Count());
+    }
+}
 
-            g_state.is_capturing = false;
+// Decodes and uploads whichever textures a screenshot doesn't have resident, and marks
+// them used this frame so the texture cache keeps them
+static void EnsureTextures(ScreenshotHandle h, bool preview) {
+    ScreenshotStore& store = g_state.screenshots;
+    uint32_t thumb = store.ThumbCell(h);
+    GLuint previewTex = store.TexturePreview(h);
+    if (!thumb || (preview && !previewTex)) {
+        uint8_t index[Rt4dDecoder::INDEX_BYTES];
+        DecodeFrameIndex(store.Frame(h), index);
+        if (!thumb) {
+            thumb = AllocThumb();
+            UploadThumbRows(thumb, 0, DISPLAY_HEIGHT, index);
         }
+        if (preview && !previewTex) previewTex = CreateTexture(index, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    }
+    store.SetTextures(h, previewTex, thumb);
+    g_state.texture_lru.Touch(h, TextureKind::Thumb, Rt4dDecoder::INDEX_BYTES);
+    if (preview) g_state.texture_lru.Touch(h, TextureKind::Preview, Rt4dDecoder::INDEX_BYTES);
+}
+
+static void ReleaseTexture(ScreenshotHandle h, TextureKind kind) {
+    ScreenshotStore& store = g_state.screenshots;
+    if (kind == TextureKind::Preview) {
+        GLuint preview = store.TexturePreview(h);
+        if (preview) glDeleteTextures(1, &preview);
+        store.SetTextures(h, 0, store.ThumbCell(h));
     } else {
-        g_state.capture_retries++;
-        if (g_state.capture_retries >= MAX_RETRIES) {
+        FreeThumb(store.ThumbCell(h));
+        store.SetTextures(h, store.TexturePreview(h), 0);
+    }
+    g_state.texture_lru.Remove(h, kind);
+}
+
+static void DeleteTextures(ScreenshotHandle h) {
+    ReleaseTexture(h, TextureKind::Preview);
+    ReleaseTexture(h, TextureKind::Thumb);
+}
+
+// Uploads the previews either side of the selection ahead of time, nearest first and one
+// per frame, so stepping through the gallery finds them ready
+static void PrefetchPreviews() {
+    ScreenshotStore& store = g_state.screenshots;
+    int sel = g_state.selected_screenshot;
+    if (sel < 0) return;
+    bool uploaded = false;
+    for (int d = 1; d <= PREFETCH_RADIUS; d++) {
+        for (int pos : { sel + d, sel - d }) {
+            if (pos < 0 || pos >= (int)store.Count()) continue;
+            ScreenshotHandle h = store.At((size_t)pos);
+            if (store.TexturePreview(h)) {
+                g_state.texture_lru.Touch(h, TextureKind::Preview, Rt4dDecoder::INDEX_BYTES);
+            } else if (!uploaded) {
+                EnsureTextures(h, true);
+                uploaded = true;
+            }
+        }
+    }
+}
+
+// Evicts the least recently used textures not drawn this frame until back under budget
+static void TrimTextures() {
+    ScreenshotHandle h;
+    TextureKind kind;
+    while (g_state.texture_lru.Victim(h, kind)) {
+        ReleaseTexture(h, kind);
+        g_state.texture_lru.CountEviction();
+    }
+}
+
+// Appends every frame from the recorded radio, unchanged ones included, so the
+// recording keeps real time
+static void RecordFrame(const Radio& radio, const uint8_t* raw) {
+    if (!g_state.recorder.IsOpen() || strcmp(radio.port, g_state.recording_port) != 0) return;
+    g_state.recorder.Append(raw, (uint32_t)(GetTickCount64() - g_state.recording_start));
+}
+
+// Drains events from the capture thread. Called once per UI frame.
+void PollCaptureEvents() {
+    CaptureEvent ev;
+    while (g_state.capture_worker.PollEvent(ev)) {
+        // Events can still arrive from a session the UI has just disconnected
+        Radio* radio = FindRadio(ev.session);
+        if (!radio) continue;
+
+        switch (ev.type) {
+        case CaptureEventType::Progress:
+            radio->capture_progress = (ev.bytes * 100) / BITMAP_SIZE;
+            UpdateLiveTextures(*radio, ev.frame, ev.bytes);
+            g_state.live_session = radio->session;
+            break;
+        case CaptureEventType::Frame:
+            RecordFrame(*radio, ev.frame);
+            if (!HandleDuplicate(*radio, ev.frame, ev.hash)) {
+                AddScreenshot(*radio, ev.frame, ev.hash);
+            } else if (!radio->is_bursting) {
+                snprintf(g_state.status_message, sizeof(g_state.status_message), "%s: screen unchanged, %s",
+                         radio->port, g_state.duplicate_mode == DuplicateMode::Fold ? "folded" : "dropped");
+            }
+            if (radio->is_bursting) {
+                radio->burst_frames++;
+                radio->capture_progress = 0;
+            } else {
+                radio->is_capturing = false;
+            }
+            break;
+        case CaptureEventType::Timeout:
+            snprintf(g_state.status_message, sizeof(g_state.status_message),
+                     "%s: timeout (%s), %d/%d bytes after %u ms", radio->port,
+                     CaptureTimeoutName(ev.timeout), ev.bytes, BITMAP_SIZE, ev.elapsed_ms);
+            DiscardLiveTextures(*radio);
+            if (!radio->is_bursting) radio->is_capturing = false;
+            break;
+        case CaptureEventType::Overlong:
             snprintf(g_state.status_message, sizeof(g_state.status_message),
-                     "Timeout: %d/%d bytes", g_state.capture_bytes, BITMAP_SIZE);
-            g_state.is_capturing = false;
+                     "%s: over-long response, %d extra bytes discarded", radio->port, ev.bytes);
+            break;
+        case CaptureEventType::BurstDone: {
+            double fps = ev.elapsed_ms ? ev.burst_frames * 1000.0 / ev.elapsed_ms : 0.0;
+            int n = snprintf(g_state.status_message, sizeof(g_state.status_message),
+                     "%s burst: %d frames (%d failed, %d unchanged) in %u ms, %.1f fps (link max %.1f fps)",
+                     radio->port, ev.burst_frames, ev.burst_failed, radio->duplicates, ev.elapsed_ms, fps,
+                     LinkMaxFps(radio->baud));
+            if (ev.burst_dropped > 0 && n > 0 && n < (int)sizeof(g_state.status_message)) {
+                snprintf(g_state.status_message + n, sizeof(g_state.status_message) - n,
+                         ", %d lost while the window was busy", ev.burst_dropped);
+            }
+            radio->is_bursting = false;
+            radio->is_capturing = false;
+            break;
+        }
+        case CaptureEventType::Error:
+            // The worker has already closed the session; it resumes when the port is back
+            LoseRadio(*radio);
+            snprintf(g_state.status_message, sizeof(g_state.status_message),
+                     "%s: serial I/O error, waiting for the device", radio->port);
+            break;
         }
     }
 }
@@ -535,41 +960,58 @@ bool BrowseForFolder(char* path, size_t pathSize, const char* startDir) {
     return result;
 }
 
-bool SaveScreenshot(Screenshot* ss, const char* directory) {
+// Shows (and by default exports) in preset `index`. Textures hold indices, so this is
+// only a shader uniform.
+static void SetPalette(int index) {
+    g_state.palette = index;
+    g_state.palette_shader.SetColors(PALETTE_PRESETS[index].light, PALETTE_PRESETS[index].dark);
+}
+
+static int ExportPalette() {
+    return g_state.export_palette < 0 ? g_state.palette : g_state.export_palette;
+}
+
+// Exports are written straight from the raw frame at export_scale, as 1-bit indexed PNGs
+// (png_writer.h). `png` is reused across a batch so Save All encodes into one buffer.
+bool SaveScreenshot(ScreenshotHandle ss, const char* directory, int scale, std::vector<uint8_t>& png) {
+    char name[256];
+    g_state.screenshots.Name(ss, name, sizeof(name));
     char filepath[MAX_PATH];
-    snprintf(filepath, sizeof(filepath), "%s\\%s.png", directory, ss->name);
+    snprintf(filepath, sizeof(filepath), "%s\\%s.png", directory, name);
 
-    int w = DISPLAY_WIDTH * PREVIEW_SCALE;
-    int h = DISPLAY_HEIGHT * PREVIEW_SCALE;
-    return stbi_write_png(filepath, w, h, 4, ss->rgba_preview, w * 4) != 0;
+    const PalettePreset& preset = PALETTE_PRESETS[ExportPalette()];
+    return WriteIndexedPng(filepath, g_state.screenshots.Frame(ss), scale, preset.light, preset.dark, png);
 }
 
-void SaveSelected() {
+void SaveSelected(int scale) {
     if (g_state.selected_screenshot < 0) return;
 
     char folder[MAX_PATH] = {0};
     if (BrowseForFolder(folder, sizeof(folder), g_state.last_save_directory)) {
         strncpy(g_state.last_save_directory, folder, sizeof(g_state.last_save_directory) - 1);
-        Screenshot* ss = g_state.screenshots[g_state.selected_screenshot];
-        if (SaveScreenshot(ss, folder)) {
+        ScreenshotHandle ss = SelectedScreenshot();
+        std::vector<uint8_t> png;
+        if (SaveScreenshot(ss, folder, scale, png)) {
+            char name[256];
+            g_state.screenshots.Name(ss, name, sizeof(name));
             snprintf(g_state.status_message, sizeof(g_state.status_message),
-                     "Saved %s.png", ss->name);
+                     "Saved %s.png", name);
         } else {
             strcpy(g_state.status_message, "Failed to save file");
         }
     }
 }
 
-void CopyToClipboard() {
+void CopyToClipboard(int scale) {
     if (g_state.selected_screenshot < 0) return;
 
-    Screenshot* ss = g_state.screenshots[g_state.selected_screenshot];
-    int w = DISPLAY_WIDTH * PREVIEW_SCALE;
-    int h = DISPLAY_HEIGHT * PREVIEW_SCALE;
+    ScreenshotHandle ss = SelectedScreenshot();
+    int w = DISPLAY_WIDTH * scale;
+    int h = DISPLAY_HEIGHT * scale;
 
-    // Calculate DIB size (BGR, 24-bit, DWORD-aligned rows)
-    int rowBytes = ((w * 3 + 3) / 4) * 4;
-    size_t dibSize = sizeof(BITMAPINFOHEADER) + rowBytes * h;
+    // Calculate DIB size (BGRX, 32-bit, so rows need no padding)
+    int rowBytes = w * 4;
+    size_t dibSize = sizeof(BITMAPINFOHEADER) + (size_t)rowBytes * h;
 
     HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, dibSize);
     if (!hMem) {
@@ -591,21 +1033,14 @@ void CopyToClipboard() {
     bih->biWidth = w;
     bih->biHeight = h;  // Positive = bottom-up DIB
     bih->biPlanes = 1;
-    bih->biBitCount = 24;
+    bih->biBitCount = 32;
     bih->biCompression = BI_RGB;
 
-    // Convert RGBA to BGR and flip vertically
+    // Rendered straight into the DIB in the palette's BGRX table; a negative stride from
+    // the last row flips it
     uint8_t* pixels = pMem + sizeof(BITMAPINFOHEADER);
-    for (int y = 0; y < h; y++) {
-        int srcY = h - 1 - y;  // Flip: DIB is bottom-up
-        for (int x = 0; x < w; x++) {
-            int srcIdx = (srcY * w + x) * 4;
-            int dstIdx = y * rowBytes + x * 3;
-            pixels[dstIdx + 0] = ss->rgba_preview[srcIdx + 2];  // B
-            pixels[dstIdx + 1] = ss->rgba_preview[srcIdx + 1];  // G
-            pixels[dstIdx + 2] = ss->rgba_preview[srcIdx + 0];  // R
-        }
-    }
+    DecodeFrameScaled(g_state.screenshots.Frame(ss), scale, pixels + (size_t)rowBytes * (h - 1), -(ptrdiff_t)rowBytes,
+                      GetPaletteBgrxLut(ExportPalette()));
 
     GlobalUnlock(hMem);
 
@@ -617,8 +1052,10 @@ void CopyToClipboard() {
 
     EmptyClipboard();
     if (SetClipboardData(CF_DIB, hMem)) {
+        char name[256];
+        g_state.screenshots.Name(ss, name, sizeof(name));
         snprintf(g_state.status_message, sizeof(g_state.status_message),
-                 "Copied %s to clipboard", ss->name);
+                 "Copied %s to clipboard", name);
     } else {
         GlobalFree(hMem);
         strcpy(g_state.status_message, "Failed to set clipboard data");
@@ -626,53 +1063,241 @@ void CopyToClipboard() {
     CloseClipboard();
 }
 
-void SaveAll() {
-    if (g_state.screenshots.empty()) return;
+void SaveAll(int scale) {
+    if (g_state.screenshots.Empty()) return;
 
     char folder[MAX_PATH] = {0};
     if (BrowseForFolder(folder, sizeof(folder), g_state.last_save_directory)) {
         strncpy(g_state.last_save_directory, folder, sizeof(g_state.last_save_directory) - 1);
         int saved = 0;
-        for (Screenshot* ss : g_state.screenshots) {
-            if (SaveScreenshot(ss, folder)) saved++;
+        size_t count = g_state.screenshots.Count();
+        std::vector<uint8_t> png;
+        for (size_t i = 0; i < count; i++) {
+            if (SaveScreenshot(g_state.screenshots.At(i), folder, scale, png)) saved++;
         }
         snprintf(g_state.status_message, sizeof(g_state.status_message),
-                 "Saved %d/%d screenshots", saved, (int)g_state.screenshots.size());
+                 "Saved %d/%d screenshots", saved, (int)count);
     }
 }
 
 void DeleteSelected() {
     if (g_state.selected_screenshot < 0) return;
 
-    delete g_state.screenshots[g_state.selected_screenshot];
-    g_state.screenshots.erase(g_state.screenshots.begin() + g_state.selected_screenshot);
+    ScreenshotHandle ss = SelectedScreenshot();
+    g_state.archive.MarkDeleted(g_state.screenshots.ArchiveIndex(ss));
+    DeleteTextures(ss);
+    g_state.screenshots.RemoveAt((size_t)g_state.selected_screenshot);
 
-    if (g_state.selected_screenshot >= (int)g_state.screenshots.size()) {
-        g_state.selected_screenshot = (int)g_state.screenshots.size() - 1;
+    int count = (int)g_state.screenshots.Count();
+    SelectScreenshot(g_state.selected_screenshot < count ? g_state.selected_screenshot : count - 1);
+}
+
+// Frees every screenshot; the archive keeps them for the next run
+static void ReleaseScreenshots() {
+    for (size_t i = 0; i < g_state.screenshots.Count(); i++) {
+        DeleteTextures(g_state.screenshots.At(i));
     }
+    g_state.screenshots.Clear();
+    SelectScreenshot(-1);
+}
 
-    if (g_state.selected_screenshot >= 0) {
-        strcpy(g_state.rename_buffer, g_state.screenshots[g_state.selected_screenshot]->name);
+void ClearAll() {
+    ReleaseScreenshots();
+    g_state.archive.Clear();
+}
+
+// =============================================================================
+// Recording
+// =============================================================================
+
+bool BrowseForRecording(char* path, size_t pathSize, const char* startDir) {
+    CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+
+    IFileDialog* pfd = nullptr;
+    bool result = false;
+
+    if (SUCCEEDED(CoCreateInstance(CLSID_FileOpenDialog, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&pfd)))) {
+        COMDLG_FILTERSPEC filter = { L"RadShot recordings", L"*.rsrec" };
+        pfd->SetFileTypes(1, &filter);
+        DWORD options;
+        pfd->GetOptions(&options);
+        pfd->SetOptions(options | FOS_FILEMUSTEXIST);
+
+        if (startDir && startDir[0] != 0) {
+            wchar_t wpath[MAX_PATH];
+            MultiByteToWideChar(CP_UTF8, 0, startDir, -1, wpath, MAX_PATH);
+            IShellItem* psiFolder;
+            if (SUCCEEDED(SHCreateItemFromParsingName(wpath, nullptr, IID_PPV_ARGS(&psiFolder)))) {
+                pfd->SetFolder(psiFolder);
+                psiFolder->Release();
+            }
+        }
+
+        if (SUCCEEDED(pfd->Show(g_state.hwnd))) {
+            IShellItem* psi;
+            if (SUCCEEDED(pfd->GetResult(&psi))) {
+                PWSTR pszPath;
+                if (SUCCEEDED(psi->GetDisplayName(SIGDN_FILESYSPATH, &pszPath))) {
+                    WideCharToMultiByte(CP_UTF8, 0, pszPath, -1, path, (int)pathSize, nullptr, nullptr);
+                    CoTaskMemFree(pszPath);
+                    result = true;
+                }
+                psi->Release();
+            }
+        }
+        pfd->Release();
+    }
+
+    CoUninitialize();
+    return result;
+}
+
+// Starts recording the radio the preview follows (or the first one) into the save folder
+void StartRecording() {
+    Radio* radio = FindRadio(g_state.live_session);
+    for (size_t i = 0; !radio && i < g_state.radios.size(); i++) {
+        if (!g_state.radios[i].lost) radio = &g_state.radios[i];
+    }
+    if (!radio) return;
+
+    if (g_state.last_save_directory[0] == 0) {
+        char folder[MAX_PATH] = {0};
+        if (!BrowseForFolder(folder, sizeof(folder), nullptr)) return;
+        strncpy(g_state.last_save_directory, folder, sizeof(g_state.last_save_directory) - 1);
+    }
+
+    SYSTEMTIME now;
+    GetLocalTime(&now);
+    snprintf(g_state.recording_path, sizeof(g_state.recording_path), "%s\\recording_%04d%02d%02d_%02d%02d%02d.rsrec",
+             g_state.last_save_directory, now.wYear, now.wMonth, now.wDay, now.wHour, now.wMinute, now.wSecond);
+
+    ArchiveTime start;
+    memcpy(&start, &now, sizeof(start));
+    std::string error;
+    if (!g_state.recorder.Open(g_state.recording_path, start, radio->port, error)) {
+        snprintf(g_state.status_message, sizeof(g_state.status_message), "Recording failed: %s", error.c_str());
+        return;
+    }
+    strncpy(g_state.recording_port, radio->port, sizeof(g_state.recording_port) - 1);
+    g_state.recording_start = GetTickCount64();
+    snprintf(g_state.status_message, sizeof(g_state.status_message), "Recording %s to %s",
+             radio->port, g_state.recording_path);
+}
+
+void StopRecording() {
+    if (!g_state.recorder.IsOpen()) return;
+    uint32_t frames = g_state.recorder.Frames();
+    uint64_t bytes = g_state.recorder.Bytes();
+    if (g_state.recorder.Close()) {
+        snprintf(g_state.status_message, sizeof(g_state.status_message),
+                 "Recorded %u frames to %s (%.1f KB, %.1fx smaller than raw)", frames, g_state.recording_path,
+                 bytes / 1024.0, bytes ? (double)frames * BITMAP_SIZE / bytes : 0.0);
     } else {
-        g_state.rename_buffer[0] = 0;
+        snprintf(g_state.status_message, sizeof(g_state.status_message),
+                 "Recording write failed: %s", g_state.recording_path);
     }
+    g_state.recording_port[0] = 0;
 }
 
-void ClearAll() {
-    for (Screenshot* ss : g_state.screenshots) {
-        delete ss;
+void CloseRecording() {
+    g_state.player.Close();
+    if (g_state.player_texture) glDeleteTextures(1, &g_state.player_texture);
+    g_state.player_texture = 0;
+    g_state.player_shown = -1;
+}
+
+void OpenRecording() {
+    char path[MAX_PATH] = {0};
+    if (!BrowseForRecording(path, sizeof(path), g_state.last_save_directory)) return;
+
+    CloseRecording();
+    std::string error;
+    if (!g_state.player.Open(path, error)) {
+        snprintf(g_state.status_message, sizeof(g_state.status_message), "Cannot open recording: %s", error.c_str());
+        return;
+    }
+    g_state.player_frame = 0;
+    uint32_t seconds = g_state.player.DurationMs() / 1000;
+    snprintf(g_state.status_message, sizeof(g_state.status_message), "Opened recording: %u frames over %u:%02u:%02u%s",
+             g_state.player.Count(), seconds / 3600, seconds / 60 % 60, seconds % 60,
+             g_state.player.Recovered() ? " (unfinished, index rebuilt)" : "");
+}
+
+// Decodes player_frame into player_texture if it isn't there already
+static void ShowPlayerFrame() {
+    if (g_state.player_shown == g_state.player_frame) return;
+    if (!g_state.player.Read((uint32_t)g_state.player_frame, g_state.player_raw)) {
+        snprintf(g_state.status_message, sizeof(g_state.status_message),
+                 "Recording damaged at frame %d", g_state.player_frame);
+        memset(g_state.player_raw, 0, sizeof(g_state.player_raw));
     }
-    g_state.screenshots.clear();
-    g_state.selected_screenshot = -1;
-    g_state.rename_buffer[0] = 0;
+    uint8_t index[Rt4dDecoder::INDEX_BYTES];
+    DecodeFrameIndex(g_state.player_raw, index);
+    if (!g_state.player_texture) {
+        g_state.player_texture = CreateTexture(index, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, g_state.player_texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, GL_RED, GL_UNSIGNED_BYTE, index);
+    }
+    g_state.player_shown = g_state.player_frame;
+}
+
+// Copies the frame shown into the gallery, stamped with its recorded time
+void AddPlayerFrame() {
+    uint32_t timeMs = 0;
+    if (!g_state.player.Read((uint32_t)g_state.player_frame, g_state.player_raw, &timeMs)) return;
+
+    const RecordingHeader& header = g_state.player.Header();
+    SYSTEMTIME start;
+    memcpy(&start, &header.start, sizeof(start));
+    FILETIME ft;
+    SYSTEMTIME timestamp = start;
+    if (SystemTimeToFileTime(&start, &ft)) {
+        ULARGE_INTEGER t;
+        t.LowPart = ft.dwLowDateTime;
+        t.HighPart = ft.dwHighDateTime;
+        t.QuadPart += (ULONGLONG)timeMs * 10000;   // 100 ns units
+        ft.dwLowDateTime = t.LowPart;
+        ft.dwHighDateTime = t.HighPart;
+        FileTimeToSystemTime(&ft, &timestamp);
+    }
+    NewScreenshot(header.port, g_state.player_raw, HashFrame(g_state.player_raw), timestamp);
+    snprintf(g_state.status_message, sizeof(g_state.status_message),
+             "Added frame %d as %s", g_state.player_frame, g_state.rename_buffer);
 }
 
 // =============================================================================
 // UI Rendering
 // =============================================================================
 
+static const GalleryLabel& GetGalleryLabel(ScreenshotHandle h, float thumbW) {
+    ScreenshotStore& store = g_state.screenshots;
+    if (g_state.gallery_labels.size() <= h.slot) g_state.gallery_labels.resize(h.slot + 1);
+    GalleryLabel& label = g_state.gallery_labels[h.slot];
+    if (label.generation == h.generation && label.revision == store.Revision(h)) return label;
+
+    // Truncate long names
+    char name[256];
+    if (store.Name(h, name, sizeof(name)) > 15) {
+        strncpy(label.text, name, 12);
+        strcpy(label.text + 12, "...");
+    } else {
+        strcpy(label.text, name);
+    }
+    if (store.RepeatCount(h) > 1) {
+        size_t len = strlen(label.text);
+        snprintf(label.text + len, sizeof(label.text) - len, " x%d", store.RepeatCount(h));
+    }
+    float offset = (thumbW - ImGui::CalcTextSize(label.text).x) * 0.5f;
+    label.offset = offset > 0 ? offset : 0.0f;
+    label.generation = h.generation;
+    label.revision = store.Revision(h);
+    return label;
+}
+
 void RenderUI() {
     ImGuiIO& io = ImGui::GetIO();
+    g_state.texture_lru.NextFrame();
 
     // Full window
     ImGui::SetNextWindowPos(ImVec2(0, 0));
@@ -691,12 +1316,25 @@ void RenderUI() {
         const char* preview = g_state.selected_port >= 0 ?
             g_state.com_ports[g_state.selected_port].c_str() : "Select...";
 
-        ImGui::BeginDisabled(g_state.is_connected);
+        bool probing = g_state.baud_prober.IsRunning() || g_state.radio_finder.IsRunning();
+        bool portConnected = g_state.selected_port >= 0 &&
+            IsPortConnected(g_state.com_ports[g_state.selected_port]);
+        ImGui::BeginDisabled(probing);
         if (ImGui::BeginCombo("##port", preview)) {
             for (int i = 0; i < (int)g_state.com_ports.size(); i++) {
                 bool selected = (i == g_state.selected_port);
-                if (ImGui::Selectable(g_state.com_ports[i].c_str(), selected)) {
+                // Ports the last Find got a valid frame from are marked with their latency
+                char label[64];
+                const PortProbeResult* found = FoundPort(g_state.com_ports[i]);
+                if (found && found->outcome == ProbeOutcome::Frame) {
+                    snprintf(label, sizeof(label), "%s  (radio, %u ms)##%d",
+                             g_state.com_ports[i].c_str(), found->latency_ms, i);
+                } else {
+                    snprintf(label, sizeof(label), "%s##%d", g_state.com_ports[i].c_str(), i);
+                }
+                if (ImGui::Selectable(label, selected)) {
                     g_state.selected_port = i;
+                    g_state.baud_rate = GetPortBaud(g_state.com_ports[i].c_str());
                 }
             }
             ImGui::EndCombo();
@@ -704,48 +1342,171 @@ void RenderUI() {
         ImGui::EndDisabled();
 
         ImGui::SameLine();
-        ImGui::BeginDisabled(g_state.is_connected);
+        ImGui::BeginDisabled(probing);
         if (ImGui::Button("Refresh")) {
-            EnumerateComPorts();
-            g_state.selected_port = -1;
+            g_state.device_watcher.Refresh();
         }
-        ImGui::EndDisabled();
 
         ImGui::SameLine();
-        if (!g_state.is_connected) {
-            ImGui::BeginDisabled(g_state.selected_port < 0);
-            if (ImGui::Button("Connect")) {
-                SerialConnect(g_state.com_ports[g_state.selected_port].c_str());
-            }
-            ImGui::EndDisabled();
-        } else {
-            if (ImGui::Button("Disconnect")) {
-                SerialDisconnect();
+        if (ImGui::Button("Find")) {
+            StartFindRadios();
+        }
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Ask every free port for a screenshot and pick the radio that answers");
+
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(80);
+        char baudLabel[16];
+        snprintf(baudLabel, sizeof(baudLabel), "%u", g_state.baud_rate);
+        if (ImGui::BeginCombo("##baud", baudLabel)) {
+            for (int i = 0; i < BAUD_RATE_COUNT; i++) {
+                snprintf(baudLabel, sizeof(baudLabel), "%u", BAUD_RATES[i]);
+                if (ImGui::Selectable(baudLabel, BAUD_RATES[i] == g_state.baud_rate)) {
+                    g_state.baud_rate = BAUD_RATES[i];
+                    if (g_state.selected_port >= 0) {
+                        SetPortBaud(g_state.com_ports[g_state.selected_port].c_str(), g_state.baud_rate);
+                    }
+                }
             }
+            ImGui::EndCombo();
         }
 
         ImGui::SameLine();
-        ImVec4 statusColor = g_state.is_connected ?
+        ImGui::BeginDisabled(g_state.selected_port < 0 || portConnected);
+        if (ImGui::Button("Auto")) {
+            StartBaudProbe();
+        }
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Find the fastest baud rate the radio answers at");
+        ImGui::EndDisabled();
+        ImGui::EndDisabled();
+
+        ImGui::SameLine();
+        ImGui::BeginDisabled(g_state.selected_port < 0 || portConnected || probing);
+        if (ImGui::Button("Connect")) {
+            SerialConnect(g_state.com_ports[g_state.selected_port].c_str());
+        }
+        ImGui::EndDisabled();
+
+        ImGui::SameLine();
+        ImVec4 statusColor = !g_state.radios.empty() ?
             ImVec4(0.0f, 0.8f, 0.0f, 1.0f) : ImVec4(0.5f, 0.5f, 0.5f, 1.0f);
         ImGui::TextColored(statusColor, "%s", g_state.status_message);
+
+        // Connected radios, each with its own session on the capture thread
+        int disconnect = -1;
+        for (int i = 0; i < (int)g_state.radios.size(); i++) {
+            const Radio& radio = g_state.radios[i];
+            ImGui::PushID(i);
+            if (ImGui::SmallButton("Disconnect")) disconnect = i;
+            ImGui::SameLine();
+            ImGui::Text("%s @ %u", radio.port, radio.baud);
+            if (radio.lost) {
+                ImGui::SameLine();
+                ImGui::TextColored(ImVec4(0.9f, 0.6f, 0.2f, 1.0f), "waiting for device");
+            } else if (radio.is_bursting) {
+                ImGui::SameLine();
+                ImGui::TextDisabled("burst, %d frames", radio.burst_frames);
+            } else if (radio.is_capturing) {
+                ImGui::SameLine();
+                ImGui::TextDisabled("capturing %d%%", radio.capture_progress);
+            }
+            ImGui::PopID();
+        }
+        if (disconnect >= 0) SerialDisconnect((size_t)disconnect);
     }
 
     // === Capture Section ===
     ImGui::Separator();
-    ImGui::BeginDisabled(!g_state.is_connected || g_state.is_capturing);
+    // Capture buttons act on every idle radio
+    bool anyIdle = false;
+    int bursting = 0;
+    int burstFrames = 0;
+    double linkMaxFps = 0.0;
+    double burstStart = 0.0;
+    for (const Radio& radio : g_state.radios) {
+        if (!radio.lost && !radio.is_capturing) anyIdle = true;
+        if (!radio.is_bursting) continue;
+        if (bursting == 0 || radio.burst_start_time < burstStart) burstStart = radio.burst_start_time;
+        bursting++;
+        burstFrames += radio.burst_frames;
+        linkMaxFps += LinkMaxFps(radio.baud);
+    }
+
+    ImGui::BeginDisabled(!anyIdle);
     if (ImGui::Button("Take Screenshot", ImVec2(150, 30))) {
         StartCapture();
     }
+    ImGui::SameLine();
+    if (ImGui::Button("Burst", ImVec2(80, 30))) {
+        StartBurst();
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(90);
+    ImGui::AlignTextToFramePadding();
+    if (ImGui::InputInt("##burstcount", &g_state.burst_count)) {
+        if (g_state.burst_count < 0) g_state.burst_count = 0;
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Frames per burst (0 = until stopped)");
     ImGui::EndDisabled();
 
-    if (g_state.is_capturing) {
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(70);
+    int duplicateMode = (int)g_state.duplicate_mode;
+    if (ImGui::Combo("##duplicates", &duplicateMode, DUPLICATE_MODE_NAMES, 3)) {
+        g_state.duplicate_mode = (DuplicateMode)duplicateMode;
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Unchanged frames: keep each one, drop it, or fold it into the previous screenshot as a repeat");
+    }
+
+    ImGui::SameLine();
+    bool recording = g_state.recorder.IsOpen();
+    if (ImGui::Checkbox("Record", &recording)) {
+        if (recording) StartRecording();
+        else StopRecording();
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Write every frame from the previewed radio to a compact recording in the save folder");
+    }
+    if (g_state.recorder.IsOpen()) {
+        ImGui::SameLine();
+        if (g_state.recorder.Failed()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "write failed");
+        } else {
+            ImGui::Text("%u frames, %.1f KB", g_state.recorder.Frames(), g_state.recorder.Bytes() / 1024.0);
+        }
+    }
+
+    if (bursting > 0) {
+        ImGui::SameLine();
+        if (ImGui::Button("Stop", ImVec2(80, 30))) {
+            StopBurst();
+        }
+        double elapsed = ImGui::GetTime() - burstStart;
+        ImGui::SameLine();
+        ImGui::Text("Burst: %d frames, %.1f fps (link max %.1f fps)", burstFrames,
+            elapsed > 0.0 ? burstFrames / elapsed : 0.0, linkMaxFps);
+    } else if (AnyRadioCapturing()) {
         ImGui::SameLine();
-        ImGui::Text("Capturing... %d%%", g_state.capture_progress);
+        ImGui::Text("Capturing...");
     }
 
     // === Gallery Section ===
     ImGui::Separator();
-    ImGui::Text("Screenshots (%d captured)", (int)g_state.screenshots.size());
+    ImGui::Text("Screenshots (%d captured)", (int)g_state.screenshots.Count());
+    ImGui::SameLine();
+    ImGui::TextDisabled("%.1f KB frames (%d archived), %.1f/%d MB textures",
+        (g_state.screenshots.MetadataBytes() + g_state.screenshots.FramePoolBytes()) / 1024.0,
+        (int)g_state.archive.Committed(),
+        g_state.texture_lru.ResidentBytes() / 1048576.0, (int)(g_state.texture_lru.Budget() >> 20));
+    if (g_state.archive.Failed()) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Session archive write failed");
+    }
+    if (g_state.palette_shader.Failed()) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Palette shader unavailable");
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s", g_state.palette_shader.Error().c_str());
+    }
 
     ImGui::BeginChild("Gallery", ImVec2(0, 180), true,
         ImGuiWindowFlags_HorizontalScrollbar);
@@ -753,45 +1514,100 @@ void RenderUI() {
     float thumbW = (float)DISPLAY_WIDTH;
     float thumbH = (float)DISPLAY_HEIGHT;
 
-    for (int i = 0; i < (int)g_state.screenshots.size(); i++) {
-        if (i % GALLERY_COLUMNS != 0) ImGui::SameLine();
-
-        Screenshot* ss = g_state.screenshots[i];
-        ImGui::BeginGroup();
+    // Only the rows in view are laid out; the clipper skips the rest by height.
+    // Thumbnails go to their own draw channel so those sharing an atlas page merge into
+    // one draw call instead of alternating with the frames and labels.
+    ScreenshotStore& store = g_state.screenshots;
+    const ImGuiStyle& style = ImGui::GetStyle();
+    ImVec2 pad = style.FramePadding;
+    float rowHeight = thumbH + pad.y * 2 + style.ItemSpacing.y * 2 + ImGui::GetTextLineHeight();
+    int count = (int)store.Count();
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->ChannelsSplit(2);
+    drawList->ChannelsSetCurrent(1);
+    drawList->AddCallback(UsePaletteShader, nullptr);
+    drawList->ChannelsSetCurrent(0);
+    ImGuiListClipper clipper;
+    clipper.Begin((count + GALLERY_COLUMNS - 1) / GALLERY_COLUMNS, rowHeight);
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+            for (int col = 0; col < GALLERY_COLUMNS; col++) {
+                int i = row * GALLERY_COLUMNS + col;
+                if (i >= count) break;
+                if (col != 0) ImGui::SameLine();
+
+                ScreenshotHandle ss = store.At((size_t)i);
+                ImGui::BeginGroup();
+
+                // Thumbnails are uploaded when scrolled into view and kept while they stay there
+                if (ImGui::IsRectVisible(ImVec2(thumbW, thumbH))) EnsureTextures(ss, false);
+
+                // Drawn like an ImageButton: frame in channel 0, thumbnail in channel 1
+                ImVec2 pos = ImGui::GetCursorScreenPos();
+                ImVec2 size(thumbW + pad.x * 2, thumbH + pad.y * 2);
+                ImGui::PushID(i);
+                ImGui::PushItemFlag(ImGuiItemFlags_NoNav, true);   // Arrow keys move the selection instead
+                if (ImGui::InvisibleButton("##thumb", size)) {
+                    SelectScreenshot(i);
+                }
+                ImGui::PopItemFlag();
+                ImGui::PopID();
+
+                bool selected = (i == g_state.selected_screenshot);
+                bool hovered = ImGui::IsItemHovered();
+                ImU32 frameColor;
+                if (selected) {
+                    frameColor = ImGui::GetColorU32(hovered ? ImVec4(0.4f, 0.6f, 0.9f, 1.0f) : ImVec4(0.3f, 0.5f, 0.8f, 1.0f));
+                } else {
+                    frameColor = ImGui::GetColorU32(ImGui::IsItemActive() ? ImGuiCol_ButtonActive
+                                                    : hovered ? ImGuiCol_ButtonHovered : ImGuiCol_Button);
+                }
+                drawList->AddRectFilled(pos, ImVec2(pos.x + size.x, pos.y + size.y), frameColor, style.FrameRounding);
+                uint32_t cell = store.ThumbCell(ss);
+                if (cell) {
+                    ImVec2 uv0, uv1;
+                    g_state.thumb_atlas.UV(cell, uv0.x, uv0.y, uv1.x, uv1.y);
+                    drawList->ChannelsSetCurrent(1);
+                    drawList->AddImage((ImTextureID)(intptr_t)g_state.atlas_pages[g_state.thumb_atlas.Page(cell)],
+                                       ImVec2(pos.x + pad.x, pos.y + pad.y),
+                                       ImVec2(pos.x + pad.x + thumbW, pos.y + pad.y + thumbH), uv0, uv1);
+                    drawList->ChannelsSetCurrent(0);
+                }
 
-        bool selected = (i == g_state.selected_screenshot);
-        if (selected) {
-            ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.3f, 0.5f, 0.8f, 1.0f));
-            ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.4f, 0.6f, 0.9f, 1.0f));
-        }
+                const GalleryLabel& label = GetGalleryLabel(ss, thumbW);
+                if (label.offset > 0) ImGui::SetCursorPosX(ImGui::GetCursorPosX() + label.offset);
+                ImGui::TextUnformatted(label.text);
 
-        ImGui::PushID(i);
-        if (ImGui::ImageButton("##thumb", (ImTextureID)(intptr_t)ss->texture_thumb,
-                               ImVec2(thumbW, thumbH))) {
-            g_state.selected_screenshot = i;
-            strcpy(g_state.rename_buffer, ss->name);
-        }
-        ImGui::PopID();
-
-        if (selected) {
-            ImGui::PopStyleColor(2);
+                ImGui::EndGroup();
+            }
         }
-
-        // Truncate long names
-        char displayName[20];
-        if (strlen(ss->name) > 15) {
-            strncpy(displayName, ss->name, 12);
-            strcpy(displayName + 12, "...");
-        } else {
-            strcpy(displayName, ss->name);
+    }
+    clipper.End();
+    drawList->ChannelsSetCurrent(1);
+    drawList->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+    drawList->ChannelsMerge();
+
+    // Arrow keys step the selection through the gallery while it has focus
+    if (ImGui::IsWindowFocused() && count > 0) {
+        int step = 0;
+        if (ImGui::IsKeyPressed(ImGuiKey_LeftArrow)) step = -1;
+        if (ImGui::IsKeyPressed(ImGuiKey_RightArrow)) step = 1;
+        if (ImGui::IsKeyPressed(ImGuiKey_UpArrow)) step = -GALLERY_COLUMNS;
+        if (ImGui::IsKeyPressed(ImGuiKey_DownArrow)) step = GALLERY_COLUMNS;
+        if (step != 0) {
+            int pos = g_state.selected_screenshot < 0 ? 0 : g_state.selected_screenshot + step;
+            pos = pos < 0 ? 0 : (pos >= count ? count - 1 : pos);
+            SelectScreenshot(pos);
+
+            // Scroll its row into view
+            float top = (pos / GALLERY_COLUMNS) * rowHeight;
+            float view = ImGui::GetWindowHeight() - style.WindowPadding.y * 2;
+            if (top < ImGui::GetScrollY()) {
+                ImGui::SetScrollY(top);
+            } else if (top + rowHeight > ImGui::GetScrollY() + view) {
+                ImGui::SetScrollY(top + rowHeight - view);
+            }
         }
-
-        float textW = ImGui::CalcTextSize(displayName).x;
-        float offset = (thumbW - textW) * 0.5f;
-        if (offset > 0) ImGui::SetCursorPosX(ImGui::GetCursorPosX() + offset);
-        ImGui::TextUnformatted(displayName);
-
-        ImGui::EndGroup();
     }
 
     ImGui::EndChild();
@@ -799,8 +1615,19 @@ void RenderUI() {
     // === Selected Screenshot Section ===
     ImGui::Separator();
     if (g_state.selected_screenshot >= 0) {
-        Screenshot* ss = g_state.screenshots[g_state.selected_screenshot];
-        ImGui::Text("Selected: %s", ss->name);
+        ScreenshotHandle ss = SelectedScreenshot();
+        char name[256];
+        store.Name(ss, name, sizeof(name));
+        ImGui::Text("Selected: %s", name);
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Frame hash %016llx", (unsigned long long)store.Hash(ss));
+        if (store.Port(ss)[0]) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(%s)", store.Port(ss));
+        }
+        if (store.RepeatCount(ss) > 1) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("x%d", store.RepeatCount(ss));
+        }
 
         ImGui::SetNextItemWidth(200);
         ImGui::InputText("##rename", g_state.rename_buffer, sizeof(g_state.rename_buffer));
@@ -808,7 +1635,8 @@ void RenderUI() {
         ImGui::SameLine();
         if (ImGui::Button("Rename")) {
             if (strlen(g_state.rename_buffer) > 0) {
-                strcpy(ss->name, g_state.rename_buffer);
+                store.SetName(ss, g_state.rename_buffer);
+                g_state.archive.SetName(store.ArchiveIndex(ss), g_state.rename_buffer);
             }
         }
 
@@ -819,12 +1647,12 @@ void RenderUI() {
 
         ImGui::SameLine();
         if (ImGui::Button("Save")) {
-            SaveSelected();
+            SaveSelected(g_state.export_scale);
         }
 
         ImGui::SameLine();
         if (ImGui::Button("Copy")) {
-            CopyToClipboard();
+            CopyToClipboard(g_state.export_scale);
         }
     } else {
         ImGui::TextDisabled("No screenshot selected");
@@ -833,28 +1661,92 @@ void RenderUI() {
     // === Preview Section ===
     ImGui::Separator();
     ImGui::Text("Preview");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(140);
+    if (ImGui::BeginCombo("Palette", PALETTE_PRESETS[g_state.palette].name)) {
+        for (int i = 0; i < PALETTE_COUNT; i++) {
+            if (ImGui::Selectable(PALETTE_PRESETS[i].name, i == g_state.palette)) SetPalette(i);
+        }
+        ImGui::EndCombo();
+    }
 
-    if (g_state.selected_screenshot >= 0) {
-        Screenshot* ss = g_state.screenshots[g_state.selected_screenshot];
-        int previewW = DISPLAY_WIDTH * PREVIEW_SCALE;
-        int previewH = DISPLAY_HEIGHT * PREVIEW_SCALE;
-        ImGui::Image((ImTextureID)(intptr_t)ss->texture_preview,
+    int previewW = Rt4dDecoder::PREVIEW_WIDTH;
+    int previewH = Rt4dDecoder::PREVIEW_HEIGHT;
+    Radio* live = FindRadio(g_state.live_session);
+    if (live && live->live_bands > 0) {
+        // Capture in progress: show the frame filling in
+        PaletteImage(live->live_preview,
+                     ImVec2((float)previewW, (float)previewH));
+    } else if (g_state.player.IsOpen() && g_state.player.Count() > 0) {
+        ShowPlayerFrame();
+        PaletteImage(g_state.player_texture,
+                     ImVec2((float)previewW, (float)previewH));
+    } else if (g_state.selected_screenshot >= 0) {
+        ScreenshotHandle ss = SelectedScreenshot();
+        EnsureTextures(ss, true);
+        PaletteImage(g_state.screenshots.TexturePreview(ss),
                      ImVec2((float)previewW, (float)previewH));
     } else {
         ImGui::TextDisabled("Take a screenshot to see preview");
     }
 
+    // Recording playback: page through frames with the slider or arrow buttons
+    if (g_state.player.IsOpen()) {
+        int last = (int)g_state.player.Count() - 1;
+        if (ImGui::ArrowButton("##prevframe", ImGuiDir_Left) && g_state.player_frame > 0) g_state.player_frame--;
+        ImGui::SameLine();
+        if (ImGui::ArrowButton("##nextframe", ImGuiDir_Right) && g_state.player_frame < last) g_state.player_frame++;
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(260);
+        ImGui::BeginDisabled(last < 0);
+        ImGui::SliderInt("##playerframe", &g_state.player_frame, 0, last < 0 ? 0 : last, "Frame %d");
+        ImGui::SameLine();
+        if (ImGui::Button("Add to Gallery")) {
+            AddPlayerFrame();
+        }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        if (ImGui::Button("Close Recording")) {
+            CloseRecording();
+        }
+    }
+
     // === Bottom Buttons ===
     ImGui::Separator();
-    ImGui::BeginDisabled(g_state.screenshots.empty());
+    ImGui::BeginDisabled(g_state.screenshots.Empty());
     if (ImGui::Button("Save All")) {
-        SaveAll();
+        SaveAll(g_state.export_scale);
     }
     ImGui::SameLine();
     if (ImGui::Button("Clear All")) {
         g_state.show_clear_popup = true;
     }
     ImGui::EndDisabled();
+    ImGui::SameLine();
+    if (ImGui::Button("Open Recording...")) {
+        OpenRecording();
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(140);
+    const char* exportName = g_state.export_palette < 0 ? "As shown" : PALETTE_PRESETS[g_state.export_palette].name;
+    if (ImGui::BeginCombo("Export palette", exportName)) {
+        if (ImGui::Selectable("As shown", g_state.export_palette < 0)) g_state.export_palette = -1;
+        for (int i = 0; i < PALETTE_COUNT; i++) {
+            if (ImGui::Selectable(PALETTE_PRESETS[i].name, i == g_state.export_palette)) g_state.export_palette = i;
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(60);
+    char scaleName[8];
+    snprintf(scaleName, sizeof(scaleName), "%dx", g_state.export_scale);
+    if (ImGui::BeginCombo("Scale", scaleName)) {
+        for (int scale : EXPORT_SCALES) {
+            snprintf(scaleName, sizeof(scaleName), "%dx", scale);
+            if (ImGui::Selectable(scaleName, scale == g_state.export_scale)) g_state.export_scale = scale;
+        }
+        ImGui::EndCombo();
+    }
 
     ImGui::End();
 
@@ -865,7 +1757,9 @@ void RenderUI() {
     }
 
     if (ImGui::BeginPopupModal("Delete?", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
-        ImGui::Text("Delete '%s'?", g_state.screenshots[g_state.selected_screenshot]->name);
+        char name[256];
+        g_state.screenshots.Name(SelectedScreenshot(), name, sizeof(name));
+        ImGui::Text("Delete '%s'?", name);
         ImGui::Separator();
 
         if (ImGui::Button("Yes", ImVec2(80, 0))) {
@@ -905,7 +1799,7 @@ void RenderUI() {
     }
 
     if (ImGui::BeginPopupModal("Exit?", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
-        ImGui::Text("You have unsaved screenshots.\nExit anyway?");
+        ImGui::Text("This session isn't being saved.\nScreenshots you haven't saved will be lost.\nExit anyway?");
         ImGui::Separator();
 
         if (ImGui::Button("Yes", ImVec2(80, 0))) {
@@ -919,6 +1813,10 @@ void RenderUI() {
         }
         ImGui::EndPopup();
     }
+
+    // Everything drawn this frame has been touched; the rest may go
+    PrefetchPreviews();
+    TrimTextures();
 }
 
 // =============================================================================
@@ -982,7 +1880,8 @@ LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         return 0;
 
     case WM_CLOSE:
-        if (!g_state.screenshots.empty()) {
+        // Screenshots are only lost on exit when the session archive isn't recording them
+        if (!g_state.screenshots.Empty() && (!g_state.archive.IsOpen() || g_state.archive.Failed())) {
             g_state.show_exit_popup = true;
             g_state.pending_close = true;
             return 0;
@@ -1005,6 +1904,7 @@ LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
     // Load saved settings
     LoadSettings();
+    LoadArchive();
 
     // Load application icon from resources (ID 1 defined in radshot.rc)
     HICON hIcon = LoadIcon(hInstance, MAKEINTRESOURCE(1));
@@ -1058,20 +1958,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
     ImGui::StyleColorsDark();
 
     ImGui_ImplWin32_Init(g_state.hwnd);
-    ImGui_ImplOpenGL3_Init();
-
-    // Initial port enumeration
-    EnumerateComPorts();
+    ImGui_ImplOpenGL3_Init(GLSL_VERSION);
+    g_state.palette_shader.Load(GetGlProc, GLSL_VERSION);
+    SetPalette(g_state.palette);
 
-    // Restore saved COM port selection
-    if (g_state.last_port_name[0] != 0) {
-        for (int i = 0; i < (int)g_state.com_ports.size(); i++) {
-            if (g_state.com_ports[i] == g_state.last_port_name) {
-                g_state.selected_port = i;
-                break;
-            }
-        }
-    }
+    // Ports are enumerated on the watcher's thread; the first list restores the saved
+    // selection (see PollDeviceWatcher)
+    g_state.device_watcher.Start();
 
     // Main loop
     while (g_state.running) {
@@ -1086,8 +1979,11 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
 
         if (!g_state.running) break;
 
-        // Update capture
-        UpdateCapture();
+        // Pick up frames and progress from the capture thread
+        PollDeviceWatcher();
+        PollCaptureEvents();
+        PollBaudProbe();
+        PollFindRadios();
 
         // Start ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
@@ -1104,15 +2000,28 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         SwapBuffers(g_state.hdc);
+
+        // The palette shader is built by the first draw that uses it
+        if (g_state.palette_shader.Failed() && !g_state.palette_shader_reported) {
+            const char* error = g_state.palette_shader.Error().c_str();
+            snprintf(g_state.status_message, sizeof(g_state.status_message),
+                     "Palette shader failed, screenshots drawn in grey: %.*s", (int)strcspn(error, "\r\n"), error);
+            g_state.palette_shader_reported = true;
+        }
     }
 
     // Save settings before exiting
     SaveSettings();
 
     // Cleanup
-    ClearAll();
-    SerialDisconnect();
-
+    StopRecording();
+    CloseRecording();
+    DisconnectAll();
+    ReleaseScreenshots();
+    g_state.archive.Close();
+    ReleaseThumbAtlas();
+
+    g_state.palette_shader.Destroy();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplWin32_Shutdown();
     ImGui::DestroyContext();
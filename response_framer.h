@@ -0,0 +1,162 @@
+// RadShot - Response framing
+// Splits the serial byte stream into screenshot responses. The protocol has no header,
+// length or checksum, so boundaries come from the request itself and from gaps on the line:
+//  - bytes that arrive while no request is open are stale and dropped
+//  - a response is exactly BITMAP_SIZE bytes; bytes right behind it are an over-long tail
+//  - the next request is only written once the line has gone quiet (tail gap after a
+//    frame, a longer quiet period after an aborted one), so nothing received after a
+//    request can belong to the previous response
+// Portable header, driven with explicit timestamps so it can be exercised off-target.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "frame_decoder.h"
+
+enum class FramerState {
+    Idle,        // No request open; anything received is stale
+    Awaiting,    // Request written, no response bytes yet
+    Receiving,   // Response in progress
+    Trailing,    // Frame complete; bytes within the tail gap belong to it
+    Draining,    // Response aborted; discarding until the line is quiet
+};
+
+struct FramerStats {
+    uint64_t frames = 0;
+    uint64_t short_responses = 0;      // Aborted after some bytes arrived
+    uint64_t overlong_responses = 0;   // Frame followed by a tail
+    uint64_t stale_bytes = 0;          // Arrived with no request open
+    uint64_t discarded_bytes = 0;      // Tails and drained leftovers
+};
+
+class ResponseFramer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // tail_gap_ms: silence after a complete frame before the next request may go out.
+    //              Must cover the bridge's delivery granularity or a late tail is taken as stale.
+    // quiet_ms:    silence required after an aborted response before a new request may go out
+    void Configure(uint32_t tail_gap_ms, uint32_t quiet_ms) {
+        tail_gap_ = std::chrono::milliseconds(tail_gap_ms);
+        quiet_ = std::chrono::milliseconds(quiet_ms);
+    }
+
+    // Back to Idle, e.g. after a reconnect. Stats are kept.
+    void Reset() {
+        state_ = FramerState::Idle;
+        received_ = 0;
+        tail_bytes_ = 0;
+        pending_overlong_ = 0;
+    }
+
+    // True once the line is quiet and no request is open
+    bool CanOpen(Clock::time_point now) {
+        Tick(now);
+        return state_ == FramerState::Idle;
+    }
+
+    // A request has just been written (only after CanOpen)
+    void Open() {
+        received_ = 0;
+        state_ = FramerState::Awaiting;
+    }
+
+    // Abandons the open request (deadline expired). Whatever the radio still sends for it
+    // is drained. Returns the bytes it had received.
+    int Abort(Clock::time_point now) {
+        int got = received_;
+        if (got > 0) stats_.short_responses++;
+        received_ = 0;
+        state_ = FramerState::Draining;
+        last_byte_at_ = now;
+        return got;
+    }
+
+    // Feeds received bytes. Returns true when a full frame is ready in Frame().
+    // Bytes behind the frame in the same chunk go to its tail.
+    bool Feed(const uint8_t* data, size_t size, Clock::time_point now) {
+        Tick(now);
+        if (size == 0) return false;
+
+        switch (state_) {
+        case FramerState::Idle:
+            stats_.stale_bytes += size;
+            return false;
+        case FramerState::Trailing:
+            tail_bytes_ += (int)size;
+            stats_.discarded_bytes += size;
+            last_byte_at_ = now;
+            return false;
+        case FramerState::Draining:
+            stats_.discarded_bytes += size;
+            last_byte_at_ = now;
+            return false;
+        case FramerState::Awaiting:
+        case FramerState::Receiving:
+            break;
+        }
+
+        size_t need = (size_t)(BITMAP_SIZE - received_);
+        size_t take = size < need ? size : need;
+        memcpy(frame_ + received_, data, take);
+        received_ += (int)take;
+        last_byte_at_ = now;
+        state_ = FramerState::Receiving;
+        if (received_ < BITMAP_SIZE) return false;
+
+        stats_.frames++;
+        state_ = FramerState::Trailing;
+        tail_bytes_ = (int)(size - take);
+        stats_.discarded_bytes += size - take;
+        return true;
+    }
+
+    // Applies time-based transitions: closes tail windows and finishes draining
+    void Tick(Clock::time_point now) {
+        if (state_ == FramerState::Trailing && now - last_byte_at_ >= tail_gap_) {
+            if (tail_bytes_ > 0) {
+                stats_.overlong_responses++;
+                pending_overlong_ += tail_bytes_;
+            }
+            tail_bytes_ = 0;
+            state_ = FramerState::Idle;
+        } else if (state_ == FramerState::Draining && now - last_byte_at_ >= quiet_) {
+            state_ = FramerState::Idle;
+        }
+    }
+
+    // When the next Tick transition is due, or time_point::max() if none is pending
+    Clock::time_point NextDeadline() const {
+        if (state_ == FramerState::Trailing) return last_byte_at_ + tail_gap_;
+        if (state_ == FramerState::Draining) return last_byte_at_ + quiet_;
+        return Clock::time_point::max();
+    }
+
+    // Tail bytes of frames whose tail window has closed since the last call
+    int TakeOverlong() {
+        int bytes = pending_overlong_;
+        pending_overlong_ = 0;
+        return bytes;
+    }
+
+    FramerState State() const { return state_; }
+    int Received() const { return received_; }
+    Clock::time_point LastByteAt() const { return last_byte_at_; }
+    const uint8_t* Frame() const { return frame_; }
+    const FramerStats& Stats() const { return stats_; }
+
+private:
+    FramerState state_ = FramerState::Idle;
+    int received_ = 0;
+    int tail_bytes_ = 0;
+    int pending_overlong_ = 0;
+    Clock::time_point last_byte_at_;
+    Clock::duration tail_gap_ = std::chrono::milliseconds(5);
+    Clock::duration quiet_ = std::chrono::milliseconds(100);
+    FramerStats stats_;
+    uint8_t frame_[BITMAP_SIZE];
+};
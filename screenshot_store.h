@@ -0,0 +1,381 @@
+// RadShot - Screenshot store
+// The gallery's screenshots as parallel arrays (struct of arrays) indexed by slot, so a
+// pass over one field (ids, hashes, textures) reads only that field's memory. Frames
+// captured this run live in 64 KB blocks of a frame pool; archived ones point into the
+// session archive's mapping. Names and ports are interned: the default
+// "<prefix>_<number>" names share one string per prefix. An archived screenshot's name,
+// port, time and hash are read from its record when asked for, so adding one touches
+// none of the mapping.
+//
+// Handles (slot + generation) stay valid while the screenshot exists and go stale when
+// it is removed, so a kept handle can't reach a reused slot. Freed slots and frames go
+// on free lists and are reused in O(1). Gallery order is a separate array of slots, so
+// the gallery reaches any position in O(1); removing from it shifts the slots behind,
+// O(n) but only 4 bytes each (about 10 us at 100,000 screenshots), and the app removes
+// one screenshot per user action.
+// Portable header; textures and atlas cells are plain integers here.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "frame_decoder.h"
+#include "session_archive.h"
+
+constexpr size_t STORE_FRAME_BLOCK = 64;   // Frames per pool block (64 KB)
+constexpr uint32_t STORE_NO_STRING = UINT32_MAX;   // Name or port still in the archive record
+
+struct ScreenshotHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool IsNull() const { return slot == UINT32_MAX; }
+};
+
+inline bool operator==(const ScreenshotHandle& a, const ScreenshotHandle& b) {
+    return a.slot == b.slot && a.generation == b.generation;
+}
+
+// Reference-counted interned strings
+class StringPool {
+public:
+    // Returns the id for `text`, adding a reference
+    uint32_t Intern(const char* text) {
+        auto it = ids_.find(text);
+        if (it != ids_.end()) {
+            entries_[it->second].refs++;
+            return it->second;
+        }
+        uint32_t id;
+        if (!free_.empty()) {
+            id = free_.back();
+            free_.pop_back();
+            entries_[id].text = text;
+        } else {
+            id = (uint32_t)entries_.size();
+            entries_.push_back(Entry{ text, 0 });
+        }
+        entries_[id].refs = 1;
+        ids_.emplace(entries_[id].text, id);
+        return id;
+    }
+
+    void Release(uint32_t id) {
+        Entry& entry = entries_[id];
+        if (--entry.refs > 0) return;
+        ids_.erase(entry.text);
+        entry.text.clear();
+        entry.text.shrink_to_fit();
+        free_.push_back(id);
+    }
+
+    // Valid until the next Intern
+    const char* Get(uint32_t id) const { return entries_[id].text.c_str(); }
+
+    size_t Count() const { return ids_.size(); }
+
+    void Clear() {
+        entries_.clear();
+        ids_.clear();
+        free_.clear();
+    }
+
+private:
+    struct Entry {
+        std::string text;
+        uint32_t refs;
+    };
+    std::vector<Entry> entries_;
+    std::unordered_map<std::string, uint32_t> ids_;
+    std::vector<uint32_t> free_;
+};
+
+// ArchiveTime in one word: year 16 bits, then 4/3/5/5/6/6/10 for the rest
+inline uint64_t PackTime(const ArchiveTime& t) {
+    return ((uint64_t)t.year << 45) | ((uint64_t)(t.month & 15) << 41) | ((uint64_t)(t.day_of_week & 7) << 38) |
+           ((uint64_t)(t.day & 31) << 33) | ((uint64_t)(t.hour & 31) << 28) | ((uint64_t)(t.minute & 63) << 22) |
+           ((uint64_t)(t.second & 63) << 16) | ((uint64_t)(t.milliseconds & 1023) << 6);
+}
+
+inline ArchiveTime UnpackTime(uint64_t v) {
+    ArchiveTime t;
+    t.year = (uint16_t)(v >> 45);
+    t.month = (uint16_t)((v >> 41) & 15);
+    t.day_of_week = (uint16_t)((v >> 38) & 7);
+    t.day = (uint16_t)((v >> 33) & 31);
+    t.hour = (uint16_t)((v >> 28) & 31);
+    t.minute = (uint16_t)((v >> 22) & 63);
+    t.second = (uint16_t)((v >> 16) & 63);
+    t.milliseconds = (uint16_t)((v >> 6) & 1023);
+    return t;
+}
+
+class ScreenshotStore {
+public:
+    // Adds a screenshot at the end of the gallery order, copying the frame into the pool
+    ScreenshotHandle Add(int id, const char* name, const char* port, const ArchiveTime& time,
+                         uint64_t hash, int repeat_count, const uint8_t* frame) {
+        uint32_t slot = NewSlot(id, repeat_count);
+        AssignName(slot, name);
+        port_[slot] = strings_.Intern(port);
+        hash_[slot] = hash;
+        time_[slot] = PackTime(time);
+        uint32_t frameSlot = AllocFrame();
+        uint8_t* dst = FramePointer(frameSlot);
+        memcpy(dst, frame, BITMAP_SIZE);
+        frame_[slot] = dst;
+        frame_slot_[slot] = frameSlot;
+        return ScreenshotHandle{ slot, generation_[slot] };
+    }
+
+    // Adds a screenshot kept in an archive record (which must outlive it) at the end of
+    // the gallery order. Nothing is read from the record here.
+    ScreenshotHandle AddArchived(int id, const ArchiveRecord* record, int repeat_count) {
+        uint32_t slot = NewSlot(id, repeat_count);
+        record_[slot] = record;
+        frame_[slot] = record->frame;
+        return ScreenshotHandle{ slot, generation_[slot] };
+    }
+
+    // Removes the screenshot at gallery position `pos`. The slot and its frame go back on
+    // the free lists; the caller frees its textures first. O(n) in the positions behind it.
+    void RemoveAt(size_t pos) {
+        uint32_t slot = order_[pos];
+        Release(slot);
+        order_.erase(order_.begin() + pos);
+    }
+
+    // Removes everything. Slots are kept (with bumped generations, so old handles stay
+    // stale); the frame pool is freed.
+    void Clear() {
+        for (uint32_t slot : order_) Release(slot);
+        order_.clear();
+        frame_blocks_.clear();
+        free_frames_.clear();
+        frame_count_ = 0;
+    }
+
+    void Reserve(size_t count) {
+        generation_.reserve(count);
+        revision_.reserve(count);
+        id_.reserve(count);
+        name_.reserve(count);
+        name_number_.reserve(count);
+        port_.reserve(count);
+        hash_.reserve(count);
+        repeat_count_.reserve(count);
+        archive_index_.reserve(count);
+        time_.reserve(count);
+        record_.reserve(count);
+        frame_.reserve(count);
+        frame_slot_.reserve(count);
+        texture_preview_.reserve(count);
+        thumb_cell_.reserve(count);
+        order_.reserve(count);
+    }
+
+    // Gallery order
+    size_t Count() const { return order_.size(); }
+    bool Empty() const { return order_.empty(); }
+    ScreenshotHandle At(size_t pos) const {
+        uint32_t slot = order_[pos];
+        return ScreenshotHandle{ slot, generation_[slot] };
+    }
+
+    // False once the screenshot has been removed
+    bool Valid(ScreenshotHandle h) const {
+        return h.slot < generation_.size() && generation_[h.slot] == h.generation && !(h.generation & 1);
+    }
+
+    int Id(ScreenshotHandle h) const { return id_[h.slot]; }
+    const uint8_t* Frame(ScreenshotHandle h) const { return frame_[h.slot]; }
+    bool OwnsFrame(ScreenshotHandle h) const { return frame_slot_[h.slot] != UINT32_MAX; }
+    uint64_t Hash(ScreenshotHandle h) const {
+        const ArchiveRecord* record = record_[h.slot];
+        return record ? record->hash : hash_[h.slot];
+    }
+    const char* Port(ScreenshotHandle h) const {
+        const ArchiveRecord* record = record_[h.slot];
+        if (!record) return strings_.Get(port_[h.slot]);
+        // Written terminated; anything else is damage
+        return memchr(record->port, 0, sizeof(record->port)) ? record->port : "";
+    }
+    ArchiveTime Time(ScreenshotHandle h) const {
+        const ArchiveRecord* record = record_[h.slot];
+        return record ? record->timestamp : UnpackTime(time_[h.slot]);
+    }
+
+    int RepeatCount(ScreenshotHandle h) const { return repeat_count_[h.slot]; }
+    void SetRepeatCount(ScreenshotHandle h, int count) {
+        repeat_count_[h.slot] = count;
+        revision_[h.slot]++;
+    }
+
+    // Changes whenever the name or repeat count does, so views can cache what they derive
+    uint32_t Revision(ScreenshotHandle h) const { return revision_[h.slot]; }
+
+    int64_t ArchiveIndex(ScreenshotHandle h) const { return archive_index_[h.slot]; }
+    void SetArchiveIndex(ScreenshotHandle h, int64_t index) { archive_index_[h.slot] = index; }
+
+    // Writes the name into `out` (at most size - 1 characters) and returns its length
+    size_t Name(ScreenshotHandle h, char* out, size_t size) const {
+        if (name_[h.slot] == STORE_NO_STRING) {
+            // The record's own name, which may be torn by a crash mid-rename
+            const ArchiveRecord* record = record_[h.slot];
+            int len = snprintf(out, size, "%.*s", (int)sizeof(record->name) - 1, record->name);
+            if (len < 0) return 0;
+            return (size_t)len < size ? (size_t)len : size - 1;
+        }
+        const char* text = strings_.Get(name_[h.slot]);
+        int number = name_number_[h.slot];
+        int len = number < 0 ? snprintf(out, size, "%s", text) : snprintf(out, size, "%s_%03d", text, number);
+        if (len < 0) return 0;
+        return (size_t)len < size ? (size_t)len : size - 1;
+    }
+
+    void SetName(ScreenshotHandle h, const char* name) {
+        if (name_[h.slot] != STORE_NO_STRING) strings_.Release(name_[h.slot]);
+        AssignName(h.slot, name);
+        revision_[h.slot]++;
+    }
+
+    // Preview GL texture and thumbnail atlas cell (see thumb_atlas.h), 0 if not created
+    uint32_t TexturePreview(ScreenshotHandle h) const { return texture_preview_[h.slot]; }
+    uint32_t ThumbCell(ScreenshotHandle h) const { return thumb_cell_[h.slot]; }
+    void SetTextures(ScreenshotHandle h, uint32_t preview, uint32_t thumb) {
+        texture_preview_[h.slot] = preview;
+        thumb_cell_[h.slot] = thumb;
+    }
+
+    // Pooled frames in use, and bytes held by the pool and the metadata columns
+    size_t OwnedFrames() const { return frame_count_; }
+    size_t FramePoolBytes() const { return frame_blocks_.size() * STORE_FRAME_BLOCK * BITMAP_SIZE; }
+    size_t MetadataBytes() const { return generation_.size() * BYTES_PER_SLOT + order_.size() * sizeof(uint32_t); }
+    size_t InternedStrings() const { return strings_.Count(); }
+
+private:
+    static constexpr size_t BYTES_PER_SLOT =
+        sizeof(uint32_t) * 7 + sizeof(int) * 3 + sizeof(uint64_t) * 2 + sizeof(int64_t) + sizeof(const ArchiveRecord*) + sizeof(const uint8_t*);
+
+    // Default names keep their shared prefix once and the number inline. Only a name that
+    // prints back identically is split, so any name round-trips.
+    void AssignName(uint32_t slot, const char* name) {
+        size_t len = strlen(name);
+        size_t digits = 0;
+        while (digits < len && digits < 9 && name[len - 1 - digits] >= '0' && name[len - 1 - digits] <= '9') digits++;
+        if (digits >= 3 && len > digits + 1 && name[len - digits - 1] == '_' &&
+            (digits == 3 || name[len - digits] != '0')) {
+            std::string prefix(name, len - digits - 1);
+            name_[slot] = strings_.Intern(prefix.c_str());
+            name_number_[slot] = atoi(name + len - digits);
+            return;
+        }
+        name_[slot] = strings_.Intern(name);
+        name_number_[slot] = -1;
+    }
+
+    // Takes a free slot (or a new one) and puts it at the end of the gallery order, with
+    // no name, port or frame yet
+    uint32_t NewSlot(int id, int repeat_count) {
+        uint32_t slot;
+        if (!free_slots_.empty()) {
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+            generation_[slot]++;   // Even again: live
+        } else {
+            slot = (uint32_t)generation_.size();
+            generation_.push_back(0);
+            revision_.push_back(0);
+            id_.push_back(0);
+            name_.push_back(STORE_NO_STRING);
+            name_number_.push_back(0);
+            port_.push_back(STORE_NO_STRING);
+            hash_.push_back(0);
+            repeat_count_.push_back(0);
+            archive_index_.push_back(0);
+            time_.push_back(0);
+            record_.push_back(nullptr);
+            frame_.push_back(nullptr);
+            frame_slot_.push_back(UINT32_MAX);
+            texture_preview_.push_back(0);
+            thumb_cell_.push_back(0);
+        }
+
+        id_[slot] = id;
+        revision_[slot]++;
+        repeat_count_[slot] = repeat_count;
+        archive_index_[slot] = -1;
+        texture_preview_[slot] = 0;
+        thumb_cell_[slot] = 0;
+        order_.push_back(slot);
+        return slot;
+    }
+
+    // Odd generations mark free slots; removal bumps it so old handles go stale
+    void Release(uint32_t slot) {
+        if (name_[slot] != STORE_NO_STRING) strings_.Release(name_[slot]);
+        if (port_[slot] != STORE_NO_STRING) strings_.Release(port_[slot]);
+        if (frame_slot_[slot] != UINT32_MAX) {
+            free_frames_.push_back(frame_slot_[slot]);
+            frame_count_--;
+        }
+        name_[slot] = STORE_NO_STRING;
+        port_[slot] = STORE_NO_STRING;
+        record_[slot] = nullptr;
+        frame_[slot] = nullptr;
+        frame_slot_[slot] = UINT32_MAX;
+        generation_[slot]++;
+        free_slots_.push_back(slot);
+    }
+
+    uint32_t AllocFrame() {
+        frame_count_++;
+        if (!free_frames_.empty()) {
+            uint32_t frameSlot = free_frames_.back();
+            free_frames_.pop_back();
+            return frameSlot;
+        }
+        uint32_t frameSlot = (uint32_t)(frame_blocks_.size() * STORE_FRAME_BLOCK);
+        frame_blocks_.emplace_back(new uint8_t[STORE_FRAME_BLOCK * BITMAP_SIZE]);
+        for (size_t i = STORE_FRAME_BLOCK - 1; i > 0; i--) free_frames_.push_back(frameSlot + (uint32_t)i);
+        return frameSlot;
+    }
+
+    uint8_t* FramePointer(uint32_t frameSlot) {
+        return frame_blocks_[frameSlot / STORE_FRAME_BLOCK].get() + (frameSlot % STORE_FRAME_BLOCK) * BITMAP_SIZE;
+    }
+
+    // Columns, indexed by slot
+    std::vector<uint32_t> generation_;
+    std::vector<uint32_t> revision_;
+    std::vector<int> id_;
+    std::vector<uint32_t> name_;            // Interned name, or prefix when name_number_ >= 0, or STORE_NO_STRING
+    std::vector<int> name_number_;
+    std::vector<uint32_t> port_;            // Interned, or STORE_NO_STRING
+    std::vector<uint64_t> hash_;
+    std::vector<int> repeat_count_;
+    std::vector<int64_t> archive_index_;
+    std::vector<uint64_t> time_;            // PackTime
+    std::vector<const ArchiveRecord*> record_;   // Archived only: name (until renamed), port, time and hash
+    std::vector<const uint8_t*> frame_;
+    std::vector<uint32_t> frame_slot_;      // In the pool, UINT32_MAX if archived
+    std::vector<uint32_t> texture_preview_;
+    std::vector<uint32_t> thumb_cell_;
+
+    std::vector<uint32_t> free_slots_;
+    std::vector<uint32_t> order_;           // Slots in gallery order
+    StringPool strings_;
+
+    // Frame pool: blocks never move, so frame pointers stay valid
+    std::vector<std::unique_ptr<uint8_t[]>> frame_blocks_;
+    std::vector<uint32_t> free_frames_;
+    size_t frame_count_ = 0;
+};
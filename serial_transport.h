@@ -0,0 +1,621 @@
+// RadShot - Serial transport
+// ISerialTransport hides the platform serial API from the capture logic so it can
+// run on Windows (overlapped Win32 I/O), Linux/macOS (termios + poll) or entirely
+// in memory (LoopbackTransport) for tests and benchmarks.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <setupapi.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+// =============================================================================
+// Interface
+// =============================================================================
+
+// What an event loop waits on for one transport (see PortPoller)
+#ifdef _WIN32
+using WaitHandle = HANDLE;   // Event, signalled when a read completes
+constexpr WaitHandle INVALID_WAIT_HANDLE = nullptr;
+#else
+using WaitHandle = int;      // Descriptor, readable when bytes arrive
+constexpr WaitHandle INVALID_WAIT_HANDLE = -1;
+#endif
+
+class ISerialTransport {
+public:
+    virtual ~ISerialTransport() {}
+
+    // Opens `port` (e.g. "COM3" or "/dev/ttyUSB0") at 8N1 with the given baud rate
+    virtual bool Open(const char* port, uint32_t baud) = 0;
+    virtual void Close() = 0;
+    virtual bool IsOpen() const = 0;
+
+    // Writes all of `data`; returns false if the port failed
+    virtual bool Write(const uint8_t* data, size_t len) = 0;
+
+    // Reads up to `len` bytes, waiting at most `timeout_ms` for the first one.
+    // Returns the byte count, 0 on timeout or Wake(), or -1 if the port failed.
+    virtual int Read(uint8_t* buf, size_t len, uint32_t timeout_ms) = 0;
+
+    // Discards anything buffered in either direction
+    virtual void Purge() = 0;
+
+    // Makes a blocked Read() return early. Safe to call from any thread.
+    virtual void Wake() = 0;
+
+    // Multiplexing several transports on one thread: call ArmWait() before every wait,
+    // then wait on GetWaitHandle() and collect with Read(..., 0). ArmWait() returns true
+    // if bytes are already buffered and the wait must not block. Transports without a
+    // handle (INVALID_WAIT_HANDLE) are polled instead.
+    virtual WaitHandle GetWaitHandle() const { return INVALID_WAIT_HANDLE; }
+    virtual bool ArmWait() { return false; }
+
+    const char* LastError() const { return error_; }
+
+protected:
+    void SetError(const char* fmt, const char* arg = "") {
+        snprintf(error_, sizeof(error_), fmt, arg);
+    }
+
+    char error_[128] = {0};
+};
+
+// =============================================================================
+// Win32 Backend
+// =============================================================================
+
+#ifdef _WIN32
+
+class Win32SerialTransport : public ISerialTransport {
+public:
+    // Longest a single overlapped read waits before it is re-issued
+    static constexpr DWORD READ_SLICE_MS = 20;
+
+    Win32SerialTransport() {
+        read_ov_.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        write_ov_.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        wake_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    }
+
+    ~Win32SerialTransport() override {
+        Close();
+        CloseHandle(read_ov_.hEvent);
+        CloseHandle(write_ov_.hEvent);
+        CloseHandle(wake_);
+    }
+
+    bool Open(const char* port, uint32_t baud) override {
+        Close();
+
+        char fullPath[32];
+        snprintf(fullPath, sizeof(fullPath), "\\\\.\\%s", port);
+
+        handle_ = CreateFileA(
+            fullPath, GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+            OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr
+        );
+
+        if (handle_ == INVALID_HANDLE_VALUE) {
+            SetError("Failed to open %s", port);
+            return false;
+        }
+
+        DCB dcb = { sizeof(DCB) };
+        if (!GetCommState(handle_, &dcb)) {
+            Close();
+            SetError("Failed to get port state");
+            return false;
+        }
+
+        dcb.BaudRate = baud;
+        dcb.ByteSize = 8;
+        dcb.Parity = NOPARITY;
+        dcb.StopBits = ONESTOPBIT;
+        dcb.fBinary = TRUE;
+        dcb.fDtrControl = DTR_CONTROL_ENABLE;
+        dcb.fRtsControl = RTS_CONTROL_ENABLE;
+
+        if (!SetCommState(handle_, &dcb)) {
+            Close();
+            SetError("Failed to configure port");
+            return false;
+        }
+
+        // A read returns as soon as any bytes are buffered, or after READ_SLICE_MS with none
+        COMMTIMEOUTS timeouts = {0};
+        timeouts.ReadIntervalTimeout = MAXDWORD;
+        timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+        timeouts.ReadTotalTimeoutConstant = READ_SLICE_MS;
+        timeouts.WriteTotalTimeoutMultiplier = 0;
+        timeouts.WriteTotalTimeoutConstant = 1000;
+        SetCommTimeouts(handle_, &timeouts);
+
+        PurgeComm(handle_, PURGE_RXCLEAR | PURGE_TXCLEAR);
+        return true;
+    }
+
+    void Close() override {
+        if (handle_ == INVALID_HANDLE_VALUE) return;
+        CancelRead();
+        CloseHandle(handle_);
+        handle_ = INVALID_HANDLE_VALUE;
+    }
+
+    bool IsOpen() const override { return handle_ != INVALID_HANDLE_VALUE; }
+
+    bool Write(const uint8_t* data, size_t len) override {
+        DWORD written = 0;
+        ResetEvent(write_ov_.hEvent);
+        if (!WriteFile(handle_, data, (DWORD)len, nullptr, &write_ov_) &&
+            GetLastError() != ERROR_IO_PENDING) {
+            SetError("Write failed");
+            return false;
+        }
+        if (!GetOverlappedResult(handle_, &write_ov_, &written, TRUE) || written != len) {
+            SetError("Write failed");
+            return false;
+        }
+        return true;
+    }
+
+    int Read(uint8_t* buf, size_t len, uint32_t timeout_ms) override {
+        if (rx_pos_ < rx_len_) return TakeBuffered(buf, len);
+
+        ULONGLONG deadline = GetTickCount64() + timeout_ms;
+        for (;;) {
+            if (!read_pending_) {
+                ResetEvent(read_ov_.hEvent);
+                if (!ReadFile(handle_, rx_buf_, sizeof(rx_buf_), nullptr, &read_ov_) &&
+                    GetLastError() != ERROR_IO_PENDING) {
+                    SetError("Read failed");
+                    return -1;
+                }
+                read_pending_ = true;
+            }
+
+            ULONGLONG now = GetTickCount64();
+            DWORD waitMs = now >= deadline ? 0 : (DWORD)(deadline - now);
+            HANDLE handles[2] = { wake_, read_ov_.hEvent };
+            DWORD wait = WaitForMultipleObjects(2, handles, FALSE, waitMs);
+
+            // On wake or timeout the read stays pending for the next call
+            if (wait == WAIT_OBJECT_0 || wait == WAIT_TIMEOUT) return 0;
+            if (wait != WAIT_OBJECT_0 + 1) {
+                SetError("Read failed");
+                return -1;
+            }
+
+            DWORD bytesRead = 0;
+            read_pending_ = false;
+            if (!GetOverlappedResult(handle_, &read_ov_, &bytesRead, FALSE)) {
+                SetError("Read failed");
+                return -1;
+            }
+            rx_len_ = bytesRead;
+            rx_pos_ = 0;
+            if (bytesRead > 0) return TakeBuffered(buf, len);
+            if (GetTickCount64() >= deadline) return 0;
+        }
+    }
+
+    void Purge() override {
+        // A pending read may already hold pre-purge bytes, so cancel it first
+        CancelRead();
+        rx_len_ = rx_pos_ = 0;
+        PurgeComm(handle_, PURGE_RXCLEAR | PURGE_TXCLEAR);
+    }
+
+    void Wake() override { SetEvent(wake_); }
+
+    WaitHandle GetWaitHandle() const override { return read_ov_.hEvent; }
+
+    // Keeps an overlapped read in flight so read_ov_.hEvent fires when bytes arrive
+    bool ArmWait() override {
+        if (rx_pos_ < rx_len_) return true;
+        if (read_pending_ || handle_ == INVALID_HANDLE_VALUE) return false;
+        ResetEvent(read_ov_.hEvent);
+        if (!ReadFile(handle_, rx_buf_, sizeof(rx_buf_), nullptr, &read_ov_) &&
+            GetLastError() != ERROR_IO_PENDING) {
+            // Let the next Read() report the failure
+            return true;
+        }
+        read_pending_ = true;
+        return false;
+    }
+
+private:
+    int TakeBuffered(uint8_t* buf, size_t len) {
+        size_t n = (std::min)(len, rx_len_ - rx_pos_);
+        memcpy(buf, rx_buf_ + rx_pos_, n);
+        rx_pos_ += n;
+        return (int)n;
+    }
+
+    void CancelRead() {
+        if (!read_pending_) return;
+        DWORD ignored;
+        CancelIo(handle_);
+        GetOverlappedResult(handle_, &read_ov_, &ignored, TRUE);
+        read_pending_ = false;
+    }
+
+    HANDLE handle_ = INVALID_HANDLE_VALUE;
+    HANDLE wake_ = nullptr;
+    OVERLAPPED read_ov_ = {0};
+    OVERLAPPED write_ov_ = {0};
+    bool read_pending_ = false;
+    uint8_t rx_buf_[256];
+    size_t rx_len_ = 0;
+    size_t rx_pos_ = 0;
+};
+
+#else
+
+// =============================================================================
+// POSIX Backend (termios + poll)
+// =============================================================================
+
+class PosixSerialTransport : public ISerialTransport {
+public:
+    PosixSerialTransport() {
+        if (pipe(wake_pipe_) == 0) {
+            fcntl(wake_pipe_[0], F_SETFL, O_NONBLOCK);
+            fcntl(wake_pipe_[1], F_SETFL, O_NONBLOCK);
+        } else {
+            wake_pipe_[0] = wake_pipe_[1] = -1;
+        }
+    }
+
+    ~PosixSerialTransport() override {
+        Close();
+        if (wake_pipe_[0] >= 0) close(wake_pipe_[0]);
+        if (wake_pipe_[1] >= 0) close(wake_pipe_[1]);
+    }
+
+    static speed_t BaudToSpeed(uint32_t baud) {
+        switch (baud) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+#ifdef B460800
+        case 460800: return B460800;
+#endif
+#ifdef B921600
+        case 921600: return B921600;
+#endif
+        default: return 0;
+        }
+    }
+
+    bool Open(const char* port, uint32_t baud) override {
+        Close();
+
+        speed_t speed = BaudToSpeed(baud);
+        if (!speed) {
+            SetError("Unsupported baud rate");
+            return false;
+        }
+
+        fd_ = open(port, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (fd_ < 0) {
+            SetError("Failed to open %s", port);
+            return false;
+        }
+
+        termios tio;
+        if (tcgetattr(fd_, &tio) != 0) {
+            Close();
+            SetError("Failed to get port state");
+            return false;
+        }
+
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag &= ~(CSTOPB | PARENB);
+#ifdef CRTSCTS
+        tio.c_cflag &= ~CRTSCTS;
+#endif
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 0;
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+
+        if (tcsetattr(fd_, TCSANOW, &tio) != 0) {
+            Close();
+            SetError("Failed to configure port");
+            return false;
+        }
+
+        // Match the Win32 DTR/RTS enable; ptys don't support this, so ignore failure
+        int lines = TIOCM_DTR | TIOCM_RTS;
+        ioctl(fd_, TIOCMBIS, &lines);
+
+        tcflush(fd_, TCIOFLUSH);
+        return true;
+    }
+
+    void Close() override {
+        if (fd_ < 0) return;
+        close(fd_);
+        fd_ = -1;
+    }
+
+    bool IsOpen() const override { return fd_ >= 0; }
+
+    bool Write(const uint8_t* data, size_t len) override {
+        size_t done = 0;
+        while (done < len) {
+            ssize_t n = write(fd_, data + done, len - done);
+            if (n > 0) {
+                done += (size_t)n;
+                continue;
+            }
+            if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                SetError("Write failed");
+                return false;
+            }
+            pollfd pfd = { fd_, POLLOUT, 0 };
+            if (poll(&pfd, 1, 1000) <= 0) {
+                SetError("Write timed out");
+                return false;
+            }
+        }
+        tcdrain(fd_);
+        return true;
+    }
+
+    int Read(uint8_t* buf, size_t len, uint32_t timeout_ms) override {
+        pollfd pfds[2] = {
+            { fd_, POLLIN, 0 },
+            { wake_pipe_[0], POLLIN, 0 },
+        };
+        int ready = poll(pfds, wake_pipe_[0] >= 0 ? 2 : 1, (int)timeout_ms);
+        if (ready < 0) {
+            if (errno == EINTR) return 0;
+            SetError("Read failed");
+            return -1;
+        }
+        if (ready == 0) return 0;
+
+        if (pfds[1].revents & POLLIN) {
+            char drain[16];
+            while (read(wake_pipe_[0], drain, sizeof(drain)) > 0) {}
+        }
+        if (pfds[0].revents & POLLIN) {
+            ssize_t n = read(fd_, buf, len);
+            if (n > 0) return (int)n;
+            if (n < 0 && (errno == EAGAIN || errno == EINTR)) return 0;
+            SetError("Read failed");
+            return -1;
+        }
+        if (pfds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            SetError("Port closed");
+            return -1;
+        }
+        return 0;
+    }
+
+    void Purge() override { tcflush(fd_, TCIOFLUSH); }
+
+    WaitHandle GetWaitHandle() const override { return fd_; }
+
+    void Wake() override {
+        if (wake_pipe_[1] >= 0) {
+            char c = 0;
+            ssize_t ignored = write(wake_pipe_[1], &c, 1);
+            (void)ignored;
+        }
+    }
+
+private:
+    int fd_ = -1;
+    int wake_pipe_[2];
+};
+
+#endif // _WIN32
+
+// =============================================================================
+// Loopback Backend
+// =============================================================================
+
+// In-memory transport for tests and benchmarks. Bytes the host writes are handed
+// to an optional responder (standing in for the radio), and bytes for the host
+// are queued with Inject() from any thread.
+class LoopbackTransport : public ISerialTransport {
+public:
+    using Responder = std::function<void(LoopbackTransport& port, const uint8_t* data, size_t len)>;
+
+    void SetResponder(Responder responder) { responder_ = std::move(responder); }
+
+    void Inject(const uint8_t* data, size_t len) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rx_.insert(rx_.end(), data, data + len);
+        }
+        cv_.notify_all();
+    }
+
+    bool Open(const char*, uint32_t baud) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = true;
+        baud_ = baud;
+        rx_.clear();
+        return true;
+    }
+
+    void Close() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            open_ = false;
+        }
+        cv_.notify_all();
+    }
+
+    bool IsOpen() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return open_;
+    }
+
+    bool Write(const uint8_t* data, size_t len) override {
+        if (!IsOpen()) {
+            SetError("Port closed");
+            return false;
+        }
+        bytes_written_ += len;
+        if (responder_) responder_(*this, data, len);
+        return true;
+    }
+
+    int Read(uint8_t* buf, size_t len, uint32_t timeout_ms) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                     [&] { return !rx_.empty() || woken_ || !open_; });
+        woken_ = false;
+        if (!open_) {
+            SetError("Port closed");
+            return -1;
+        }
+        size_t n = (std::min)(len, rx_.size());
+        std::copy(rx_.begin(), rx_.begin() + n, buf);
+        rx_.erase(rx_.begin(), rx_.begin() + n);
+        return (int)n;
+    }
+
+    void Purge() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rx_.clear();
+    }
+
+    void Wake() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            woken_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    bool ArmWait() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !rx_.empty() || !open_;
+    }
+
+    size_t BytesWritten() const { return bytes_written_; }
+
+    // Rate passed to the last Open(), so responders can model a device fixed at one speed
+    uint32_t Baud() const { return baud_; }
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<uint8_t> rx_;
+    bool open_ = false;
+    bool woken_ = false;
+    size_t bytes_written_ = 0;
+    uint32_t baud_ = 0;
+    Responder responder_;
+};
+
+// =============================================================================
+// Platform Helpers
+// =============================================================================
+
+inline std::unique_ptr<ISerialTransport> CreatePlatformTransport() {
+#ifdef _WIN32
+    return std::unique_ptr<ISerialTransport>(new Win32SerialTransport());
+#else
+    return std::unique_ptr<ISerialTransport>(new PosixSerialTransport());
+#endif
+}
+
+#ifdef _WIN32
+// GUID for COM ports
+static const GUID GUID_DEVINTERFACE_COMPORT =
+    { 0x86E0D1E0L, 0x8089, 0x11D0, { 0x9C, 0xE4, 0x08, 0x00, 0x3E, 0x30, 0x1F, 0x73 } };
+#endif
+
+// Lists serial ports that could be a radio: COMn on Windows, /dev/ttyUSB* and
+// /dev/ttyACM* elsewhere. Sorted by port number.
+inline std::vector<std::string> EnumerateSerialPorts() {
+    std::vector<std::string> ports;
+
+#ifdef _WIN32
+    HDEVINFO hDevInfo = SetupDiGetClassDevs(
+        &GUID_DEVINTERFACE_COMPORT, nullptr, nullptr,
+        DIGCF_PRESENT | DIGCF_DEVICEINTERFACE
+    );
+
+    if (hDevInfo == INVALID_HANDLE_VALUE) return ports;
+
+    SP_DEVINFO_DATA devInfo = { sizeof(SP_DEVINFO_DATA) };
+
+    for (DWORD i = 0; SetupDiEnumDeviceInfo(hDevInfo, i, &devInfo); i++) {
+        HKEY hKey = SetupDiOpenDevRegKey(
+            hDevInfo, &devInfo, DICS_FLAG_GLOBAL, 0, DIREG_DEV, KEY_READ
+        );
+
+        if (hKey != INVALID_HANDLE_VALUE) {
+            char portName[256];
+            DWORD size = sizeof(portName);
+            DWORD type;
+
+            if (RegQueryValueExA(hKey, "PortName", nullptr, &type,
+                                 (LPBYTE)portName, &size) == ERROR_SUCCESS) {
+                if (strncmp(portName, "COM", 3) == 0) {
+                    ports.push_back(portName);
+                }
+            }
+            RegCloseKey(hKey);
+        }
+    }
+
+    SetupDiDestroyDeviceInfoList(hDevInfo);
+#else
+    DIR* dir = opendir("/dev");
+    if (!dir) return ports;
+    while (dirent* entry = readdir(dir)) {
+        if (strncmp(entry->d_name, "ttyUSB", 6) == 0 || strncmp(entry->d_name, "ttyACM", 6) == 0) {
+            ports.push_back(std::string("/dev/") + entry->d_name);
+        }
+    }
+    closedir(dir);
+#endif
+
+    // Natural sort: group by prefix, then by trailing number
+    std::sort(ports.begin(), ports.end(),
+        [](const std::string& a, const std::string& b) {
+            size_t da = a.find_last_not_of("0123456789") + 1;
+            size_t db = b.find_last_not_of("0123456789") + 1;
+            int cmp = a.compare(0, da, b, 0, db);
+            if (cmp != 0) return cmp < 0;
+            return atoi(a.c_str() + da) < atoi(b.c_str() + db);
+        });
+    return ports;
+}
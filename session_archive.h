@@ -0,0 +1,675 @@
+// RadShot - Session archive
+// Every capture is appended to a session file of fixed-size records (raw frame plus
+// metadata) so the gallery survives a restart. On startup the file is memory-mapped and
+// the gallery points straight into it: nothing is copied or decoded until it is viewed.
+// What building the gallery needs (id, flags, repeat count) is also kept in a compact
+// index file beside it, 16 bytes a record, so startup reads that instead of paging in
+// every record. The index is derived data: when it is missing, stale or belongs to
+// another archive, the records it doesn't cover are read from the archive and it is
+// rewritten.
+//
+// Crash safety: the header's committed count is the commit point. A writer thread
+// appends records, flushes them, then updates the count and flushes again, batching
+// whatever has queued up into one commit. On open, records past the count are replayed
+// if their checksum holds (written but not yet committed) and a torn tail is cut off.
+// Names, repeat counts and the deleted flag sit outside the checksum and are updated
+// in place.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_decoder.h"
+#include "frame_hash.h"
+#include "spsc_queue.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+constexpr char ARCHIVE_MAGIC[8] = { 'R', 'A', 'D', 'S', 'H', 'O', 'T', 'S' };
+constexpr uint32_t ARCHIVE_VERSION = 1;
+constexpr uint32_t ARCHIVE_RECORD_MAGIC = 0x43455252;   // "RREC"
+constexpr uint32_t ARCHIVE_FLAG_DELETED = 1;
+constexpr char ARCHIVE_INDEX_MAGIC[8] = { 'R', 'A', 'D', 'S', 'H', 'O', 'T', 'I' };
+constexpr uint32_t ARCHIVE_INDEX_VERSION = 1;
+constexpr const char* ARCHIVE_INDEX_SUFFIX = ".idx";
+
+// Same fields and layout as Win32 SYSTEMTIME
+struct ArchiveTime {
+    uint16_t year, month, day_of_week, day;
+    uint16_t hour, minute, second, milliseconds;
+};
+
+struct ArchiveHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t committed;        // Records known to be durable
+    uint64_t instance;         // Random per file, ties the index to it (0 in files older than the index)
+    uint8_t reserved[32];
+};
+
+struct ArchiveRecord {
+    // Written once, covered by the checksum
+    uint32_t magic;
+    uint32_t id;
+    uint64_t hash;             // HashFrame(frame)
+    ArchiveTime timestamp;
+    char port[32];
+    uint8_t frame[BITMAP_SIZE];
+    uint64_t checksum;         // HashBytes of every field above
+
+    // Updated in place
+    uint32_t flags;
+    int32_t repeat_count;
+    char name[256];
+};
+
+// The index file: a header, then one entry per record in record order
+struct ArchiveIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    uint64_t instance;         // ArchiveHeader::instance of the archive it indexes
+    uint64_t covered;          // Leading entries that are complete
+    uint8_t reserved[32];
+};
+
+// Copies of the record fields the gallery is built from. Updated with the record.
+struct ArchiveIndexEntry {
+    uint32_t id;
+    uint32_t flags;
+    int32_t repeat_count;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ArchiveHeader) == 64, "ArchiveHeader layout");
+static_assert(sizeof(ArchiveRecord) == 1360, "ArchiveRecord layout");
+static_assert(offsetof(ArchiveRecord, frame) == 64, "ArchiveRecord frame alignment");
+static_assert(sizeof(ArchiveIndexHeader) == 64, "ArchiveIndexHeader layout");
+static_assert(sizeof(ArchiveIndexEntry) == 16, "ArchiveIndexEntry layout");
+
+inline uint64_t ArchiveRecordChecksum(const ArchiveRecord& record) {
+    return HashBytes((const uint8_t*)&record, offsetof(ArchiveRecord, checksum));
+}
+
+inline uint64_t ArchiveRecordOffset(uint64_t index) {
+    return sizeof(ArchiveHeader) + index * sizeof(ArchiveRecord);
+}
+
+inline uint64_t ArchiveIndexOffset(uint64_t index) {
+    return sizeof(ArchiveIndexHeader) + index * sizeof(ArchiveIndexEntry);
+}
+
+inline ArchiveIndexEntry MakeArchiveIndexEntry(const ArchiveRecord& record) {
+    ArchiveIndexEntry entry = {};
+    entry.id = record.id;
+    entry.flags = record.flags;
+    entry.repeat_count = record.repeat_count;
+    return entry;
+}
+
+// A new archive's instance: any value that is unlikely to repeat and isn't 0
+inline uint64_t NewArchiveInstance(const void* salt) {
+    uint64_t seed[2] = { (uint64_t)std::chrono::system_clock::now().time_since_epoch().count(),
+                         (uint64_t)(uintptr_t)salt };
+    uint64_t instance = HashBytes((const uint8_t*)seed, sizeof(seed));
+    return instance ? instance : 1;
+}
+
+// =============================================================================
+// File access
+// =============================================================================
+
+// Positional reads and writes on one file, Win32 or POSIX
+class ArchiveFile {
+public:
+    ~ArchiveFile() { Close(); }
+
+    // Opens or creates `path` for writing, or opens an existing file read-only
+    bool Open(const char* path, bool readOnly = false) {
+        Close();
+#ifdef _WIN32
+        handle_ = CreateFileA(path, readOnly ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              readOnly ? OPEN_EXISTING : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        return handle_ != INVALID_HANDLE_VALUE;
+#else
+        fd_ = readOnly ? open(path, O_RDONLY | O_CLOEXEC) : open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        return fd_ >= 0;
+#endif
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (handle_ != INVALID_HANDLE_VALUE) CloseHandle(handle_);
+        handle_ = INVALID_HANDLE_VALUE;
+#else
+        if (fd_ >= 0) close(fd_);
+        fd_ = -1;
+#endif
+    }
+
+    uint64_t Size() const {
+#ifdef _WIN32
+        LARGE_INTEGER size;
+        return GetFileSizeEx(handle_, &size) ? (uint64_t)size.QuadPart : 0;
+#else
+        struct stat st;
+        return fstat(fd_, &st) == 0 ? (uint64_t)st.st_size : 0;
+#endif
+    }
+
+    bool ReadAt(uint64_t offset, void* data, size_t size) const {
+#ifdef _WIN32
+        OVERLAPPED ov = {};
+        ov.Offset = (DWORD)offset;
+        ov.OffsetHigh = (DWORD)(offset >> 32);
+        DWORD got = 0;
+        return ReadFile(handle_, data, (DWORD)size, &got, &ov) && got == size;
+#else
+        return pread(fd_, data, size, (off_t)offset) == (ssize_t)size;
+#endif
+    }
+
+    bool WriteAt(uint64_t offset, const void* data, size_t size) {
+#ifdef _WIN32
+        OVERLAPPED ov = {};
+        ov.Offset = (DWORD)offset;
+        ov.OffsetHigh = (DWORD)(offset >> 32);
+        DWORD written = 0;
+        return WriteFile(handle_, data, (DWORD)size, &written, &ov) && written == size;
+#else
+        return pwrite(fd_, data, size, (off_t)offset) == (ssize_t)size;
+#endif
+    }
+
+    bool Truncate(uint64_t size) {
+#ifdef _WIN32
+        LARGE_INTEGER pos;
+        pos.QuadPart = (LONGLONG)size;
+        return SetFilePointerEx(handle_, pos, nullptr, FILE_BEGIN) && SetEndOfFile(handle_);
+#else
+        return ftruncate(fd_, (off_t)size) == 0;
+#endif
+    }
+
+    // Makes everything written so far durable
+    bool Flush() {
+#ifdef _WIN32
+        return FlushFileBuffers(handle_) != 0;
+#elif defined(__APPLE__)
+        return fsync(fd_) == 0;
+#else
+        return fdatasync(fd_) == 0;
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE handle_ = INVALID_HANDLE_VALUE;
+#else
+    int fd_ = -1;
+#endif
+};
+
+// Read-only mapping of the committed records
+class ArchiveView {
+public:
+    ~ArchiveView() { Unmap(); }
+
+    bool Map(const char* path, uint64_t records) {
+        Unmap();
+        if (records == 0) return true;
+        size_t size = (size_t)ArchiveRecordOffset(records);
+#ifdef _WIN32
+        file_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) return false;
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY,
+                                      (DWORD)((uint64_t)size >> 32), (DWORD)size, nullptr);
+        if (!mapping_) {
+            Unmap();
+            return false;
+        }
+        base_ = (const uint8_t*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, size);
+#else
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        base_ = base == MAP_FAILED ? nullptr : (const uint8_t*)base;
+#endif
+        if (!base_) {
+            Unmap();
+            return false;
+        }
+        size_ = size;
+        count_ = records;
+        return true;
+    }
+
+    void Unmap() {
+#ifdef _WIN32
+        if (base_) UnmapViewOfFile(base_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (base_) munmap((void*)base_, size_);
+#endif
+        base_ = nullptr;
+        size_ = 0;
+        count_ = 0;
+    }
+
+    uint64_t Count() const { return count_; }
+    const ArchiveRecord& Record(uint64_t index) const {
+        return *(const ArchiveRecord*)(base_ + ArchiveRecordOffset(index));
+    }
+
+private:
+    const uint8_t* base_ = nullptr;
+    size_t size_ = 0;
+    uint64_t count_ = 0;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#endif
+};
+
+// =============================================================================
+// Archive
+// =============================================================================
+
+struct ArchiveStats {
+    uint64_t records = 0;        // On disk, committed
+    uint64_t recovered = 0;      // Replayed past the commit point on open
+    uint64_t discarded = 0;      // Torn records cut off on open
+    uint64_t scanned = 0;        // Read from the archive on open because the index didn't cover them
+    uint64_t commits = 0;        // Group commits since open
+    bool failed = false;         // A write or flush failed; the archive stopped recording
+};
+
+class SessionArchive {
+public:
+    ~SessionArchive() { Close(); }
+
+    // Opens (or creates) the archive at `path`, recovers it, maps the committed records
+    // and loads their index entries. Returns false with `error` set if the file can't be
+    // used; a file that isn't an archive is left untouched.
+    bool Open(const char* path, std::string& error) {
+        Close();
+        stats_ = ArchiveStats();
+        if (!file_.Open(path)) {
+            error = "cannot open session file";
+            return false;
+        }
+
+        uint64_t committed = 0;
+        if (!Recover(committed, error)) {
+            file_.Close();
+            return false;
+        }
+        if (!view_.Map(path, committed)) {
+            error = "cannot map session file";
+            file_.Close();
+            return false;
+        }
+        LoadIndex((std::string(path) + ARCHIVE_INDEX_SUFFIX).c_str(), committed);
+
+        next_index_ = committed;
+        committed_ = committed;
+        stats_.records = committed;
+        stop_ = false;
+        failed_ = false;
+        thread_ = std::thread(&SessionArchive::Run, this);
+        return true;
+    }
+
+    // Commits whatever is queued and closes the file
+    void Close() {
+        if (thread_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_one();
+            thread_.join();
+        }
+        view_.Unmap();
+        entries_.clear();
+        file_.Close();
+        index_.Close();
+    }
+
+    bool IsOpen() const { return thread_.joinable(); }
+
+    // Records mapped at open (the previous sessions). A record's memory is only read
+    // once something asks for its fields; MappedEntry() has what building the gallery
+    // needs, as of open, without touching it.
+    uint64_t MappedCount() const { return view_.Count(); }
+    const ArchiveRecord& Mapped(uint64_t index) const { return view_.Record(index); }
+    const ArchiveIndexEntry& MappedEntry(uint64_t index) const { return entries_[index]; }
+
+    // UI thread: queues a new record and returns its index
+    int64_t Append(uint32_t id, const ArchiveTime& timestamp, const char* port, const char* name,
+                   uint64_t hash, int repeat_count, const uint8_t* frame) {
+        if (!IsOpen()) return -1;
+        ArchiveOp op = {};
+        op.type = OpType::Append;
+        op.index = next_index_++;
+        ArchiveRecord& r = op.record;
+        r.magic = ARCHIVE_RECORD_MAGIC;
+        r.id = id;
+        r.hash = hash;
+        r.timestamp = timestamp;
+        strncpy(r.port, port, sizeof(r.port) - 1);
+        memcpy(r.frame, frame, BITMAP_SIZE);
+        r.checksum = ArchiveRecordChecksum(r);
+        r.flags = 0;
+        r.repeat_count = repeat_count;
+        strncpy(r.name, name, sizeof(r.name) - 1);
+        Send(op);
+        return op.index;
+    }
+
+    void SetName(int64_t index, const char* name) {
+        if (!IsOpen() || index < 0) return;
+        ArchiveOp op = {};
+        op.type = OpType::SetName;
+        op.index = (uint64_t)index;
+        strncpy(op.record.name, name, sizeof(op.record.name) - 1);
+        Send(op);
+    }
+
+    void SetRepeatCount(int64_t index, int count) {
+        if (!IsOpen() || index < 0) return;
+        ArchiveOp op = {};
+        op.type = OpType::SetRepeat;
+        op.index = (uint64_t)index;
+        op.record.repeat_count = count;
+        Send(op);
+    }
+
+    void MarkDeleted(int64_t index) {
+        if (!IsOpen() || index < 0) return;
+        ArchiveOp op = {};
+        op.type = OpType::Delete;
+        op.index = (uint64_t)index;
+        op.record.flags = ARCHIVE_FLAG_DELETED;
+        Send(op);
+    }
+
+    // Empties the archive. Unmaps it first, so nothing may still point at Mapped() records.
+    void Clear() {
+        if (!IsOpen()) return;
+        view_.Unmap();
+        entries_.clear();
+        next_index_ = 0;
+        ArchiveOp op = {};
+        op.type = OpType::Clear;
+        Send(op);
+    }
+
+    // Records made durable so far (this session's included)
+    uint64_t Committed() const { return committed_.load(); }
+    bool Failed() const { return failed_.load(); }
+    ArchiveStats Stats() const {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ArchiveStats stats = stats_;
+        stats.failed = failed_.load();
+        return stats;
+    }
+
+private:
+    enum class OpType { Append, SetName, SetRepeat, Delete, Clear };
+
+    struct ArchiveOp {
+        OpType type;
+        uint64_t index;
+        ArchiveRecord record;   // Append: the record. Updates: the field being set.
+    };
+
+    // Validates the header, replays records written after the last commit and cuts off
+    // a torn tail. Only the records past the commit point are read.
+    bool Recover(uint64_t& committed, std::string& error) {
+        uint64_t size = file_.Size();
+        ArchiveHeader header;
+        if (size == 0) {
+            // New archive
+            instance_ = NewArchiveInstance(this);
+            if (!WriteHeader(0) || !file_.Flush()) {
+                error = "cannot write session file";
+                return false;
+            }
+            committed = 0;
+            return true;
+        }
+        if (size < sizeof(header) || !file_.ReadAt(0, &header, sizeof(header)) ||
+            memcmp(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0) {
+            error = "not a RadShot session file";
+            return false;
+        }
+        if (header.version != ARCHIVE_VERSION || header.record_size != sizeof(ArchiveRecord)) {
+            error = "unsupported session file version";
+            return false;
+        }
+
+        // An archive from before the index gets an instance now, so no index matches it yet
+        instance_ = header.instance ? header.instance : NewArchiveInstance(this);
+
+        uint64_t onDisk = (size - sizeof(header)) / sizeof(ArchiveRecord);
+        committed = (std::min)(header.committed, onDisk);
+        ArchiveRecord record;
+        while (committed < onDisk && file_.ReadAt(ArchiveRecordOffset(committed), &record, sizeof(record)) &&
+               record.magic == ARCHIVE_RECORD_MAGIC && record.checksum == ArchiveRecordChecksum(record)) {
+            committed++;
+            stats_.recovered++;
+        }
+        stats_.discarded = onDisk - committed;
+
+        if (size != ArchiveRecordOffset(committed) || header.committed != committed || header.instance != instance_) {
+            if (!file_.Truncate(ArchiveRecordOffset(committed)) || !WriteHeader(committed) || !file_.Flush()) {
+                error = "cannot repair session file";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool WriteHeader(uint64_t committed) {
+        ArchiveHeader header = {};
+        memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+        header.version = ARCHIVE_VERSION;
+        header.record_size = sizeof(ArchiveRecord);
+        header.committed = committed;
+        header.instance = instance_;
+        return file_.WriteAt(0, &header, sizeof(header));
+    }
+
+    // Reads the index entries of the `committed` mapped records into entries_. Entries the
+    // index file doesn't have (or can't be trusted for) come from the records themselves,
+    // and are written back so the next open finds them. Failing to use the index file
+    // only costs time.
+    void LoadIndex(const char* path, uint64_t committed) {
+        entries_.assign((size_t)committed, ArchiveIndexEntry());
+        uint64_t covered = 0;
+        index_ok_ = index_.Open(path);
+        if (index_ok_) {
+            ArchiveIndexHeader header;
+            uint64_t size = index_.Size();
+            if (size >= sizeof(header) && index_.ReadAt(0, &header, sizeof(header)) &&
+                memcmp(header.magic, ARCHIVE_INDEX_MAGIC, sizeof(ARCHIVE_INDEX_MAGIC)) == 0 &&
+                header.version == ARCHIVE_INDEX_VERSION && header.entry_size == sizeof(ArchiveIndexEntry) &&
+                header.instance == instance_) {
+                covered = (std::min)(header.covered, committed);
+                covered = (std::min)(covered, (size - sizeof(header)) / sizeof(ArchiveIndexEntry));
+            }
+            if (covered > 0 && !index_.ReadAt(ArchiveIndexOffset(0), entries_.data(),
+                                              (size_t)covered * sizeof(ArchiveIndexEntry))) {
+                covered = 0;
+            }
+            // One record is read to make sure the entries line up with the records
+            if (covered > 0 && entries_[(size_t)covered - 1].id != view_.Record(covered - 1).id) covered = 0;
+        }
+
+        for (uint64_t i = covered; i < committed; i++) entries_[(size_t)i] = MakeArchiveIndexEntry(view_.Record(i));
+        stats_.scanned = committed - covered;
+
+        if (!index_ok_) return;
+        if (covered < committed) {
+            IndexWrite(ArchiveIndexOffset(covered), &entries_[(size_t)covered],
+                       (size_t)(committed - covered) * sizeof(ArchiveIndexEntry));
+        }
+        IndexTruncate(committed);
+        if (!WriteIndexHeader(committed) || !index_.Flush()) DropIndex();
+    }
+
+    bool WriteIndexHeader(uint64_t covered) {
+        ArchiveIndexHeader header = {};
+        memcpy(header.magic, ARCHIVE_INDEX_MAGIC, sizeof(ARCHIVE_INDEX_MAGIC));
+        header.version = ARCHIVE_INDEX_VERSION;
+        header.entry_size = sizeof(ArchiveIndexEntry);
+        header.instance = instance_;
+        header.covered = covered;
+        return index_ok_ && index_.WriteAt(0, &header, sizeof(header));
+    }
+
+    void IndexWrite(uint64_t offset, const void* data, size_t size) {
+        if (index_ok_ && !index_.WriteAt(offset, data, size)) DropIndex();
+    }
+
+    void IndexTruncate(uint64_t entries) {
+        if (index_ok_ && index_.Size() != ArchiveIndexOffset(entries) && !index_.Truncate(ArchiveIndexOffset(entries))) {
+            DropIndex();
+        }
+    }
+
+    // Stops maintaining an index that couldn't be written, emptying it so it isn't
+    // trusted on the next open
+    void DropIndex() {
+        if (!index_ok_) return;
+        index_ok_ = false;
+        index_.Truncate(0);
+    }
+
+    void Send(const ArchiveOp& op) {
+        // The writer keeps up with any capture rate; a full queue only means a slow flush
+        while (!ops_.TryPush(op)) {
+            if (failed_.load()) return;
+            cv_.notify_one();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        cv_.notify_one();
+    }
+
+    bool Apply(const ArchiveOp& op, uint64_t& appended) {
+        const ArchiveRecord& r = op.record;
+        uint64_t base = ArchiveRecordOffset(op.index);
+        uint64_t entry = ArchiveIndexOffset(op.index);
+        switch (op.type) {
+        case OpType::Append: {
+            appended = op.index + 1;
+            ArchiveIndexEntry e = MakeArchiveIndexEntry(r);
+            IndexWrite(entry, &e, sizeof(e));
+            return file_.WriteAt(base, &r, sizeof(r));
+        }
+        case OpType::SetName:
+            return file_.WriteAt(base + offsetof(ArchiveRecord, name), r.name, sizeof(r.name));
+        case OpType::SetRepeat:
+            IndexWrite(entry + offsetof(ArchiveIndexEntry, repeat_count), &r.repeat_count, sizeof(r.repeat_count));
+            return file_.WriteAt(base + offsetof(ArchiveRecord, repeat_count), &r.repeat_count, sizeof(r.repeat_count));
+        case OpType::Delete:
+            IndexWrite(entry + offsetof(ArchiveIndexEntry, flags), &r.flags, sizeof(r.flags));
+            return file_.WriteAt(base + offsetof(ArchiveRecord, flags), &r.flags, sizeof(r.flags));
+        case OpType::Clear:
+            // Records go before the count: a crash in between must not replay them
+            appended = 0;
+            if (!WriteIndexHeader(0) || !index_.Flush()) DropIndex();
+            IndexTruncate(0);
+            return file_.Truncate(sizeof(ArchiveHeader)) && WriteHeader(0) && file_.Flush();
+        }
+        return true;
+    }
+
+    // The index follows a commit: entries are flushed before the header that covers them
+    void CommitIndex(uint64_t covered) {
+        if (index_ok_ && (!index_.Flush() || !WriteIndexHeader(covered) || !index_.Flush())) DropIndex();
+    }
+
+    void Run() {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [&] { return stop_ || !ops_.Empty(); });
+                if (stop_ && ops_.Empty()) break;
+            }
+
+            // Everything queued goes into one commit
+            uint64_t appended = committed_.load();
+            bool cleared = false;
+            bool ok = true;
+            ArchiveOp op;
+            while (ok && ops_.TryPop(op)) {
+                if (op.type == OpType::Clear) cleared = true;
+                ok = Apply(op, appended);
+            }
+            if (ok && (appended != committed_.load() || cleared)) {
+                ok = file_.Flush() && WriteHeader(appended) && file_.Flush();
+                if (ok) CommitIndex(appended);
+                committed_ = appended;
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                stats_.records = appended;
+                stats_.commits++;
+            } else if (ok) {
+                ok = file_.Flush();
+                if (ok && index_ok_ && !index_.Flush()) DropIndex();
+            }
+            if (!ok) {
+                // Stop recording; what was committed stays valid
+                failed_ = true;
+                while (ops_.TryPop(op)) {}
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [&] { return stop_; });
+                break;
+            }
+        }
+    }
+
+    ArchiveFile file_;            // Writer thread only, once open
+    ArchiveFile index_;           // Likewise
+    bool index_ok_ = false;       // Likewise; false once an index write fails
+    uint64_t instance_ = 0;
+    ArchiveView view_;            // UI thread
+    std::vector<ArchiveIndexEntry> entries_;   // UI thread, by mapped record
+    uint64_t next_index_ = 0;     // UI thread
+    std::atomic<uint64_t> committed_{0};
+    std::atomic<bool> failed_{false};
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;           // Guarded by mutex_
+    SpscQueue<ArchiveOp, 64> ops_;
+
+    mutable std::mutex stats_mutex_;
+    ArchiveStats stats_;
+};
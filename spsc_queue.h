@@ -0,0 +1,44 @@
+// RadShot - Lock-free single-producer/single-consumer ring buffer
+// Used to hand capture events from the serial thread to the UI (and commands back)
+// without locks. Exactly one thread may push and exactly one thread may pop.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side. Returns false if the queue is full.
+    bool TryPush(const T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == Capacity) return false;
+        items_[head & (Capacity - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the queue is empty.
+    bool TryPop(T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+        item = items_[tail & (Capacity - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Empty() const {
+        return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+    }
+
+private:
+    // Head and tail sit on separate cache lines so producer and consumer don't false-share
+    std::atomic<size_t> head_{0};
+    char pad0_[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail_{0};
+    char pad1_[64 - sizeof(std::atomic<size_t>)];
+    T items_[Capacity];
+};
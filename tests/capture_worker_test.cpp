@@ -0,0 +1,279 @@
+// RadShot - Capture worker test
+// Drives CaptureWorker through LoopbackTransport, with a responder standing in for the
+// radio: a single capture (stale bytes before it, progress, the frame and its hash, an
+// over-long tail), each capture deadline, a counted burst and a stopped one, and a port
+// that fails. Then fills CaptureEventOutbox past the UI queue and its backlog, as a burst
+// does while the UI sits in a modal loop.
+//
+// Runs in real time (the deadlines are the ones used at 115200 baud), a few seconds.
+// Portable (no Win32 dependencies). Built by tests/CMakeLists.txt.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "capture_worker.h"
+
+constexpr uint32_t BAUD = 115200;
+constexpr uint32_t EVENT_WAIT_MS = 3000;   // Longer than any deadline at BAUD
+
+static int g_failures = 0;
+
+static void Expect(bool ok, const std::string& what) {
+    if (ok) return;
+    if (g_failures < 20) printf("FAIL %s\n", what.c_str());
+    g_failures++;
+}
+
+static std::vector<uint8_t> MakeFrame(uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> frame(BITMAP_SIZE);
+    for (uint8_t& b : frame) b = (uint8_t)rng();
+    return frame;
+}
+
+// Adds a session on a fresh loopback port. `port` stays valid until the session is removed.
+static int AddLoopback(CaptureWorker& worker, LoopbackTransport*& port) {
+    std::unique_ptr<LoopbackTransport> transport(new LoopbackTransport());
+    transport->Open("loopback", BAUD);
+    port = transport.get();
+    return worker.AddSession(std::move(transport), BAUD);
+}
+
+// Next event other than Progress, or false after EVENT_WAIT_MS. Progress events are
+// counted and their prefix of `frame` checked when one is given.
+static bool NextEvent(CaptureWorker& worker, CaptureEvent& ev, const uint8_t* frame = nullptr,
+                      int* progress = nullptr) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(EVENT_WAIT_MS);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (!worker.PollEvent(ev)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        if (ev.type != CaptureEventType::Progress) return true;
+        if (progress) (*progress)++;
+        if (frame) Expect(ev.bytes > 0 && ev.bytes < BITMAP_SIZE && memcmp(ev.frame, frame, ev.bytes) == 0,
+                          "progress carries the frame received so far");
+    }
+    return false;
+}
+
+static void ExpectEvent(CaptureWorker& worker, int session, CaptureEventType type, CaptureEvent& ev,
+                        const char* what) {
+    bool got = NextEvent(worker, ev);
+    Expect(got && ev.session == session && ev.type == type, std::string(what) + ": expected event missing");
+}
+
+static void TestCapture(CaptureWorker& worker) {
+    std::vector<uint8_t> frame = MakeFrame(1);
+    LoopbackTransport* port;
+    int session = AddLoopback(worker, port);
+    Expect(session > 0, "capture: session added");
+
+    // Leftovers from before the request are purged or dropped as stale
+    const uint8_t stale[7] = { 1, 2, 3, 4, 5, 6, 7 };
+    port->Inject(stale, sizeof(stale));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // The radio answers in USB-sized pieces, the last one with ten bytes too many
+    port->SetResponder([&](LoopbackTransport& p, const uint8_t* data, size_t len) {
+        if (len != sizeof(SCREENSHOT_CMD) || memcmp(data, SCREENSHOT_CMD, len) != 0) return;
+        std::vector<uint8_t> response(frame);
+        response.insert(response.end(), 10, 0xEE);
+        for (size_t at = 0; at < response.size(); at += 64) {
+            p.Inject(&response[at], (std::min)((size_t)64, response.size() - at));
+        }
+    });
+
+    Expect(worker.RequestCapture(session), "capture: request queued");
+    CaptureEvent ev;
+    int progress = 0;
+    bool got = NextEvent(worker, ev, frame.data(), &progress);
+    Expect(got && ev.type == CaptureEventType::Frame && ev.session == session, "capture: frame event");
+    if (got && ev.type == CaptureEventType::Frame) {
+        Expect(ev.bytes == BITMAP_SIZE && memcmp(ev.frame, frame.data(), BITMAP_SIZE) == 0,
+               "capture: frame matches what the radio sent");
+        Expect(ev.hash == HashFrame(frame.data()), "capture: hash computed on the worker");
+    }
+    Expect(progress > 0, "capture: progress reported");
+    ExpectEvent(worker, session, CaptureEventType::Overlong, ev, "capture: tail");
+    Expect(ev.bytes == 10, "capture: over-long tail counted");
+    Expect(port->BytesWritten() == sizeof(SCREENSHOT_CMD), "capture: one request written");
+    worker.RemoveSession(session);
+}
+
+// Requests a capture the radio answers with `respond`, and checks the timeout it ends in
+static void TestTimeout(CaptureWorker& worker, CaptureTimeoutKind kind, LoopbackTransport::Responder respond,
+                        bool trickle) {
+    const CaptureTimeouts timeouts = CaptureTimeouts::ForBaud(BAUD);
+    std::string what = std::string("timeout (") + CaptureTimeoutName(kind) + ")";
+    LoopbackTransport* port;
+    int session = AddLoopback(worker, port);
+    port->SetResponder(respond);
+
+    // A byte every 40 ms keeps the link alive without ever finishing the frame
+    std::atomic<bool> stop{false};
+    std::thread drip;
+    if (trickle) {
+        drip = std::thread([&] {
+            const uint8_t b = 0x55;
+            while (!stop.load()) {
+                port->Inject(&b, 1);
+                std::this_thread::sleep_for(std::chrono::milliseconds(40));
+            }
+        });
+    }
+
+    worker.RequestCapture(session);
+    CaptureEvent ev;
+    ExpectEvent(worker, session, CaptureEventType::Timeout, ev, what.c_str());
+    stop = true;
+    if (drip.joinable()) drip.join();
+
+    Expect(ev.timeout == kind, what + ": reported as " + CaptureTimeoutName(ev.timeout));
+    uint32_t limit = kind == CaptureTimeoutKind::FirstByte ? timeouts.first_byte_ms :
+                     kind == CaptureTimeoutKind::Frame ? timeouts.frame_ms : timeouts.inter_byte_ms;
+    Expect(ev.elapsed_ms >= limit, what + ": not before its deadline");
+    Expect(ev.elapsed_ms < limit + timeouts.first_byte_ms, what + ": reported promptly");
+    if (kind == CaptureTimeoutKind::FirstByte) Expect(ev.bytes == 0, what + ": no bytes");
+    else Expect(ev.bytes > 0 && ev.bytes < BITMAP_SIZE, what + ": partial frame counted");
+    worker.RemoveSession(session);
+}
+
+static void TestTimeouts(CaptureWorker& worker) {
+    TestTimeout(worker, CaptureTimeoutKind::FirstByte, nullptr, false);
+    TestTimeout(worker, CaptureTimeoutKind::InterByte, [](LoopbackTransport& p, const uint8_t*, size_t) {
+        std::vector<uint8_t> half = MakeFrame(2);
+        p.Inject(half.data(), BITMAP_SIZE / 2);
+    }, false);
+    TestTimeout(worker, CaptureTimeoutKind::Frame, [](LoopbackTransport& p, const uint8_t*, size_t) {
+        const uint8_t b = 0x55;
+        p.Inject(&b, 1);
+    }, true);
+}
+
+// Every request is answered with the next frame of a numbered sequence
+struct FrameResponder {
+    std::atomic<int> sent{0};
+
+    LoopbackTransport::Responder Get() {
+        return [this](LoopbackTransport& p, const uint8_t*, size_t) {
+            std::vector<uint8_t> frame = MakeFrame(100 + sent.fetch_add(1));
+            p.Inject(frame.data(), frame.size());
+        };
+    }
+};
+
+static void TestBurst(CaptureWorker& worker) {
+    LoopbackTransport* port;
+    int session = AddLoopback(worker, port);
+    FrameResponder radio;
+    port->SetResponder(radio.Get());
+
+    // A counted burst stops by itself, with every frame in order
+    const int COUNT = 12;
+    Expect(worker.RequestBurst(session, COUNT), "burst: request queued");
+    CaptureEvent ev;
+    for (int i = 0; i < COUNT; i++) {
+        ExpectEvent(worker, session, CaptureEventType::Frame, ev, "burst: frame");
+        Expect(memcmp(ev.frame, MakeFrame(100 + i).data(), BITMAP_SIZE) == 0, "burst: frames in order");
+    }
+    ExpectEvent(worker, session, CaptureEventType::BurstDone, ev, "burst: done");
+    Expect(ev.burst_frames == COUNT && ev.burst_failed == 0 && ev.burst_dropped == 0, "burst: counts");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    Expect(radio.sent.load() == COUNT, "burst: no request past the count");
+
+    // An open-ended one runs until stopped; the frame in flight still arrives, then BurstDone
+    Expect(worker.RequestBurst(session, 0), "burst: open-ended request queued");
+    int frames = 0;
+    while (frames < 5 && NextEvent(worker, ev) && ev.type == CaptureEventType::Frame) frames++;
+    Expect(frames == 5, "burst: open-ended burst runs");
+    worker.RequestStopBurst(session);
+    while (NextEvent(worker, ev) && ev.type == CaptureEventType::Frame) frames++;
+    Expect(ev.type == CaptureEventType::BurstDone && ev.burst_frames == frames,
+           "burst: stopped, and done reports every frame delivered");
+    int requests = radio.sent.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    Expect(radio.sent.load() == requests && requests - COUNT == frames, "burst: no request after the stop");
+    Expect(!worker.PollEvent(ev), "burst: nothing after BurstDone");
+    worker.RemoveSession(session);
+}
+
+// A port that dies mid-capture is reported and its session closed
+static void TestPortFailure(CaptureWorker& worker) {
+    LoopbackTransport* port;
+    int session = AddLoopback(worker, port);
+    // Closed on the worker thread, the way a device that drops off the bus fails a read
+    port->SetResponder([](LoopbackTransport& p, const uint8_t*, size_t) { p.Close(); });
+    worker.RequestCapture(session);
+    CaptureEvent ev;
+    ExpectEvent(worker, session, CaptureEventType::Error, ev, "port failure");
+    worker.RequestCapture(session);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    Expect(!worker.PollEvent(ev), "port failure: session closed");
+}
+
+static CaptureEvent MakeEvent(CaptureEventType type, int n) {
+    CaptureEvent ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = type;
+    ev.bytes = n;
+    return ev;
+}
+
+// The UI queue holds 64 events; while it's full the outbox keeps up to CAPTURE_EVENT_BACKLOG
+// droppable events (and any number of the rest), in order
+static void TestOutbox() {
+    std::unique_ptr<CaptureEventQueue> queue(new CaptureEventQueue());
+    CaptureEventOutbox outbox(*queue);
+
+    int pushed = 0;
+    while (outbox.Push(MakeEvent(CaptureEventType::Frame, pushed), true) && pushed < 100000) pushed++;
+    Expect(pushed == 64 + (int)CAPTURE_EVENT_BACKLOG, "outbox: queue plus backlog before dropping");
+    Expect(outbox.Backlogged(), "outbox: backlogged");
+    Expect(!outbox.Push(MakeEvent(CaptureEventType::Progress, -1), false), "outbox: progress dropped when backlogged");
+    Expect(outbox.Push(MakeEvent(CaptureEventType::BurstDone, pushed), false), "outbox: non-droppable kept");
+
+    // Draining the queue lets the backlog through in order, the kept event last
+    CaptureEvent ev;
+    int next = 0;
+    bool inOrder = true;
+    while (true) {
+        if (!queue->TryPop(ev)) {
+            outbox.Flush();
+            if (!queue->TryPop(ev)) break;
+        }
+        if (ev.bytes != next++) inOrder = false;
+    }
+    Expect(inOrder && next == pushed + 1 && ev.type == CaptureEventType::BurstDone, "outbox: drained in order");
+    Expect(!outbox.Backlogged(), "outbox: empty once drained");
+
+    // Once there's room again events go straight through
+    Expect(outbox.Push(MakeEvent(CaptureEventType::Progress, 0), false) && queue->TryPop(ev),
+           "outbox: progress delivered when the queue has room");
+}
+
+int main() {
+    {
+        CaptureWorker worker;
+        TestCapture(worker);
+        TestTimeouts(worker);
+        TestBurst(worker);
+        TestPortFailure(worker);
+    }
+    TestOutbox();
+
+    if (g_failures) {
+        printf("%d failures\n", g_failures);
+        return 1;
+    }
+    printf("Capture worker: capture, timeouts, bursts, port failure and event backlog OK\n");
+    return 0;
+}
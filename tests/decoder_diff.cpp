@@ -0,0 +1,266 @@
+// RadShot - Frame decoder differential test
+// Checks every FrameDecoder entry point, on every decode path this CPU can run, against
+// the original per-pixel ProcessBitmap it replaced, and the other controller layouts and
+// geometries against a per-pixel reading of their layout. Frames are all clear, all set
+// and random; any byte that differs fails the test.
+//
+// Portable (no Win32 dependencies). Built by tests/CMakeLists.txt.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "frame_decoder.h"
+
+// =============================================================================
+// Reference (ProcessBitmap as it was before the fused decoder)
+// =============================================================================
+
+namespace reference {
+
+inline int GetPixel(const uint8_t* bitmap, int x, int y) {
+    return (bitmap[x + ((y / 8) * DISPLAY_WIDTH)] >> (y & 7)) & 1;
+}
+
+inline void SetPixel(uint8_t* buffer, int x, int y, int color) {
+    buffer[(x / 8) + ((DISPLAY_HEIGHT - 1 - y) * 16)] |= (color << (7 - (x & 7)));
+}
+
+void ProcessBitmap(const uint8_t* raw, uint8_t* rgba_preview, uint8_t* rgba_thumb) {
+    // Convert raw device format to standard format
+    uint8_t processed[BITMAP_SIZE] = {0};
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            SetPixel(processed, x, y, GetPixel(raw, x, y));
+        }
+    }
+
+    // Generate preview (4x upscaled) and thumbnail
+    int preview_w = DISPLAY_WIDTH * PREVIEW_SCALE;
+
+    for (int sy = 0; sy < DISPLAY_HEIGHT; sy++) {
+        for (int sx = 0; sx < DISPLAY_WIDTH; sx++) {
+            // Read from processed bitmap
+            int byte_idx = (sx / 8) + ((DISPLAY_HEIGHT - 1 - sy) * 16);
+            int bit_idx = 7 - (sx & 7);
+            int pixel = (processed[byte_idx] >> bit_idx) & 1;
+
+            const uint8_t* color = pixel ? COLOR_DARK : COLOR_LIGHT;
+
+            // Write to thumbnail (1x)
+            int thumb_idx = (sy * DISPLAY_WIDTH + sx) * 4;
+            memcpy(rgba_thumb + thumb_idx, color, 4);
+
+            // Write to preview (4x upscaled with nearest neighbor)
+            for (int py = 0; py < PREVIEW_SCALE; py++) {
+                for (int px = 0; px < PREVIEW_SCALE; px++) {
+                    int preview_x = sx * PREVIEW_SCALE + px;
+                    int preview_y = sy * PREVIEW_SCALE + py;
+                    int preview_idx = (preview_y * preview_w + preview_x) * 4;
+                    memcpy(rgba_preview + preview_idx, color, 4);
+                }
+            }
+        }
+    }
+}
+
+} // namespace reference
+
+// =============================================================================
+// Test Harness
+// =============================================================================
+
+static int g_failures = 0;
+
+static const char* PathName(DecoderPath path) {
+    switch (path) {
+    case DecoderPath::AVX2: return "AVX2";
+    case DecoderPath::SSE2: return "SSE2";
+    default: return "Scalar";
+    }
+}
+
+// Every path the host can run: the scalar one always, the vector ones on x86
+static std::vector<DecoderPath> RunnablePaths() {
+    std::vector<DecoderPath> paths = { DecoderPath::Scalar };
+    DecoderPath best = DetectDecoderPath();
+    if (best != DecoderPath::Scalar) paths.push_back(DecoderPath::SSE2);
+    if (best == DecoderPath::AVX2) paths.push_back(DecoderPath::AVX2);
+    return paths;
+}
+
+static void Expect(bool ok, const char* what, DecoderPath path, int frame) {
+    if (ok) return;
+    if (g_failures < 20) printf("FAIL %s (%s path, frame %d)\n", what, PathName(path), frame);
+    g_failures++;
+}
+
+static std::vector<std::vector<uint8_t>> TestFrames(int count, size_t bytes) {
+    std::mt19937 rng(1);
+    std::vector<std::vector<uint8_t>> frames;
+    frames.emplace_back(bytes, 0x00);
+    frames.emplace_back(bytes, 0xFF);
+    while ((int)frames.size() < count) {
+        std::vector<uint8_t> frame(bytes);
+        for (uint8_t& b : frame) b = (uint8_t)rng();
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+// =============================================================================
+// RT-4D Decoder
+// =============================================================================
+
+static void TestRt4d(const std::vector<DecoderPath>& paths) {
+    using D = Rt4dDecoder;
+    const auto frames = TestFrames(200, BITMAP_SIZE);
+
+    std::vector<uint8_t> refPreview(D::PREVIEW_BYTES), refThumb(D::THUMB_BYTES);
+    std::vector<uint8_t> preview(D::PREVIEW_BYTES), thumb(D::THUMB_BYTES), index(D::INDEX_BYTES);
+    std::vector<uint8_t> scaled((size_t)D::WIDTH * 16 * D::HEIGHT * 16 * 4), expected((size_t)D::WIDTH * 16 * 4);
+
+    for (int f = 0; f < (int)frames.size(); f++) {
+        const uint8_t* raw = frames[f].data();
+        reference::ProcessBitmap(raw, refPreview.data(), refThumb.data());
+
+        for (DecoderPath path : paths) {
+            // Whole frame
+            memset(preview.data(), 0x55, preview.size());
+            memset(thumb.data(), 0x55, thumb.size());
+            D::Decode(raw, preview.data(), thumb.data(), GetPixelLut(), path);
+            Expect(preview == refPreview, "Decode preview", path, f);
+            Expect(thumb == refThumb, "Decode thumbnail", path, f);
+
+            // Band by band, each from only the bytes received so far
+            memset(preview.data(), 0x55, preview.size());
+            memset(thumb.data(), 0x55, thumb.size());
+            for (int band = 0; band < D::BANDS; band++) {
+                std::vector<uint8_t> partial(raw, raw + (band + 1) * D::BAND_BYTES);
+                D::DecodeBand(partial.data(), band, preview.data() + band * D::BAND_PREVIEW_BYTES,
+                              thumb.data() + band * D::BAND_THUMB_BYTES, GetPixelLut(), path);
+            }
+            Expect(preview == refPreview, "DecodeBand preview", path, f);
+            Expect(thumb == refThumb, "DecodeBand thumbnail", path, f);
+
+            // Palette indices
+            D::DecodeIndex(raw, index.data(), path);
+            bool indexOk = true;
+            for (int i = 0; i < D::WIDTH * D::HEIGHT; i++) {
+                bool dark = memcmp(&refThumb[i * 4], COLOR_DARK, 4) == 0;
+                indexOk &= index[i] == (dark ? 0xFF : 0x00);
+            }
+            Expect(indexOk, "DecodeIndex", path, f);
+
+            // Every integer scale, top-down and bottom-up
+            for (int scale = 1; scale <= 16; scale++) {
+                if (f >= 4 && scale != 1 && scale != D::SCALE) continue;
+                const int w = D::WIDTH * scale;
+                const int h = D::HEIGHT * scale;
+                const ptrdiff_t stride = (ptrdiff_t)w * 4;
+                for (int flip = 0; flip < 2; flip++) {
+                    memset(scaled.data(), 0x55, (size_t)h * stride);
+                    uint8_t* origin = flip ? scaled.data() + (h - 1) * stride : scaled.data();
+                    D::DecodeScaled(raw, scale, origin, flip ? -stride : stride, GetPixelLut(), path);
+                    bool ok = true;
+                    for (int y = 0; y < D::HEIGHT && ok; y++) {
+                        for (int x = 0; x < w; x++) memcpy(&expected[x * 4], &refThumb[(y * D::WIDTH + x / scale) * 4], 4);
+                        for (int i = 0; i < scale; i++) {
+                            int outY = y * scale + i;
+                            ok &= memcmp(scaled.data() + (flip ? h - 1 - outY : outY) * stride, expected.data(), stride) == 0;
+                        }
+                    }
+                    Expect(ok, flip ? "DecodeScaled bottom-up" : "DecodeScaled", path, f);
+                }
+            }
+        }
+    }
+}
+
+// =============================================================================
+// Other Layouts and Geometries
+// =============================================================================
+
+// Pixel (x, y) of a raw frame, read the slow way
+template <typename Layout>
+struct LayoutReference;
+
+template <bool MsbTop>
+struct LayoutReference<PageLayout<MsbTop>> {
+    static int Pixel(const uint8_t* raw, int width, int x, int y) {
+        int bit = MsbTop ? 7 - (y & 7) : (y & 7);
+        return (raw[x + (y / 8) * width] >> bit) & 1;
+    }
+};
+
+template <>
+struct LayoutReference<RowLayoutMsbLeft> {
+    static int Pixel(const uint8_t* raw, int width, int x, int y) {
+        return (raw[y * (width / 8) + x / 8] >> (7 - (x & 7))) & 1;
+    }
+};
+
+template <typename D, typename Layout>
+static void TestGeometry(const char* name, const std::vector<DecoderPath>& paths) {
+    const auto frames = TestFrames(50, D::FRAME_BYTES);
+
+    std::vector<uint8_t> refPreview(D::PREVIEW_BYTES), refThumb(D::THUMB_BYTES), refIndex(D::INDEX_BYTES);
+    std::vector<uint8_t> preview(D::PREVIEW_BYTES), thumb(D::THUMB_BYTES), index(D::INDEX_BYTES);
+
+    for (int f = 0; f < (int)frames.size(); f++) {
+        const uint8_t* raw = frames[f].data();
+        for (int y = 0; y < D::HEIGHT; y++) {
+            for (int x = 0; x < D::WIDTH; x++) {
+                int pixel = LayoutReference<Layout>::Pixel(raw, D::WIDTH, x, y);
+                const uint8_t* color = pixel ? COLOR_DARK : COLOR_LIGHT;
+                memcpy(&refThumb[(y * D::WIDTH + x) * 4], color, 4);
+                refIndex[y * D::WIDTH + x] = pixel ? 0xFF : 0x00;
+                for (int py = 0; py < D::SCALE; py++) {
+                    for (int px = 0; px < D::SCALE; px++) {
+                        size_t i = ((size_t)(y * D::SCALE + py) * D::PREVIEW_WIDTH + x * D::SCALE + px) * 4;
+                        memcpy(&refPreview[i], color, 4);
+                    }
+                }
+            }
+        }
+
+        for (DecoderPath path : paths) {
+            memset(preview.data(), 0x55, preview.size());
+            memset(thumb.data(), 0x55, thumb.size());
+            D::Decode(raw, preview.data(), thumb.data(), GetPixelLut(), path);
+            D::DecodeIndex(raw, index.data(), path);
+            bool ok = preview == refPreview && thumb == refThumb && index == refIndex;
+            if (!ok && g_failures < 20) printf("FAIL %s (%s path, frame %d)\n", name, PathName(path), f);
+            g_failures += !ok;
+        }
+    }
+}
+
+int main() {
+    const std::vector<DecoderPath> paths = RunnablePaths();
+    printf("Decode paths:");
+    for (DecoderPath path : paths) printf(" %s", PathName(path));
+    printf("\n");
+
+    TestRt4d(paths);
+
+    // The alternate layouts, and geometries whose widths leave the vector unpackers
+    // partly or wholly on their scalar fallback
+    using St7920Decoder = FrameDecoder<128, 64, RowLayoutMsbLeft, 4>;
+    TestGeometry<St7920Decoder, RowLayoutMsbLeft>("128x64 RowLayoutMsbLeft x4", paths);
+    TestGeometry<FrameDecoder<128, 64, PageLayoutMsbTop, 3>, PageLayoutMsbTop>("128x64 PageLayoutMsbTop x3", paths);
+    TestGeometry<FrameDecoder<160, 128, PageLayoutMsbTop, 5>, PageLayoutMsbTop>("160x128 PageLayoutMsbTop x5", paths);
+    TestGeometry<FrameDecoder<96, 32, PageLayoutLsbTop, 2>, PageLayoutLsbTop>("96x32 PageLayoutLsbTop x2", paths);
+    TestGeometry<FrameDecoder<64, 8, PageLayoutLsbTop, 8>, PageLayoutLsbTop>("64x8 PageLayoutLsbTop x8", paths);
+    TestGeometry<FrameDecoder<8, 8, RowLayoutMsbLeft, 1>, RowLayoutMsbLeft>("8x8 RowLayoutMsbLeft x1", paths);
+
+    if (g_failures) {
+        printf("%d failures\n", g_failures);
+        return 1;
+    }
+    printf("All decoders match their references\n");
+    return 0;
+}
@@ -0,0 +1,216 @@
+// RadShot - Palette shader test
+// Renders a screenshot texture (GL_R8 palette indices, as the app uploads them) through
+// ImGui with the palette shader into an offscreen framebuffer and reads it back: every
+// pixel must be the palette colour of its index, for each GLSL dialect the shader is
+// written for, and again after a palette change. Then checks that a shader which won't
+// compile is reported and the texture falls back to grey.
+//
+// Needs EGL with a headless device (Mesa's llvmpipe is enough); exits with 77, which
+// CTest counts as skipped, when there isn't one. Built by tests/CMakeLists.txt.
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "imgui.h"
+#include "imgui_impl_opengl3.h"
+#include "frame_decoder.h"
+#include "palette_shader.h"
+
+constexpr int TARGET_WIDTH = 640;
+constexpr int TARGET_HEIGHT = 320;
+constexpr int SKIPPED = 77;
+
+static int g_failures = 0;
+static PaletteShader* g_shader = nullptr;
+
+static void* GetGlProc(const char* name) {
+    return (void*)eglGetProcAddress(name);
+}
+
+static void UsePaletteShader(const ImDrawList*, const ImDrawCmd*) {
+    g_shader->Use();
+}
+
+// A surfaceless desktop GL context with an RGBA8 framebuffer bound
+static bool CreateContext() {
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (!getPlatformDisplay) return false;
+    EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr) || !eglBindAPI(EGL_OPENGL_API)) {
+        return false;
+    }
+    const EGLint attributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config;
+    EGLint configs = 0;
+    if (!eglChooseConfig(display, attributes, &config, 1, &configs) || configs == 0) return false;
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) return false;
+
+    GLuint framebuffer, renderbuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(1, &renderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, TARGET_WIDTH, TARGET_HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+// Made the way radshot.cpp's CreateTexture makes them
+static GLuint CreateTexture(const uint8_t* index) {
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    SetTextureSwizzle();
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, DISPLAY_WIDTH, DISPLAY_HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, index);
+    return tex;
+}
+
+// Draws the texture at PREVIEW_SCALE between the palette callbacks, then a red square with
+// ImGui's own shader, and returns the framebuffer top row first
+static std::vector<uint8_t> Render(GLuint tex) {
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui::NewFrame();
+    ImDrawList* drawList = ImGui::GetForegroundDrawList();
+    drawList->AddCallback(UsePaletteShader, nullptr);
+    drawList->AddImage((ImTextureID)(intptr_t)tex, ImVec2(0, 0), ImVec2(Rt4dDecoder::PREVIEW_WIDTH, Rt4dDecoder::PREVIEW_HEIGHT));
+    drawList->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+    drawList->AddRectFilled(ImVec2(Rt4dDecoder::PREVIEW_WIDTH + 8, 0), ImVec2(Rt4dDecoder::PREVIEW_WIDTH + 88, 40), IM_COL32(255, 0, 0, 255));
+    ImGui::Render();
+
+    glViewport(0, 0, TARGET_WIDTH, TARGET_HEIGHT);
+    glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+    std::vector<uint8_t> pixels((size_t)TARGET_WIDTH * TARGET_HEIGHT * 4), flipped(pixels.size());
+    glReadPixels(0, 0, TARGET_WIDTH, TARGET_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    for (int y = 0; y < TARGET_HEIGHT; y++) {
+        memcpy(&flipped[(size_t)y * TARGET_WIDTH * 4], &pixels[(size_t)(TARGET_HEIGHT - 1 - y) * TARGET_WIDTH * 4],
+               (size_t)TARGET_WIDTH * 4);
+    }
+    return flipped;
+}
+
+// Every preview pixel is `dark` where the index is set and `light` where it's clear, and
+// the square drawn after the reset is ImGui's red
+static void Check(const std::vector<uint8_t>& pixels, const uint8_t* index, const uint8_t* light,
+                  const uint8_t* dark, const char* what) {
+    int wrong = 0;
+    for (int y = 0; y < Rt4dDecoder::PREVIEW_HEIGHT; y++) {
+        for (int x = 0; x < Rt4dDecoder::PREVIEW_WIDTH; x++) {
+            const uint8_t* got = &pixels[((size_t)y * TARGET_WIDTH + x) * 4];
+            const uint8_t* want = index[(y / PREVIEW_SCALE) * DISPLAY_WIDTH + x / PREVIEW_SCALE] ? dark : light;
+            if (memcmp(got, want, 3) != 0) {
+                if (wrong == 0) {
+                    printf("FAIL %s: pixel %d,%d is %02x%02x%02x, expected %02x%02x%02x\n", what, x, y,
+                           got[0], got[1], got[2], want[0], want[1], want[2]);
+                }
+                wrong++;
+            }
+        }
+    }
+    const uint8_t* square = &pixels[((size_t)20 * TARGET_WIDTH + Rt4dDecoder::PREVIEW_WIDTH + 48) * 4];
+    if (square[0] != 255 || square[1] != 0 || square[2] != 0) {
+        printf("FAIL %s: ImGui's shader not restored after the callback\n", what);
+        wrong++;
+    }
+    if (wrong) g_failures++;
+}
+
+// Renders through a shader built for `shaderVersion` with ImGui on `imguiVersion`.
+// Returns whether the shader built.
+static bool RenderWith(const char* imguiVersion, const char* shaderVersion, GLuint tex, const uint8_t* index) {
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2((float)TARGET_WIDTH, (float)TARGET_HEIGHT);
+    io.IniFilename = nullptr;
+    ImGui_ImplOpenGL3_Init(imguiVersion);
+
+    PaletteShader shader;
+    g_shader = &shader;
+    bool built = false;
+    if (!shader.Load(GetGlProc, shaderVersion)) {
+        printf("FAIL %s: %s\n", shaderVersion, shader.Error().c_str());
+        g_failures++;
+    } else {
+        static const uint8_t WHITE[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+        static const uint8_t BLACK[4] = { 0x00, 0x00, 0x00, 0xFF };
+        static const uint8_t GREEN_LIGHT[4] = { 0x9B, 0xBC, 0x0F, 0xFF };
+        static const uint8_t GREEN_DARK[4] = { 0x0F, 0x38, 0x0F, 0xFF };
+
+        shader.SetColors(COLOR_LIGHT, COLOR_DARK);
+        std::vector<uint8_t> pixels = Render(tex);
+        built = !shader.Failed();
+        if (built) {
+            Check(pixels, index, COLOR_LIGHT, COLOR_DARK, shaderVersion);
+            // A palette change is only a uniform
+            shader.SetColors(GREEN_LIGHT, GREEN_DARK);
+            Check(Render(tex), index, GREEN_LIGHT, GREEN_DARK, shaderVersion);
+        } else {
+            // Reported, and ImGui's shader draws the swizzled index instead
+            if (shader.Error().empty()) {
+                printf("FAIL %s: no error reported\n", shaderVersion);
+                g_failures++;
+            }
+            Check(pixels, index, BLACK, WHITE, "fallback");
+        }
+    }
+
+    shader.Destroy();
+    g_shader = nullptr;
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui::DestroyContext();
+    return built;
+}
+
+int main() {
+    if (!CreateContext()) {
+        printf("No headless EGL/OpenGL device: skipped\n");
+        return SKIPPED;
+    }
+    printf("%s, %s\n", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+
+    std::mt19937 rng(1);
+    uint8_t raw[BITMAP_SIZE];
+    for (uint8_t& b : raw) b = (uint8_t)rng();
+    uint8_t index[Rt4dDecoder::INDEX_BYTES];
+    DecodeFrameIndex(raw, index);
+    GLuint tex = CreateTexture(index);
+
+    // The version radshot.cpp uses, GLSL 1.20 (attribute/varying) and a core profile version
+    const char* versions[] = { "#version 130", "#version 120", "#version 330 core" };
+    for (const char* version : versions) {
+        if (!RenderWith(version, version, tex, index)) {
+            printf("FAIL %s: shader didn't build\n", version);
+            g_failures++;
+        }
+    }
+
+    // A shader that can't compile is reported, and the texture still reads
+    if (RenderWith("#version 130", "#version 999", tex, index)) {
+        printf("FAIL #version 999 built\n");
+        g_failures++;
+    }
+
+    glDeleteTextures(1, &tex);
+    if (g_failures) {
+        printf("%d failures\n", g_failures);
+        return 1;
+    }
+    printf("Palette shader renders every palette index\n");
+    return 0;
+}
@@ -0,0 +1,190 @@
+// RadShot - Indexed PNG round-trip test
+// Encodes frames with EncodeIndexedPng in every palette preset at several scales and reads
+// them back with a reader of its own built on zlib (CRC and inflate), so nothing is
+// shared with the writer but the format. Checks the chunk layout and CRCs, IHDR, PLTE,
+// tRNS (present exactly when a colour isn't opaque), the row filters, and that every
+// pixel matches the frame decoded in that palette.
+//
+// Portable (no Win32 dependencies). Built by tests/CMakeLists.txt when zlib is found.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include "frame_decoder.h"
+#include "palette.h"
+#include "png_writer.h"
+
+static int g_failures = 0;
+
+// A decoded indexed PNG
+struct PngImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint8_t palette[2][4] = {};
+    bool transparency = false;
+    std::vector<uint8_t> rgba;
+};
+
+static uint32_t Be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Reads a bit depth 1, 2-colour indexed PNG. Returns an empty string or what is wrong.
+static std::string ReadPng(const std::vector<uint8_t>& png, PngImage& image) {
+    static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if (png.size() < 8 || memcmp(png.data(), SIGNATURE, 8) != 0) return "bad signature";
+
+    std::vector<uint8_t> idat;
+    std::vector<std::string> order;
+    bool palette = false;
+    size_t pos = 8;
+    while (pos < png.size()) {
+        if (png.size() - pos < 12) return "truncated chunk";
+        uint32_t length = Be32(&png[pos]);
+        if (png.size() - pos - 12 < length) return "chunk overruns the file";
+        const uint8_t* type = &png[pos + 4];
+        const uint8_t* data = type + 4;
+        if ((uint32_t)crc32(0, type, length + 4) != Be32(data + length)) return "bad CRC";
+        std::string name((const char*)type, 4);
+        if (!order.empty() && order.back() == "IEND") return "data after IEND";
+        order.push_back(name);
+
+        if (name == "IHDR") {
+            if (order.size() != 1) return "IHDR not first";
+            if (length != 13) return "IHDR length";
+            image.width = Be32(data);
+            image.height = Be32(data + 4);
+            if (data[8] != 1 || data[9] != 3) return "not bit depth 1 indexed";
+            if (data[10] != 0 || data[11] != 0 || data[12] != 0) return "IHDR compression, filter or interlace";
+        } else if (name == "PLTE") {
+            if (palette || !idat.empty()) return "PLTE misplaced";
+            if (length != 6) return "PLTE not 2 entries";
+            for (int i = 0; i < 2; i++) {
+                memcpy(image.palette[i], data + i * 3, 3);
+                image.palette[i][3] = 0xFF;
+            }
+            palette = true;
+        } else if (name == "tRNS") {
+            if (!palette || !idat.empty() || image.transparency) return "tRNS misplaced";
+            if (length != 2) return "tRNS not 2 entries";
+            image.palette[0][3] = data[0];
+            image.palette[1][3] = data[1];
+            image.transparency = true;
+        } else if (name == "IDAT") {
+            if (!palette) return "IDAT before PLTE";
+            idat.insert(idat.end(), data, data + length);
+        } else if (name != "IEND") {
+            return "unexpected chunk " + name;
+        }
+        pos += 12 + length;
+    }
+    if (order.empty() || order.back() != "IEND") return "no IEND";
+
+    const size_t rowBytes = 1 + ((size_t)image.width + 7) / 8;
+    std::vector<uint8_t> rows(rowBytes * image.height + 1);
+    uLongf size = (uLongf)rows.size();
+    if (uncompress(rows.data(), &size, idat.data(), (uLong)idat.size()) != Z_OK) return "IDAT doesn't inflate";
+    if (size != rowBytes * image.height) return "IDAT size";
+
+    image.rgba.resize((size_t)image.width * image.height * 4);
+    for (uint32_t y = 0; y < image.height; y++) {
+        const uint8_t* row = &rows[y * rowBytes];
+        if (row[0] != 0) return "row filter not None";
+        for (uint32_t x = 0; x < image.width; x++) {
+            int bit = (row[1 + x / 8] >> (7 - x % 8)) & 1;
+            memcpy(&image.rgba[((size_t)y * image.width + x) * 4], image.palette[bit], 4);
+        }
+    }
+    return "";
+}
+
+static void Expect(bool ok, const std::string& what, int frame, int palette, int scale) {
+    if (ok) return;
+    if (g_failures < 20) {
+        printf("FAIL %s (frame %d, %s, scale %d)\n", what.c_str(), frame, PALETTE_PRESETS[palette].name, scale);
+    }
+    g_failures++;
+}
+
+static std::vector<std::vector<uint8_t>> TestFrames() {
+    std::vector<std::vector<uint8_t>> frames;
+    frames.emplace_back(BITMAP_SIZE, 0x00);
+    frames.emplace_back(BITMAP_SIZE, 0xFF);
+    std::vector<uint8_t> sparse(BITMAP_SIZE, 0x00);   // Mostly clear, like a menu screen
+    for (int i = 0; i < BITMAP_SIZE; i++) {
+        if ((i % DISPLAY_WIDTH < 40 && (i / DISPLAY_WIDTH) % 3 == 0) || i % 7 == 0) sparse[i] = 0x18;
+    }
+    frames.push_back(sparse);
+    std::mt19937 rng(1);
+    for (int f = 0; f < 3; f++) {
+        std::vector<uint8_t> frame(BITMAP_SIZE);
+        for (uint8_t& b : frame) b = (uint8_t)rng();
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+int main() {
+    const auto frames = TestFrames();
+    const int scales[] = { 1, 2, 3, 4, 5, 8, 16 };
+    std::vector<uint8_t> png, expected;
+
+    for (int f = 0; f < (int)frames.size(); f++) {
+        const uint8_t* raw = frames[f].data();
+        for (int p = 0; p < PALETTE_COUNT; p++) {
+            const PalettePreset& preset = PALETTE_PRESETS[p];
+            const PixelLut lut = MakePixelLut(preset.light, preset.dark);
+            const bool opaque = preset.light[3] == 0xFF && preset.dark[3] == 0xFF;
+            for (int scale : scales) {
+                if (!EncodeIndexedPng(raw, scale, preset.light, preset.dark, png)) {
+                    Expect(false, "EncodeIndexedPng", f, p, scale);
+                    continue;
+                }
+                PngImage image;
+                std::string error = ReadPng(png, image);
+                Expect(error.empty(), error, f, p, scale);
+                if (!error.empty()) continue;
+
+                const uint32_t width = (uint32_t)(DISPLAY_WIDTH * scale);
+                const uint32_t height = (uint32_t)(DISPLAY_HEIGHT * scale);
+                Expect(image.width == width && image.height == height, "IHDR size", f, p, scale);
+                Expect(memcmp(image.palette[0], preset.light, 4) == 0 && memcmp(image.palette[1], preset.dark, 4) == 0,
+                       "PLTE/tRNS colours", f, p, scale);
+                Expect(image.transparency == !opaque, opaque ? "tRNS on an opaque palette" : "tRNS missing", f, p, scale);
+
+                expected.resize((size_t)width * height * 4);
+                DecodeFrameScaled(raw, scale, expected.data(), (ptrdiff_t)width * 4, lut);
+                Expect(image.rgba == expected, "pixels", f, p, scale);
+            }
+        }
+    }
+
+    // The file is the encoded buffer, byte for byte
+    const char* path = "png_roundtrip.png";
+    std::vector<uint8_t> written;
+    if (WriteIndexedPng(path, frames.back().data(), 3, PALETTE_PRESETS[0].light, PALETTE_PRESETS[0].dark, png)) {
+        FILE* file = fopen(path, "rb");
+        if (file) {
+            uint8_t buffer[4096];
+            size_t n;
+            while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) written.insert(written.end(), buffer, buffer + n);
+            fclose(file);
+        }
+        remove(path);
+    }
+    Expect(!written.empty() && written == png, "WriteIndexedPng file", (int)frames.size() - 1, 0, 3);
+
+    if (g_failures) {
+        printf("%d failures\n", g_failures);
+        return 1;
+    }
+    printf("All PNGs round-trip: %d frames x %d palettes x %d scales\n", (int)frames.size(), PALETTE_COUNT,
+           (int)(sizeof(scales) / sizeof(scales[0])));
+    return 0;
+}
@@ -0,0 +1,277 @@
+// RadShot - Frame recording round-trip test
+// Writes a long recording (several index blocks) with RecordingWriter and reads it back
+// with RecordingReader: every frame and timestamp in order, then random seeks. Then damages
+// copies of the file the way a crash or a bad disk would - cut mid-chunk, trailer lost,
+// chunk sizes and checks overwritten - and checks the reader keeps exactly the frames
+// before the damage and never reads past its buffers.
+//
+// Portable (no Win32 dependencies). Built by tests/CMakeLists.txt.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "frame_recording.h"
+
+constexpr uint32_t FRAMES = 40000;   // 1250 keyframes, 5 index blocks
+constexpr const char* PATH = "recording_roundtrip.rsrec";
+constexpr const char* DAMAGED_PATH = "recording_roundtrip_damaged.rsrec";
+
+static int g_failures = 0;
+
+static void Expect(bool ok, const std::string& what) {
+    if (ok) return;
+    if (g_failures < 20) printf("FAIL %s\n", what.c_str());
+    g_failures++;
+}
+
+// A capture's worth of frames: mostly unchanged screens, small edits, and now and then a
+// new screen of noise
+static std::vector<std::vector<uint8_t>> MakeFrames(uint32_t count) {
+    std::mt19937 rng(1);
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<uint8_t> frame(BITMAP_SIZE, 0);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t kind = rng() % 100;
+        if (kind < 2) {
+            for (uint8_t& b : frame) b = (uint8_t)rng();
+        } else if (kind < 4) {
+            std::fill(frame.begin(), frame.end(), (uint8_t)(rng() & 1 ? 0xFF : 0x00));
+        } else if (kind < 40) {
+            int edits = 1 + (int)(rng() % 24);
+            for (int e = 0; e < edits; e++) frame[rng() % BITMAP_SIZE] = (uint8_t)rng();
+        }
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+static std::vector<uint8_t> ReadFile(const char* path) {
+    std::vector<uint8_t> data;
+    FILE* f = fopen(path, "rb");
+    if (!f) return data;
+    uint8_t buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) data.insert(data.end(), buffer, buffer + n);
+    fclose(f);
+    return data;
+}
+
+static void WriteFile(const char* path, const std::vector<uint8_t>& data, size_t size) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return;
+    fwrite(data.data(), 1, size, f);
+    fclose(f);
+}
+
+// Chunk fields overwritten in place (chunks aren't aligned in the file)
+static void SetChunkSize(std::vector<uint8_t>& file, uint64_t offset, uint16_t size) {
+    memcpy(&file[offset + offsetof(RecordingChunkHeader, size)], &size, sizeof(size));
+}
+
+static void FlipChunkCheck(std::vector<uint8_t>& file, uint64_t offset) {
+    file[offset + offsetof(RecordingChunkHeader, check)] ^= 1;
+}
+
+// Offsets of the frame chunks, found by walking the chunk headers
+static std::vector<uint64_t> FrameChunks(const std::vector<uint8_t>& file, size_t end) {
+    std::vector<uint64_t> offsets;
+    size_t pos = sizeof(RecordingHeader);
+    while (pos + sizeof(RecordingChunkHeader) <= end) {
+        RecordingChunkHeader chunk;
+        memcpy(&chunk, &file[pos], sizeof(chunk));
+        if (chunk.type != (uint8_t)RecordingChunkType::Key && chunk.type != (uint8_t)RecordingChunkType::Delta &&
+            chunk.type != (uint8_t)RecordingChunkType::Index) {
+            break;
+        }
+        if (chunk.type != (uint8_t)RecordingChunkType::Index) offsets.push_back(pos);
+        pos += sizeof(chunk) + chunk.size;
+    }
+    return offsets;
+}
+
+// Opens `path` and checks it holds exactly the first `count` frames
+static void ExpectFrames(const char* path, const std::vector<std::vector<uint8_t>>& frames,
+                         const std::vector<uint32_t>& times, uint32_t count, bool recovered, const std::string& what) {
+    RecordingReader reader;
+    std::string error;
+    if (!reader.Open(path, error)) {
+        Expect(false, what + ": open: " + error);
+        return;
+    }
+    Expect(reader.Recovered() == recovered, what + ": Recovered()");
+    Expect(reader.Count() == count, what + ": " + std::to_string(reader.Count()) + " frames, expected " +
+                                        std::to_string(count));
+    uint8_t frame[BITMAP_SIZE];
+    uint32_t time = 0;
+    bool ok = true;
+    for (uint32_t i = 0; i < reader.Count() && i < count; i++) {
+        ok &= reader.Read(i, frame, &time) && memcmp(frame, frames[i].data(), BITMAP_SIZE) == 0 && time == times[i];
+    }
+    Expect(ok, what + ": frames before the damage");
+    Expect(!reader.Read(reader.Count(), frame), what + ": read past the end");
+}
+
+static void TestCoder() {
+    std::mt19937 rng(2);
+    std::vector<uint8_t> in(BITMAP_SIZE), out(BITMAP_SIZE), payload(RECORDING_MAX_PAYLOAD);
+    bool ok = true;
+    for (int t = 0; t < 2000; t++) {
+        // Runs of zeros, repeats and literals of every length, and pure noise
+        int density = t % 5;
+        for (uint8_t& b : in) {
+            uint32_t r = rng() % 8;
+            b = r < (uint32_t)density ? (uint8_t)rng() : (r == 7 ? 0xAA : 0);
+        }
+        if (t == 0) std::fill(in.begin(), in.end(), 0);
+        if (t == 1) for (uint8_t& b : in) b = (uint8_t)rng() | 1;
+        size_t size = RecordingEncode(in.data(), payload.data());
+        ok &= size <= RECORDING_MAX_PAYLOAD;
+        ok &= RecordingDecode(payload.data(), size, out.data()) && out == in;
+        ok &= t != 0 || size == 0;
+    }
+    Expect(ok, "residual coder round-trip");
+
+    // Malformed payloads are refused rather than overrunning the frame
+    const uint8_t tooLong[] = { 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F };   // 1152 zeros
+    const uint8_t cutLiteral[] = { 0x85, 1, 2 };
+    const uint8_t cutRun[] = { 0xC0 };
+    Expect(!RecordingDecode(tooLong, sizeof(tooLong), out.data()), "coder: run past the frame");
+    Expect(!RecordingDecode(cutLiteral, sizeof(cutLiteral), out.data()), "coder: literals past the payload");
+    Expect(!RecordingDecode(cutRun, sizeof(cutRun), out.data()), "coder: run without its byte");
+}
+
+int main() {
+    TestCoder();
+
+    const auto frames = MakeFrames(FRAMES);
+    std::vector<uint32_t> times(FRAMES);
+    std::mt19937 rng(3);
+    for (uint32_t i = 0, t = 0; i < FRAMES; i++, t += 20 + rng() % 200) times[i] = t;
+
+    ArchiveTime start = {};
+    start.year = 2026;
+    std::string error;
+    {
+        RecordingWriter writer;
+        Expect(writer.Open(PATH, start, "COM7", error), "writer open: " + error);
+        for (uint32_t i = 0; i < FRAMES; i++) writer.Append(frames[i].data(), times[i]);
+        Expect(writer.Frames() == FRAMES, "writer frame count");
+        Expect(writer.Close(), "writer close");
+    }
+
+    // In order, then random seeks either way
+    {
+        RecordingReader reader;
+        Expect(reader.Open(PATH, error), "reader open: " + error);
+        Expect(!reader.Recovered(), "intact recording reported recovered");
+        Expect(reader.Count() == FRAMES, "frame count");
+        Expect(reader.Keyframes() == (FRAMES + RECORDING_KEYFRAME_INTERVAL - 1) / RECORDING_KEYFRAME_INTERVAL,
+               "keyframe count");
+        Expect(reader.DurationMs() == times.back(), "duration");
+        Expect(strcmp(reader.Header().port, "COM7") == 0 && reader.Header().start.year == 2026, "header");
+
+        uint8_t frame[BITMAP_SIZE];
+        uint32_t time = 0;
+        bool ok = true;
+        for (uint32_t i = 0; i < FRAMES; i++) {
+            ok &= reader.Read(i, frame, &time) && memcmp(frame, frames[i].data(), BITMAP_SIZE) == 0 && time == times[i];
+        }
+        Expect(ok, "sequential read");
+
+        ok = true;
+        for (int s = 0; s < 5000; s++) {
+            uint32_t i = rng() % FRAMES;
+            ok &= reader.Read(i, frame, &time) && memcmp(frame, frames[i].data(), BITMAP_SIZE) == 0 && time == times[i];
+        }
+        Expect(ok, "random seeks");
+        Expect(!reader.Read(FRAMES, frame), "read past the end");
+    }
+
+    const std::vector<uint8_t> file = ReadFile(PATH);
+    const size_t body = file.size() - sizeof(RecordingTrailer);
+    const std::vector<uint64_t> chunks = FrameChunks(file, body);
+    Expect(chunks.size() == FRAMES, "chunk walk");
+    if (chunks.size() != FRAMES) return 1;
+
+    // Trailer lost: everything is found by scanning
+    WriteFile(DAMAGED_PATH, file, body);
+    ExpectFrames(DAMAGED_PATH, frames, times, FRAMES, true, "no trailer");
+
+    // Cut mid-header and mid-payload: the frames before the cut survive
+    for (uint32_t k : { 1u, 31u, 32u, 8193u, 25000u, FRAMES - 1 }) {
+        WriteFile(DAMAGED_PATH, file, (size_t)chunks[k] + 5);
+        ExpectFrames(DAMAGED_PATH, frames, times, k, true, "cut in header of frame " + std::to_string(k));
+        RecordingChunkHeader chunk;
+        memcpy(&chunk, &file[chunks[k]], sizeof(chunk));
+        if (chunk.size > 1) {
+            WriteFile(DAMAGED_PATH, file, (size_t)chunks[k] + sizeof(chunk) + chunk.size / 2);
+            ExpectFrames(DAMAGED_PATH, frames, times, k, true, "cut in payload of frame " + std::to_string(k));
+        }
+    }
+
+    // Damaged chunks in a recording with no trailer: the scan stops there
+    for (uint32_t k : { 0u, 100u, 12345u }) {
+        std::vector<uint8_t> damaged = file;
+        const std::string at = " at frame " + std::to_string(k);
+
+        SetChunkSize(damaged, chunks[k], 60000);   // Past the reader's payload buffer
+        WriteFile(DAMAGED_PATH, damaged, body);
+        ExpectFrames(DAMAGED_PATH, frames, times, k, true, "oversized chunk" + at);
+
+        SetChunkSize(damaged, chunks[k], (uint16_t)(RECORDING_MAX_PAYLOAD + 1));   // Fits the buffer, too big for a frame
+        WriteFile(DAMAGED_PATH, damaged, body);
+        ExpectFrames(DAMAGED_PATH, frames, times, k, true, "overlong frame chunk" + at);
+
+        damaged = file;
+        FlipChunkCheck(damaged, chunks[k]);
+        WriteFile(DAMAGED_PATH, damaged, body);
+        ExpectFrames(DAMAGED_PATH, frames, times, k, true, "bad check" + at);
+    }
+
+    // With the trailer intact a bad frame fails only the reads that decode it
+    {
+        std::vector<uint8_t> damaged = file;
+        const uint32_t k = 20000;   // A keyframe: everything up to the next one depends on it
+        FlipChunkCheck(damaged, chunks[k]);
+        WriteFile(DAMAGED_PATH, damaged, damaged.size());
+        RecordingReader reader;
+        Expect(reader.Open(DAMAGED_PATH, error) && !reader.Recovered() && reader.Count() == FRAMES,
+               "indexed damaged recording");
+        uint8_t frame[BITMAP_SIZE];
+        Expect(reader.Read(k - 1, frame) && memcmp(frame, frames[k - 1].data(), BITMAP_SIZE) == 0, "frame before damage");
+        Expect(!reader.Read(k, frame) && !reader.Read(k + RECORDING_KEYFRAME_INTERVAL - 1, frame), "damaged frames");
+        Expect(reader.Read(k + RECORDING_KEYFRAME_INTERVAL, frame) &&
+               memcmp(frame, frames[k + RECORDING_KEYFRAME_INTERVAL].data(), BITMAP_SIZE) == 0, "next keyframe");
+    }
+
+    // An index chunk whose size is damaged sends the reader to a scan, which stops there
+    {
+        std::vector<uint8_t> damaged = file;
+        RecordingTrailer trailer;
+        memcpy(&trailer, &damaged[body], sizeof(trailer));
+        SetChunkSize(damaged, trailer.index_offset, 60000);
+        WriteFile(DAMAGED_PATH, damaged, damaged.size());
+        ExpectFrames(DAMAGED_PATH, frames, times, FRAMES, true, "damaged index chunk");
+    }
+
+    // Nothing recorded
+    {
+        RecordingWriter writer;
+        Expect(writer.Open(DAMAGED_PATH, start, "", error) && writer.Close(), "empty recording");
+        ExpectFrames(DAMAGED_PATH, frames, times, 0, false, "empty recording");
+    }
+
+    remove(PATH);
+    remove(DAMAGED_PATH);
+    if (g_failures) {
+        printf("%d failures\n", g_failures);
+        return 1;
+    }
+    printf("Recordings round-trip and recover: %u frames, %zu bytes\n", FRAMES, file.size());
+    return 0;
+}
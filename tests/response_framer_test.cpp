@@ -0,0 +1,225 @@
+// RadShot - Response framer test
+// Feeds ResponseFramer byte streams with explicit timestamps, the way a capture session
+// does: stale bytes before a request, frames split across reads, short responses cut off
+// at the inter-byte deadline, over-long tails in the same read and late ones inside the
+// tail gap, and the quiet period a drained response must leave before the next request.
+//
+// Portable (no Win32 dependencies). Built by tests/CMakeLists.txt.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "baud_probe.h"
+#include "capture_worker.h"
+#include "response_framer.h"
+
+using Clock = ResponseFramer::Clock;
+
+constexpr uint32_t BAUD = 115200;
+constexpr uint32_t FTDI_LATENCY_MS = 16;   // Default latency timer: the longest a bridge holds bytes back
+
+static int g_failures = 0;
+
+static void Expect(bool ok, const std::string& what) {
+    if (ok) return;
+    if (g_failures < 20) printf("FAIL %s\n", what.c_str());
+    g_failures++;
+}
+
+static Clock::time_point At(uint32_t ms) {
+    return Clock::time_point() + std::chrono::hours(1) + std::chrono::milliseconds(ms);
+}
+
+static std::vector<uint8_t> MakeFrame(uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> frame(BITMAP_SIZE);
+    for (uint8_t& b : frame) b = (uint8_t)rng();
+    return frame;
+}
+
+// A framer configured as CaptureSession configures it at BAUD
+static void Configure(ResponseFramer& framer, CaptureTimeouts& timeouts) {
+    timeouts = CaptureTimeouts::ForBaud(BAUD);
+    framer.Configure(timeouts.tail_gap_ms, timeouts.inter_byte_ms);
+}
+
+// Feeds `size` bytes in `piece`-byte reads at `ms`. Returns how many of the reads completed a frame.
+static int FeedPieces(ResponseFramer& framer, const uint8_t* data, size_t size, size_t piece, uint32_t ms) {
+    int frames = 0;
+    for (size_t at = 0; at < size; at += piece) {
+        if (framer.Feed(data + at, (std::min)(piece, size - at), At(ms))) frames++;
+    }
+    return frames;
+}
+
+static bool SameFrame(const ResponseFramer& framer, const std::vector<uint8_t>& frame) {
+    return memcmp(framer.Frame(), frame.data(), BITMAP_SIZE) == 0;
+}
+
+static void TestStaleBytes() {
+    ResponseFramer framer;
+    CaptureTimeouts timeouts;
+    Configure(framer, timeouts);
+
+    // Leftovers with no request open never reach a frame
+    std::vector<uint8_t> junk(300, 0xAA), frame = MakeFrame(1);
+    Expect(!framer.Feed(junk.data(), junk.size(), At(0)), "stale: no frame from stale bytes");
+    Expect(framer.State() == FramerState::Idle && framer.Received() == 0, "stale: still idle");
+    Expect(framer.Stats().stale_bytes == junk.size(), "stale: counted");
+
+    Expect(framer.CanOpen(At(1)), "stale: stale bytes don't hold back a request");
+    framer.Open();
+    Expect(framer.State() == FramerState::Awaiting, "stale: awaiting after open");
+    Expect(FeedPieces(framer, frame.data(), frame.size(), 62, 10) == 1, "stale: frame completes once");
+    Expect(SameFrame(framer, frame), "stale: frame holds only the response");
+    Expect(framer.Stats().frames == 1 && framer.Stats().discarded_bytes == 0, "stale: stats");
+}
+
+static void TestExactFrame() {
+    ResponseFramer framer;
+    CaptureTimeouts timeouts;
+    Configure(framer, timeouts);
+    std::vector<uint8_t> frame = MakeFrame(2);
+
+    Expect(framer.CanOpen(At(0)), "exact: can open");
+    framer.Open();
+    Expect(FeedPieces(framer, frame.data(), frame.size(), 1, 5) == 1, "exact: frame from single-byte reads");
+    Expect(SameFrame(framer, frame), "exact: content");
+
+    // The tail gap has to pass before the next request, and nothing turns up in it
+    Expect(framer.State() == FramerState::Trailing, "exact: trailing after frame");
+    Expect(framer.NextDeadline() == At(5 + timeouts.tail_gap_ms), "exact: tail deadline");
+    Expect(!framer.CanOpen(At(5 + timeouts.tail_gap_ms - 1)), "exact: held back within the tail gap");
+    Expect(framer.CanOpen(At(5 + timeouts.tail_gap_ms)), "exact: free after the tail gap");
+    Expect(framer.TakeOverlong() == 0 && framer.Stats().overlong_responses == 0, "exact: no tail");
+    Expect(framer.NextDeadline() == Clock::time_point::max(), "exact: nothing due when idle");
+}
+
+static void TestOverlong() {
+    ResponseFramer framer;
+    CaptureTimeouts timeouts;
+    Configure(framer, timeouts);
+    std::vector<uint8_t> frame = MakeFrame(3), first = MakeFrame(4);
+
+    // Ten bytes too many in the read that completes the frame...
+    std::vector<uint8_t> response(frame);
+    response.insert(response.end(), 10, 0xEE);
+    framer.CanOpen(At(0));
+    framer.Open();
+    Expect(FeedPieces(framer, response.data(), response.size(), 257, 10) == 1, "overlong: frame found");
+    Expect(SameFrame(framer, frame), "overlong: frame excludes the tail");
+
+    // ...and six more held back by the bridge's latency timer: still this frame's tail
+    const uint8_t late[6] = {};
+    framer.Tick(At(10 + FTDI_LATENCY_MS));
+    Expect(framer.State() == FramerState::Trailing, "overlong: tail window outlasts the latency timer");
+    Expect(!framer.Feed(late, sizeof(late), At(10 + FTDI_LATENCY_MS)), "overlong: late tail isn't a frame");
+    Expect(framer.Stats().stale_bytes == 0, "overlong: late tail not taken as stale");
+    Expect(framer.TakeOverlong() == 0, "overlong: not reported while the window is open");
+
+    // Reported once, when the window closes
+    uint32_t closes = 10 + FTDI_LATENCY_MS + timeouts.tail_gap_ms;
+    Expect(framer.NextDeadline() == At(closes), "overlong: window extends from the last tail byte");
+    Expect(framer.CanOpen(At(closes)), "overlong: free once the line is quiet");
+    Expect(framer.TakeOverlong() == 16, "overlong: whole tail reported");
+    Expect(framer.TakeOverlong() == 0, "overlong: reported once");
+    Expect(framer.Stats().overlong_responses == 1 && framer.Stats().discarded_bytes == 16, "overlong: stats");
+
+    // The next response starts clean
+    framer.Open();
+    Expect(FeedPieces(framer, first.data(), first.size(), 64, closes + 50) == 1 && SameFrame(framer, first),
+           "overlong: next frame unaffected");
+}
+
+// A response that stops short: the session aborts it at the inter-byte deadline, and what
+// the radio sends after that is drained rather than taken as the next response
+static void TestShortResponse() {
+    ResponseFramer framer;
+    CaptureTimeouts timeouts;
+    Configure(framer, timeouts);
+    std::vector<uint8_t> frame = MakeFrame(5), next = MakeFrame(6);
+
+    framer.CanOpen(At(0));
+    framer.Open();
+    Expect(FeedPieces(framer, frame.data(), 400, 100, 20) == 0, "short: no frame");
+    Expect(framer.State() == FramerState::Receiving && framer.Received() == 400, "short: receiving");
+    Expect(framer.LastByteAt() == At(20), "short: last byte time");
+
+    // The session's inter-byte deadline runs from the last byte
+    uint32_t stalled = 20 + timeouts.inter_byte_ms;
+    Expect(framer.Abort(At(stalled)) == 400, "short: abort returns bytes received");
+    Expect(framer.Stats().short_responses == 1, "short: counted");
+    Expect(framer.State() == FramerState::Draining && framer.Received() == 0, "short: draining");
+
+    // The rest of the response arrives late, in two pieces; each restarts the quiet period
+    Expect(!framer.Feed(frame.data() + 400, 300, At(stalled + 40)), "short: late bytes drained");
+    Expect(!framer.Feed(frame.data() + 700, BITMAP_SIZE - 700, At(stalled + 80)), "short: late bytes drained");
+    Expect(framer.Stats().discarded_bytes == (uint64_t)(BITMAP_SIZE - 400) && framer.Stats().frames == 0, "short: drained bytes counted");
+    uint32_t quiet = stalled + 80 + timeouts.inter_byte_ms;
+    Expect(framer.NextDeadline() == At(quiet), "short: quiet deadline from the last byte");
+    Expect(!framer.CanOpen(At(quiet - 1)), "short: held back until quiet");
+    Expect(framer.CanOpen(At(quiet)), "short: free once quiet");
+    Expect(framer.TakeOverlong() == 0, "short: a drained response isn't over-long");
+
+    framer.Open();
+    Expect(FeedPieces(framer, next.data(), next.size(), 128, quiet + 10) == 1 && SameFrame(framer, next),
+           "short: next frame unaffected");
+}
+
+// Aborted before any byte arrived: not a short response, and the quiet period still applies
+static void TestNoResponse() {
+    ResponseFramer framer;
+    CaptureTimeouts timeouts;
+    Configure(framer, timeouts);
+
+    framer.CanOpen(At(0));
+    framer.Open();
+    Expect(framer.Abort(At(timeouts.first_byte_ms)) == 0, "no response: nothing received");
+    Expect(framer.Stats().short_responses == 0, "no response: not a short response");
+    Expect(!framer.CanOpen(At(timeouts.first_byte_ms + 1)), "no response: quiet period");
+    Expect(framer.CanOpen(At(timeouts.first_byte_ms + timeouts.inter_byte_ms)), "no response: free after it");
+}
+
+static void TestReset() {
+    ResponseFramer framer;
+    CaptureTimeouts timeouts;
+    Configure(framer, timeouts);
+    std::vector<uint8_t> frame = MakeFrame(7);
+
+    framer.CanOpen(At(0));
+    framer.Open();
+    framer.Feed(frame.data(), 100, At(1));
+    framer.Reset();
+    Expect(framer.State() == FramerState::Idle && framer.Received() == 0, "reset: idle");
+    Expect(framer.CanOpen(At(2)), "reset: can open at once");
+    framer.Open();
+    Expect(framer.Feed(frame.data(), frame.size(), At(3)) && SameFrame(framer, frame), "reset: frame from the start");
+}
+
+int main() {
+    // The tail gap must outlast the latency timer at every rate the app offers
+    for (uint32_t baud : BAUD_RATES) {
+        Expect(CaptureTimeouts::ForBaud(baud).tail_gap_ms > FTDI_LATENCY_MS,
+               "tail gap above the latency timer at " + std::to_string(baud));
+    }
+
+    TestStaleBytes();
+    TestExactFrame();
+    TestOverlong();
+    TestShortResponse();
+    TestNoResponse();
+    TestReset();
+
+    if (g_failures) {
+        printf("%d failures\n", g_failures);
+        return 1;
+    }
+    printf("Response framer: stale bytes, frames, tails, short responses and quiet periods OK\n");
+    return 0;
+}
@@ -0,0 +1,255 @@
+// RadShot - Screenshot store test
+// Exercises ScreenshotStore the way the gallery does: adds and removes in any order, then
+// checks that handles to removed screenshots go stale even once their slot and frame are
+// reused, that gallery order survives removals, that pooled frames are recycled before the
+// pool grows, that every name reads back exactly as given, whether it was split into a
+// shared prefix and a number or kept whole, and that the memory figures the gallery shows
+// add up.
+//
+// Portable (no Win32 dependencies). Built by tests/CMakeLists.txt.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "screenshot_store.h"
+
+static int g_failures = 0;
+
+static void Expect(bool ok, const std::string& what) {
+    if (ok) return;
+    if (g_failures < 20) printf("FAIL %s\n", what.c_str());
+    g_failures++;
+}
+
+static std::vector<uint8_t> MakeFrame(int id) {
+    std::vector<uint8_t> frame(BITMAP_SIZE);
+    for (int i = 0; i < BITMAP_SIZE; i++) frame[i] = (uint8_t)(id * 13 + i);
+    return frame;
+}
+
+static ScreenshotHandle AddNumbered(ScreenshotStore& store, int id) {
+    char name[32];
+    snprintf(name, sizeof(name), "screenshot_%03d", id);
+    ArchiveTime time = {};
+    time.year = 2026;
+    time.second = (uint16_t)(id % 60);
+    return store.Add(id, name, "COM3", time, (uint64_t)id * 7, 1, MakeFrame(id).data());
+}
+
+static std::string NameOf(const ScreenshotStore& store, ScreenshotHandle h) {
+    char name[300];
+    store.Name(h, name, sizeof(name));
+    return name;
+}
+
+static void TestHandles() {
+    ScreenshotStore store;
+    ScreenshotHandle first = AddNumbered(store, 1);
+    Expect(store.Valid(first) && store.Id(first) == 1, "handles: valid once added");
+
+    // The slot is reused by the next add; the old handle stays stale
+    store.RemoveAt(0);
+    Expect(!store.Valid(first), "handles: stale once removed");
+    ScreenshotHandle second = AddNumbered(store, 2);
+    Expect(second.slot == first.slot, "handles: freed slot reused");
+    Expect(!(second == first) && store.Valid(second) && !store.Valid(first), "handles: reuse doesn't revive the old handle");
+    Expect(store.Id(second) == 2 && store.ArchiveIndex(second) == -1 && store.TexturePreview(second) == 0 &&
+           store.ThumbCell(second) == 0, "handles: reused slot starts clean");
+
+    // Through many cycles of one slot, every earlier handle stays stale
+    std::vector<ScreenshotHandle> old = { first, second };
+    for (int i = 0; i < 1000; i++) {
+        store.RemoveAt(0);
+        old.push_back(AddNumbered(store, 3 + i));
+    }
+    int live = 0;
+    for (const ScreenshotHandle& h : old) live += store.Valid(h) ? 1 : 0;
+    Expect(live == 1 && store.Valid(old.back()), "handles: only the latest handle of a reused slot is valid");
+
+    // Clear keeps the slots but not the handles
+    ScreenshotHandle beforeClear = old.back();
+    store.Clear();
+    Expect(store.Empty() && !store.Valid(beforeClear), "handles: stale after Clear");
+    ScreenshotHandle afterClear = AddNumbered(store, 5000);
+    Expect(afterClear.slot == beforeClear.slot && store.Valid(afterClear) && !store.Valid(beforeClear),
+           "handles: slot reused after Clear, old handle still stale");
+
+    // A handle from beyond the store, or the null handle, is never valid
+    Expect(!store.Valid(ScreenshotHandle()), "handles: null handle invalid");
+    Expect(!store.Valid(ScreenshotHandle{ 99, 0 }), "handles: unknown slot invalid");
+}
+
+static void TestOrder() {
+    ScreenshotStore store;
+    std::vector<ScreenshotHandle> handles;
+    for (int id = 0; id < 10; id++) handles.push_back(AddNumbered(store, id));
+
+    // Remove from the middle, the front and the back; the rest keep their order
+    store.RemoveAt(4);
+    store.RemoveAt(0);
+    store.RemoveAt(store.Count() - 1);
+    const int expected[] = { 1, 2, 3, 5, 6, 7, 8 };
+    bool inOrder = store.Count() == 7;
+    for (size_t pos = 0; inOrder && pos < store.Count(); pos++) inOrder = store.Id(store.At(pos)) == expected[pos];
+    Expect(inOrder, "order: removals keep the rest in gallery order");
+    Expect(!store.Valid(handles[4]) && !store.Valid(handles[0]) && !store.Valid(handles[9]) && store.Valid(handles[5]),
+           "order: exactly the removed handles are stale");
+
+    // New screenshots go to the end even when they take an earlier slot
+    ScreenshotHandle added = AddNumbered(store, 42);
+    Expect(store.At(store.Count() - 1) == added && added.slot < 10, "order: reused slot appended at the end");
+}
+
+static void TestFramePool() {
+    ScreenshotStore store;
+    std::vector<ScreenshotHandle> handles;
+    for (int id = 0; id < (int)STORE_FRAME_BLOCK; id++) handles.push_back(AddNumbered(store, id));
+    size_t oneBlock = STORE_FRAME_BLOCK * BITMAP_SIZE;
+    Expect(store.FramePoolBytes() == oneBlock && store.OwnedFrames() == STORE_FRAME_BLOCK, "pool: one block full");
+
+    // A removed screenshot's frame is reused before the pool grows
+    const uint8_t* freed = store.Frame(handles[10]);
+    store.RemoveAt(10);
+    ScreenshotHandle reused = AddNumbered(store, 1000);
+    Expect(store.Frame(reused) == freed && store.FramePoolBytes() == oneBlock, "pool: freed frame reused");
+    Expect(memcmp(store.Frame(reused), MakeFrame(1000).data(), BITMAP_SIZE) == 0, "pool: reused frame holds the new capture");
+    Expect(store.OwnedFrames() == STORE_FRAME_BLOCK, "pool: frames in use counted");
+
+    // Then it grows by a block, and earlier frames don't move
+    ScreenshotHandle grown = AddNumbered(store, 1001);
+    Expect(store.FramePoolBytes() == 2 * oneBlock && store.OwnedFrames() == STORE_FRAME_BLOCK + 1, "pool: grows by a block");
+    bool intact = true;
+    for (size_t pos = 0; pos < store.Count(); pos++) {
+        ScreenshotHandle h = store.At(pos);
+        intact = intact && memcmp(store.Frame(h), MakeFrame(store.Id(h)).data(), BITMAP_SIZE) == 0;
+    }
+    Expect(intact && store.OwnsFrame(grown), "pool: every frame intact after growth");
+
+    store.Clear();
+    Expect(store.FramePoolBytes() == 0 && store.OwnedFrames() == 0, "pool: freed by Clear");
+}
+
+// An archived screenshot reads its fields from the record until renamed, and takes no frame
+static void TestArchived() {
+    ArchiveRecord record = {};
+    record.magic = ARCHIVE_RECORD_MAGIC;
+    record.id = 77;
+    record.hash = 0x1234;
+    record.timestamp.year = 2025;
+    strncpy(record.port, "COM9", sizeof(record.port) - 1);
+    strncpy(record.name, "field_day_0042", sizeof(record.name) - 1);
+    std::vector<uint8_t> frame = MakeFrame(77);
+    memcpy(record.frame, frame.data(), BITMAP_SIZE);
+
+    ScreenshotStore store;
+    ScreenshotHandle h = store.AddArchived(77, &record, 3);
+    Expect(store.Frame(h) == record.frame && !store.OwnsFrame(h) && store.OwnedFrames() == 0, "archived: frame in the record");
+    Expect(NameOf(store, h) == "field_day_0042" && strcmp(store.Port(h), "COM9") == 0 && store.Hash(h) == 0x1234 &&
+           store.Time(h).year == 2025 && store.RepeatCount(h) == 3, "archived: fields read from the record");
+    Expect(store.InternedStrings() == 0, "archived: nothing interned");
+
+    uint32_t revision = store.Revision(h);
+    store.SetName(h, "renamed_005");
+    Expect(NameOf(store, h) == "renamed_005" && store.Revision(h) != revision, "archived: rename");
+
+    // A name the crash left unterminated is cut at the field's end
+    memset(record.name, 'a', sizeof(record.name));
+    ScreenshotHandle torn = store.AddArchived(78, &record, 1);
+    Expect(NameOf(store, torn) == std::string(sizeof(record.name) - 1, 'a'), "archived: torn name bounded");
+
+    store.RemoveAt(0);
+    store.RemoveAt(0);
+    Expect(store.InternedStrings() == 0, "archived: interned name released");
+}
+
+// Every name prints back exactly; default "<prefix>_<number>" names share their prefix
+static void TestNames() {
+    const char* names[] = {
+        "x_000", "x_001", "x_0123", "x_1234", "x_12", "x_", "_123", "x123", "x_123456789",
+        "x_1234567890", "x_000123", "x__000", "a_b_007", "screenshot_999", "screenshot_1000",
+        "", "0_000", "x_-12", "x_12a",
+    };
+    ScreenshotStore store;
+    std::vector<ScreenshotHandle> handles;
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        ArchiveTime time = {};
+        handles.push_back(store.Add((int)i, names[i], "COM3", time, 0, 1, MakeFrame((int)i).data()));
+    }
+    for (size_t i = 0; i < handles.size(); i++) {
+        Expect(NameOf(store, handles[i]) == names[i], std::string("names: \"") + names[i] + "\" reads back as \"" +
+               NameOf(store, handles[i]) + "\"");
+    }
+
+    // Renaming round-trips too, and survives slot reuse
+    store.SetName(handles[0], "x_0001");
+    Expect(NameOf(store, handles[0]) == "x_0001", "names: rename to a zero-padded number");
+    store.RemoveAt(0);
+    ArchiveTime time = {};
+    ScreenshotHandle reused = store.Add(100, "y_0123", "COM4", time, 0, 1, MakeFrame(100).data());
+    Expect(NameOf(store, reused) == "y_0123" && strcmp(store.Port(reused), "COM4") == 0, "names: reused slot");
+
+    // Numbered names share one prefix string
+    ScreenshotStore numbered;
+    for (int id = 1; id <= 500; id++) AddNumbered(numbered, id);
+    Expect(numbered.InternedStrings() == 2, "names: 500 default names intern one prefix and one port");
+    Expect(NameOf(numbered, numbered.At(0)) == "screenshot_001" && NameOf(numbered, numbered.At(499)) == "screenshot_500",
+           "names: numbered names read back");
+    while (!numbered.Empty()) numbered.RemoveAt(numbered.Count() - 1);
+    Expect(numbered.InternedStrings() == 0, "names: strings released with the last user");
+}
+
+// The numbers the gallery header shows: a 2,000-capture session holds its raw frames and
+// a little metadata each, nowhere near the 545 KB of RGBA a screenshot used to keep
+static void TestMemory() {
+    ScreenshotStore store;
+    Expect(store.MetadataBytes() == 0 && store.FramePoolBytes() == 0, "memory: empty store");
+    AddNumbered(store, 0);
+    const size_t perScreenshot = store.MetadataBytes();
+    Expect(perScreenshot > 0 && perScreenshot <= 128, "memory: metadata per screenshot is " + std::to_string(perScreenshot));
+
+    const size_t captures = 2000;
+    for (int id = 1; id < (int)captures; id++) AddNumbered(store, id);
+    size_t blocks = (captures + STORE_FRAME_BLOCK - 1) / STORE_FRAME_BLOCK;
+    Expect(store.FramePoolBytes() == blocks * STORE_FRAME_BLOCK * BITMAP_SIZE, "memory: frame pool holds raw frames only");
+    Expect(store.MetadataBytes() == captures * perScreenshot, "memory: metadata grows per screenshot");
+    Expect(store.MetadataBytes() + store.FramePoolBytes() < captures * 2 * BITMAP_SIZE, "memory: under 2 KB per screenshot");
+
+    // Removal gives back the order entry; the slot is kept for reuse
+    const size_t slotBytes = perScreenshot - sizeof(uint32_t);
+    for (int i = 0; i < 1000; i++) store.RemoveAt(0);
+    Expect(store.MetadataBytes() == captures * slotBytes + 1000 * sizeof(uint32_t), "memory: removal frees the order entry");
+    Expect(store.FramePoolBytes() == blocks * STORE_FRAME_BLOCK * BITMAP_SIZE && store.OwnedFrames() == 1000,
+           "memory: freed frames stay pooled");
+    for (int id = 0; id < 1000; id++) AddNumbered(store, 3000 + id);
+    Expect(store.MetadataBytes() == captures * perScreenshot && store.FramePoolBytes() == blocks * STORE_FRAME_BLOCK * BITMAP_SIZE,
+           "memory: refilled without growing");
+
+    // Archived screenshots take a slot but no pooled frame
+    std::vector<ArchiveRecord> records(100);
+    for (size_t i = 0; i < records.size(); i++) store.AddArchived((int)(5000 + i), &records[i], 1);
+    Expect(store.FramePoolBytes() == blocks * STORE_FRAME_BLOCK * BITMAP_SIZE, "memory: archived screenshots take no frames");
+    Expect(store.MetadataBytes() == (captures + records.size()) * perScreenshot, "memory: archived metadata");
+
+    store.Clear();
+    Expect(store.FramePoolBytes() == 0 && store.MetadataBytes() == (captures + records.size()) * slotBytes,
+           "memory: Clear frees the pool and keeps the slots");
+}
+
+int main() {
+    TestHandles();
+    TestOrder();
+    TestFramePool();
+    TestArchived();
+    TestNames();
+    TestMemory();
+
+    if (g_failures) {
+        printf("%d failures\n", g_failures);
+        return 1;
+    }
+    printf("Screenshot store: handles, order, frame pool, names and memory use OK\n");
+    return 0;
+}
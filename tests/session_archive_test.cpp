@@ -0,0 +1,301 @@
+// RadShot - Session archive recovery test
+// Writes a session archive, then edits the files the way a crash or a stray copy leaves
+// them and reopens: records written past the commit count are replayed, a torn or
+// corrupt tail is cut off, and an index file that is missing, short, stale, from another
+// archive or out of line with the records is only trusted as far as it matches, then
+// rewritten. A file that isn't an archive is refused and left as it was.
+//
+// Portable (no Win32 dependencies). Built by tests/CMakeLists.txt.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "session_archive.h"
+
+constexpr uint32_t RECORDS = 300;
+constexpr const char* PATH = "session_archive_test.session";
+constexpr const char* OTHER_PATH = "session_archive_test_other.session";
+
+static int g_failures = 0;
+
+static void Expect(bool ok, const std::string& what) {
+    if (ok) return;
+    if (g_failures < 20) printf("FAIL %s\n", what.c_str());
+    g_failures++;
+}
+
+static std::string IndexPath(const char* path) {
+    return std::string(path) + ARCHIVE_INDEX_SUFFIX;
+}
+
+static void RemoveArchive(const char* path) {
+    remove(path);
+    remove(IndexPath(path).c_str());
+}
+
+// Record i's frame and id, so any record read back can be checked on its own
+static void MakeFrame(uint32_t i, uint8_t* frame) {
+    for (int b = 0; b < BITMAP_SIZE; b++) frame[b] = (uint8_t)(i * 31 + b * 7);
+}
+
+static uint32_t IdOf(uint32_t i) {
+    return 1000 + i;
+}
+
+// Appends records [first, last) and closes, which commits them
+static void Append(const char* path, uint32_t first, uint32_t last) {
+    SessionArchive archive;
+    std::string error;
+    Expect(archive.Open(path, error), "open for append: " + error);
+    uint8_t frame[BITMAP_SIZE];
+    ArchiveTime timestamp = {};
+    timestamp.year = 2026;
+    for (uint32_t i = first; i < last; i++) {
+        MakeFrame(i, frame);
+        char name[32];
+        snprintf(name, sizeof(name), "screenshot_%03u", i);
+        archive.Append(IdOf(i), timestamp, "COM3", name, HashFrame(frame), 1, frame);
+    }
+    archive.Close();
+}
+
+static ArchiveHeader ReadHeader(const char* path) {
+    ArchiveHeader header = {};
+    ArchiveFile file;
+    if (file.Open(path, true)) file.ReadAt(0, &header, sizeof(header));
+    return header;
+}
+
+static void WriteAt(const std::string& path, uint64_t offset, const void* data, size_t size) {
+    ArchiveFile file;
+    Expect(file.Open(path.c_str()) && file.WriteAt(offset, data, size), "patch " + path);
+}
+
+static void SetCommitted(const char* path, uint64_t committed) {
+    ArchiveHeader header = ReadHeader(path);
+    header.committed = committed;
+    WriteAt(path, 0, &header, sizeof(header));
+}
+
+static void TruncateFile(const std::string& path, uint64_t size) {
+    ArchiveFile file;
+    Expect(file.Open(path.c_str()) && file.Truncate(size), "truncate " + path);
+}
+
+static uint64_t FileSize(const std::string& path) {
+    ArchiveFile file;
+    return file.Open(path.c_str(), true) ? file.Size() : 0;
+}
+
+static void CopyFile(const std::string& from, const std::string& to) {
+    std::vector<uint8_t> data((size_t)FileSize(from));
+    ArchiveFile in;
+    Expect(in.Open(from.c_str(), true) && in.ReadAt(0, data.data(), data.size()), "read " + from);
+    remove(to.c_str());
+    WriteAt(to, 0, data.data(), data.size());
+}
+
+// Opens the archive and checks it holds records [0, count) intact, with index entries
+// that match them. Returns the open stats.
+static ArchiveStats Verify(const char* path, uint32_t count, const std::string& what) {
+    SessionArchive archive;
+    std::string error;
+    if (!archive.Open(path, error)) {
+        Expect(false, what + ": open failed: " + error);
+        return ArchiveStats();
+    }
+    Expect(archive.MappedCount() == count, what + ": " + std::to_string(archive.MappedCount()) + " records, expected " +
+           std::to_string(count));
+    uint8_t frame[BITMAP_SIZE];
+    bool records = true, entries = true;
+    for (uint32_t i = 0; i < count && i < archive.MappedCount(); i++) {
+        const ArchiveRecord& record = archive.Mapped(i);
+        MakeFrame(i, frame);
+        if (record.id != IdOf(i) || memcmp(record.frame, frame, BITMAP_SIZE) != 0 ||
+            record.checksum != ArchiveRecordChecksum(record)) {
+            records = false;
+        }
+        const ArchiveIndexEntry& entry = archive.MappedEntry(i);
+        if (entry.id != record.id || entry.flags != record.flags || entry.repeat_count != record.repeat_count) {
+            entries = false;
+        }
+    }
+    Expect(records, what + ": records intact");
+    Expect(entries, what + ": index entries match the records");
+    ArchiveStats stats = archive.Stats();
+    archive.Close();
+
+    // Whatever was repaired was written back: the next open has nothing left to fix or scan
+    ArchiveHeader header = ReadHeader(path);
+    Expect(header.committed == count && FileSize(path) == ArchiveRecordOffset(count), what + ": archive repaired");
+    Expect(FileSize(IndexPath(path)) == ArchiveIndexOffset(count), what + ": index rewritten");
+    SessionArchive again;
+    if (again.Open(path, error)) {
+        ArchiveStats next = again.Stats();
+        Expect(next.recovered == 0 && next.discarded == 0 && next.scanned == 0, what + ": clean on the next open");
+    }
+    return stats;
+}
+
+// Records written and flushed but not yet counted: a crash between the two flushes
+static void TestReplay() {
+    RemoveArchive(PATH);
+    Append(PATH, 0, RECORDS);
+    SetCommitted(PATH, RECORDS - 20);
+    ArchiveStats stats = Verify(PATH, RECORDS, "replay");
+    Expect(stats.recovered == 20 && stats.discarded == 0, "replay: uncounted records replayed");
+    Expect(stats.scanned == 0, "replay: index already covered them");
+
+    // A committed count beyond the end of the file is clipped to what is there
+    SetCommitted(PATH, RECORDS + 50);
+    stats = Verify(PATH, RECORDS, "count past the end");
+    Expect(stats.recovered == 0 && stats.discarded == 0, "count past the end: nothing replayed or cut");
+}
+
+static void TestTornTail() {
+    // Half a record behind the committed ones
+    RemoveArchive(PATH);
+    Append(PATH, 0, RECORDS);
+    TruncateFile(PATH, ArchiveRecordOffset(RECORDS) + sizeof(ArchiveRecord) / 2);
+    ArchiveStats stats = Verify(PATH, RECORDS, "torn tail");
+    Expect(stats.recovered == 0, "torn tail: nothing replayed");
+
+    // Uncounted records whose middle one didn't make it to disk whole: the ones before it
+    // are replayed, it and everything after are cut
+    SetCommitted(PATH, RECORDS - 20);
+    uint8_t garbage[64];
+    memset(garbage, 0x5A, sizeof(garbage));
+    WriteAt(PATH, ArchiveRecordOffset(RECORDS - 10) + offsetof(ArchiveRecord, frame) + 100, garbage, sizeof(garbage));
+    stats = Verify(PATH, RECORDS - 10, "corrupt uncounted record");
+    Expect(stats.recovered == 10 && stats.discarded == 10, "corrupt uncounted record: replay stops at it");
+    Expect(stats.scanned == 0, "corrupt uncounted record: index cut to match");
+
+    // A record-sized block of zeros (a file extended but never written)
+    std::vector<uint8_t> zeros(sizeof(ArchiveRecord) * 3, 0);
+    WriteAt(PATH, ArchiveRecordOffset(RECORDS - 10), zeros.data(), zeros.size());
+    stats = Verify(PATH, RECORDS - 10, "zeroed tail");
+    Expect(stats.discarded == 3 && stats.recovered == 0, "zeroed tail: cut off");
+
+    // Committed records are trusted as they are; a new session appends after them
+    Append(PATH, RECORDS - 10, RECORDS);
+    Verify(PATH, RECORDS, "append after recovery");
+}
+
+static void TestIndex() {
+    RemoveArchive(PATH);
+    Append(PATH, 0, RECORDS);
+    std::string index = IndexPath(PATH);
+
+    // Updates reach both files
+    {
+        SessionArchive archive;
+        std::string error;
+        archive.Open(PATH, error);
+        archive.SetRepeatCount(10, 42);
+        archive.MarkDeleted(3);
+        archive.Close();
+    }
+    ArchiveStats stats = Verify(PATH, RECORDS, "updates");
+    Expect(stats.scanned == 0, "updates: index used");
+
+    // Missing
+    remove(index.c_str());
+    stats = Verify(PATH, RECORDS, "missing index");
+    Expect(stats.scanned == RECORDS, "missing index: every record scanned");
+    {
+        SessionArchive archive;
+        std::string error;
+        archive.Open(PATH, error);
+        Expect(archive.MappedEntry(10).repeat_count == 42 && archive.MappedEntry(3).flags == ARCHIVE_FLAG_DELETED,
+               "missing index: updates rebuilt from the records");
+    }
+
+    // Short: the header covers fewer entries than there are records (crash before the
+    // index header was rewritten)
+    ArchiveIndexHeader header;
+    {
+        ArchiveFile file;
+        file.Open(index.c_str(), true);
+        file.ReadAt(0, &header, sizeof(header));
+    }
+    header.covered = RECORDS - 50;
+    WriteAt(index, 0, &header, sizeof(header));
+    stats = Verify(PATH, RECORDS, "short index");
+    Expect(stats.scanned == 50, "short index: only the uncovered tail scanned");
+
+    // Covers more entries than the file holds
+    header.covered = RECORDS;
+    TruncateFile(index, ArchiveIndexOffset(RECORDS - 30));
+    WriteAt(index, 0, &header, sizeof(header));
+    stats = Verify(PATH, RECORDS, "truncated index");
+    Expect(stats.scanned == 30, "truncated index: entries past the end scanned");
+
+    // Out of line with the records
+    uint32_t wrongId = 7;
+    WriteAt(index, ArchiveIndexOffset(RECORDS - 1) + offsetof(ArchiveIndexEntry, id), &wrongId, sizeof(wrongId));
+    stats = Verify(PATH, RECORDS, "misaligned index");
+    Expect(stats.scanned == RECORDS, "misaligned index: not trusted");
+
+    // Another archive's index, with the same record count and ids
+    RemoveArchive(OTHER_PATH);
+    Append(OTHER_PATH, 0, RECORDS);
+    CopyFile(IndexPath(OTHER_PATH), index);
+    stats = Verify(PATH, RECORDS, "other archive's index");
+    Expect(stats.scanned == RECORDS, "other archive's index: not trusted");
+    Expect(ReadHeader(PATH).instance != ReadHeader(OTHER_PATH).instance, "archives have their own instance");
+
+    // An archive from before the index (instance 0) gets one, so no old index matches it
+    ArchiveHeader archiveHeader = ReadHeader(PATH);
+    archiveHeader.instance = 0;
+    WriteAt(PATH, 0, &archiveHeader, sizeof(archiveHeader));
+    stats = Verify(PATH, RECORDS, "pre-index archive");
+    Expect(stats.scanned == RECORDS && ReadHeader(PATH).instance != 0, "pre-index archive: instance assigned");
+
+    // Wrong magic or version
+    char junk[8] = { 'n', 'o', 't', 'i', 'n', 'd', 'e', 'x' };
+    WriteAt(index, 0, junk, sizeof(junk));
+    stats = Verify(PATH, RECORDS, "damaged index header");
+    Expect(stats.scanned == RECORDS, "damaged index header: not trusted");
+    RemoveArchive(OTHER_PATH);
+}
+
+// A file that isn't an archive is refused without being touched
+static void TestForeignFile() {
+    RemoveArchive(PATH);
+    const char text[] = "not a session archive, just some text that happens to sit at the path";
+    WriteAt(PATH, 0, text, sizeof(text));
+    SessionArchive archive;
+    std::string error;
+    Expect(!archive.Open(PATH, error) && !error.empty(), "foreign file: refused");
+    char back[sizeof(text)] = {};
+    ArchiveFile file;
+    Expect(FileSize(PATH) == sizeof(text) && file.Open(PATH, true) && file.ReadAt(0, back, sizeof(back)) &&
+           memcmp(back, text, sizeof(text)) == 0, "foreign file: untouched");
+
+    // Nor is an archive of another version
+    RemoveArchive(PATH);
+    Append(PATH, 0, 5);
+    ArchiveHeader header = ReadHeader(PATH);
+    header.version = ARCHIVE_VERSION + 1;
+    WriteAt(PATH, 0, &header, sizeof(header));
+    Expect(!archive.Open(PATH, error), "newer version: refused");
+    Expect(FileSize(PATH) == ArchiveRecordOffset(5), "newer version: untouched");
+}
+
+int main() {
+    TestReplay();
+    TestTornTail();
+    TestIndex();
+    TestForeignFile();
+    RemoveArchive(PATH);
+
+    if (g_failures) {
+        printf("%d failures\n", g_failures);
+        return 1;
+    }
+    printf("Session archive: replay, torn tails and index recovery OK\n");
+    return 0;
+}
@@ -0,0 +1,262 @@
+// RadShot - Simulator test
+// Starts tools/rt4d_sim on a pseudo-terminal and runs the capture path against it through
+// the platform serial transport: the capture worker takes a run of frames, each one
+// distinct and delivered whole; the link speed probe finds the one rate a simulator
+// under --strict-baud answers at; and the radio finder tells a live port from a silent
+// one and a missing one, also when the poller won't take a port's wait handle.
+//
+// POSIX only (ptys). The simulator's path is the first argument; tests/CMakeLists.txt
+// builds both and passes it.
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "baud_probe.h"
+#include "capture_worker.h"
+#include "radio_finder.h"
+#include "serial_transport.h"
+
+constexpr uint32_t EVENT_WAIT_MS = 3000;
+
+static int g_failures = 0;
+static const char* g_simulator = nullptr;
+
+static void Expect(bool ok, const std::string& what) {
+    if (ok) return;
+    if (g_failures < 20) printf("FAIL %s\n", what.c_str());
+    g_failures++;
+}
+
+// One rt4d_sim process, serving a pty linked at `link`
+class Simulator {
+public:
+    ~Simulator() { Stop(); }
+
+    // Starts the simulator with `args` and waits for its banner, which it prints once the
+    // link exists
+    bool Start(const std::string& link, const std::vector<std::string>& args) {
+        int out[2];
+        if (pipe(out) != 0) return false;
+        link_ = link;
+        pid_ = fork();
+        if (pid_ < 0) return false;
+        if (pid_ == 0) {
+            dup2(out[1], STDOUT_FILENO);
+            close(out[0]);
+            close(out[1]);
+            std::vector<std::string> all = { g_simulator, "--link", link };
+            all.insert(all.end(), args.begin(), args.end());
+            std::vector<char*> argv;
+            for (std::string& arg : all) argv.push_back(&arg[0]);
+            argv.push_back(nullptr);
+            execv(g_simulator, argv.data());
+            _exit(127);
+        }
+        close(out[1]);
+        pollfd pfd = { out[0], POLLIN, 0 };
+        char banner[256];
+        bool started = poll(&pfd, 1, 5000) > 0 && read(out[0], banner, sizeof(banner)) > 0;
+        close(out[0]);
+        return started;
+    }
+
+    void Stop() {
+        if (pid_ <= 0) return;
+        kill(pid_, SIGTERM);
+        int status;
+        waitpid(pid_, &status, 0);
+        pid_ = -1;
+    }
+
+    const char* Link() const { return link_.c_str(); }
+
+private:
+    pid_t pid_ = -1;
+    std::string link_;
+};
+
+static bool NextEvent(CaptureWorker& worker, CaptureEvent& ev) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(EVENT_WAIT_MS);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (worker.PollEvent(ev)) {
+            if (ev.type != CaptureEventType::Progress) return true;
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+// The worker captures from the pty through the transport and poller the app uses
+static void TestCapture() {
+    Simulator sim;
+    if (!sim.Start("simulator_test_capture.tty", { "--baud", "115200" })) {
+        Expect(false, "capture: simulator didn't start");
+        return;
+    }
+    std::unique_ptr<ISerialTransport> transport = CreatePlatformTransport();
+    if (!transport->Open(sim.Link(), 115200)) {
+        Expect(false, std::string("capture: open: ") + transport->LastError());
+        return;
+    }
+
+    CaptureWorker worker;
+    int session = worker.AddSession(std::move(transport), 115200);
+    std::vector<uint64_t> hashes;
+    CaptureEvent ev;
+    for (int i = 0; i < 3; i++) {
+        worker.RequestCapture(session);
+        bool got = NextEvent(worker, ev);
+        Expect(got && ev.type == CaptureEventType::Frame, "capture: frame " + std::to_string(i));
+        if (!got || ev.type != CaptureEventType::Frame) break;
+        Expect(ev.hash == HashFrame(ev.frame), "capture: hash");
+        for (uint64_t hash : hashes) Expect(hash != ev.hash, "capture: every frame distinct");
+        hashes.push_back(ev.hash);
+    }
+
+    // A counted burst over the real line
+    worker.RequestBurst(session, 5);
+    int frames = 0;
+    while (NextEvent(worker, ev) && ev.type == CaptureEventType::Frame) frames++;
+    Expect(frames == 5 && ev.type == CaptureEventType::BurstDone && ev.burst_failed == 0, "capture: burst of 5");
+    worker.Stop();
+}
+
+// A simulator that only answers at 57600, like a radio fixed at that rate. Every faster
+// rate stays silent; the prober settles on 57600 and stops there.
+static void TestBaudProbe() {
+    Simulator sim;
+    if (!sim.Start("simulator_test_baud.tty", { "--baud", "57600", "--strict-baud" })) {
+        Expect(false, "baud probe: simulator didn't start");
+        return;
+    }
+
+    std::unique_ptr<ISerialTransport> transport = CreatePlatformTransport();
+    PortPoller poller;
+    BaudProbeAttempt attempt = ProbeBaudRate(*transport, sim.Link(), 115200, poller);
+    Expect(attempt.outcome == ProbeOutcome::NoResponse && attempt.bytes == 0, "baud probe: silent at 115200");
+    attempt = ProbeBaudRate(*transport, sim.Link(), 57600, poller);
+    Expect(attempt.outcome == ProbeOutcome::Frame && attempt.bytes == BITMAP_SIZE, "baud probe: frame at 57600");
+    Expect(!transport->IsOpen(), "baud probe: port closed after probing");
+
+    BaudProber prober;
+    Expect(prober.Start(sim.Link()), "baud probe: started");
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!prober.IsDone() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    Expect(prober.Result() == 57600, "baud probe: picked " + std::to_string(prober.Result()));
+    const std::vector<BaudProbeAttempt>& attempts = prober.Attempts();
+    bool fasterSilent = !attempts.empty() && attempts.back().baud == 57600;
+    for (size_t i = 0; i + 1 < attempts.size(); i++) {
+        if (attempts[i].baud <= 57600 || attempts[i].outcome != ProbeOutcome::NoResponse) fasterSilent = false;
+    }
+    Expect(fasterSilent && attempts.size() == 5, "baud probe: faster rates tried first, and silent");
+}
+
+// Every port probed at once: a live radio, one at another rate, and one that isn't there.
+// Ranked in that order.
+static void TestFinder() {
+    Simulator live, silent;
+    if (!live.Start("simulator_test_live.tty", { "--baud", "115200", "--strict-baud" }) ||
+        !silent.Start("simulator_test_silent.tty", { "--baud", "57600", "--strict-baud" })) {
+        Expect(false, "finder: simulators didn't start");
+        return;
+    }
+    const char* missing = "simulator_test_missing.tty";
+    remove(missing);
+
+    std::vector<std::pair<std::string, uint32_t>> ports = {
+        { missing, 115200 }, { silent.Link(), 115200 }, { live.Link(), 115200 },
+    };
+    PortPoller poller;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<PortProbeResult> results = ProbePorts(ports, CreatePlatformTransport, poller);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    Expect(results.size() == 3, "finder: every port reported");
+    if (results.size() != 3) return;
+    Expect(results[0].port == live.Link() && results[0].outcome == ProbeOutcome::Frame &&
+           results[0].bytes == BITMAP_SIZE, "finder: live port answers with a frame");
+    Expect(results[0].latency_ms <= results[0].elapsed_ms, "finder: latency within the probe");
+    Expect(results[1].port == silent.Link() && results[1].outcome == ProbeOutcome::NoResponse &&
+           results[1].bytes == 0, "finder: port at another rate is silent");
+    Expect(results[1].elapsed_ms >= PROBE_FIRST_BYTE_MS, "finder: silent port given the first-byte wait");
+    Expect(results[2].port == missing && results[2].outcome == ProbeOutcome::OpenFailed,
+           "finder: missing port can't be opened");
+
+    // Probed side by side, not one after the other
+    Expect(elapsed.count() < 2 * PROBE_FIRST_BYTE_MS, "finder: ports probed concurrently");
+}
+
+// A pty whose wait handle the poller can't register: epoll refuses /dev/null, as it or
+// WaitForMultipleObjects can refuse a real handle. Bytes still arrive on the pty.
+class UnregisteredTransport : public PosixSerialTransport {
+public:
+    UnregisteredTransport() : null_(open("/dev/null", O_RDONLY | O_CLOEXEC)) {}
+    ~UnregisteredTransport() override {
+        if (null_ >= 0) close(null_);
+    }
+    WaitHandle GetWaitHandle() const override { return null_; }
+
+private:
+    int null_;
+};
+
+// The probe falls back to polling such a port and sees the frame as it lands, rather than
+// only when the first-byte deadline wakes it
+static void TestUnregisteredPort() {
+    Simulator sim;
+    if (!sim.Start("simulator_test_unregistered.tty", { "--baud", "115200" })) {
+        Expect(false, "unregistered: simulator didn't start");
+        return;
+    }
+    const uint32_t frameMs = CaptureTimeouts::WireTimeMs(115200, BITMAP_SIZE);
+
+    UnregisteredTransport transport;
+    PortPoller poller;
+    BaudProbeAttempt attempt = ProbeBaudRate(transport, sim.Link(), 115200, poller);
+    Expect(attempt.outcome == ProbeOutcome::Frame, "unregistered: baud probe gets the frame");
+    Expect(attempt.elapsed_ms < PROBE_FIRST_BYTE_MS, "unregistered: baud probe took " +
+           std::to_string(attempt.elapsed_ms) + " ms for a " + std::to_string(frameMs) + " ms frame");
+
+    std::vector<std::pair<std::string, uint32_t>> ports = { { sim.Link(), 115200 } };
+    std::vector<PortProbeResult> results = ProbePorts(ports, [] {
+        return std::unique_ptr<ISerialTransport>(new UnregisteredTransport());
+    }, poller);
+    Expect(results.size() == 1 && results[0].outcome == ProbeOutcome::Frame, "unregistered: finder gets the frame");
+    Expect(results.size() == 1 && results[0].latency_ms < frameMs, "unregistered: finder sees the first byte promptly");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s path/to/rt4d_sim\n", argv[0]);
+        return 2;
+    }
+    g_simulator = argv[1];
+    signal(SIGPIPE, SIG_IGN);
+
+    TestCapture();
+    TestBaudProbe();
+    TestFinder();
+    TestUnregisteredPort();
+
+    if (g_failures) {
+        printf("%d failures\n", g_failures);
+        return 1;
+    }
+    printf("Simulator: captures, link speed probing and port finding over a pty OK\n");
+    return 0;
+}
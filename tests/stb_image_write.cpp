@@ -0,0 +1,5 @@
+// stb_image_write's implementation, for png_writer.h's stbi_zlib_compress (radshot.cpp
+// compiles it into the application)
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
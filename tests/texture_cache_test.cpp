@@ -0,0 +1,241 @@
+// RadShot - Texture cache test
+// Drives TextureLru the way the gallery does, a frame at a time: touch what was drawn,
+// then evict while it names a victim, deleting and removing each one. Checks that the
+// resident byte count always equals the bytes of the textures still tracked, that the
+// cache settles under its budget whenever this frame's textures fit in it, that victims
+// come least recently used first, and that a slot's thumbnail and preview never collide
+// with each other or a neighbour's.
+//
+// Portable (no Win32 dependencies). Built by tests/CMakeLists.txt.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "texture_cache.h"
+
+constexpr size_t TEXTURE_BYTES = Rt4dDecoder::INDEX_BYTES;
+
+static int g_failures = 0;
+
+static void Expect(bool ok, const std::string& what) {
+    if (ok) return;
+    if (g_failures < 20) printf("FAIL %s\n", what.c_str());
+    g_failures++;
+}
+
+// The textures the test has "created", as the app's screenshots hold them
+using Resident = std::map<std::pair<uint32_t, TextureKind>, size_t>;
+
+static void Touch(TextureLru& lru, Resident& resident, ScreenshotHandle h, TextureKind kind, size_t bytes) {
+    lru.Touch(h, kind, bytes);
+    resident.insert({ { h.slot, kind }, bytes });
+}
+
+// TrimTextures: evicts until the cache names no victim. Returns how many it evicted.
+static int Trim(TextureLru& lru, Resident& resident) {
+    int evicted = 0;
+    const size_t tracked = resident.size();
+    ScreenshotHandle h;
+    TextureKind kind;
+    while (lru.Victim(h, kind) && (size_t)evicted < tracked) {
+        Expect(resident.erase({ h.slot, kind }) == 1, "trim: victim is a resident texture");
+        lru.Remove(h, kind);
+        lru.CountEviction();
+        evicted++;
+    }
+    return evicted;
+}
+
+static size_t Sum(const Resident& resident) {
+    size_t bytes = 0;
+    for (const auto& entry : resident) bytes += entry.second;
+    return bytes;
+}
+
+static ScreenshotHandle Handle(uint32_t slot) {
+    ScreenshotHandle h;
+    h.slot = slot;
+    return h;
+}
+
+static void TestAccounting() {
+    TextureLru lru(10 * TEXTURE_BYTES);
+    Resident resident;
+    Expect(lru.ResidentBytes() == 0 && lru.Count() == 0 && lru.Budget() == 10 * TEXTURE_BYTES, "accounting: empty");
+
+    Touch(lru, resident, Handle(0), TextureKind::Thumb, 100);
+    Touch(lru, resident, Handle(0), TextureKind::Preview, 300);
+    Touch(lru, resident, Handle(1), TextureKind::Thumb, 50);
+    Expect(lru.ResidentBytes() == 450 && lru.Count() == 3, "accounting: bytes and count after touches");
+
+    // Touching again counts nothing new; the bytes stay those given when it was created
+    lru.NextFrame();
+    Touch(lru, resident, Handle(0), TextureKind::Preview, 9999);
+    Expect(lru.ResidentBytes() == 450 && lru.Count() == 3, "accounting: retouch doesn't recount");
+
+    lru.Remove(Handle(0), TextureKind::Preview);
+    resident.erase({ 0, TextureKind::Preview });
+    Expect(lru.ResidentBytes() == 150 && lru.Count() == 2, "accounting: remove subtracts its bytes");
+    lru.Remove(Handle(0), TextureKind::Preview);
+    lru.Remove(Handle(7), TextureKind::Thumb);
+    Expect(lru.ResidentBytes() == 150 && lru.Count() == 2, "accounting: removing untracked textures changes nothing");
+
+    // Created again after removal, with its new size
+    Touch(lru, resident, Handle(0), TextureKind::Preview, 200);
+    Expect(lru.ResidentBytes() == 350 && lru.Count() == 3, "accounting: re-created texture counted once");
+
+    lru.Clear();
+    Expect(lru.ResidentBytes() == 0 && lru.Count() == 0, "accounting: clear");
+    ScreenshotHandle h;
+    TextureKind kind;
+    Expect(!lru.Victim(h, kind), "accounting: no victim when empty");
+}
+
+// A gallery of 400 screenshots scrolled at random, a window of thumbnails and one preview
+// drawn each frame, with previews either side prefetched
+static void TestBudget() {
+    const size_t budget = 64 * TEXTURE_BYTES;
+    TextureLru lru(budget);
+    Resident resident;
+    std::mt19937 rng(3);
+    const uint32_t screenshots = 400, visible = 40;
+    uint64_t evictions = 0;
+
+    for (int frame = 0; frame < 2000; frame++) {
+        lru.NextFrame();
+        uint32_t first = rng() % (screenshots - visible);
+        size_t touchedBytes = 0;
+        Resident touched;
+        for (uint32_t slot = first; slot < first + visible; slot++) {
+            Touch(lru, touched, Handle(slot), TextureKind::Thumb, TEXTURE_BYTES);
+        }
+        uint32_t selected = first + rng() % visible;
+        for (uint32_t slot : { selected, selected - 1, selected + 1 }) {
+            Touch(lru, touched, Handle(slot), TextureKind::Preview, TEXTURE_BYTES);
+        }
+        for (const auto& entry : touched) {
+            resident.insert(entry);
+            touchedBytes += entry.second;
+        }
+
+        evictions += Trim(lru, resident);
+        if (lru.ResidentBytes() != Sum(resident) || lru.Count() != resident.size()) {
+            Expect(false, "budget: resident bytes match the tracked textures at frame " + std::to_string(frame));
+            return;
+        }
+        if (touchedBytes <= budget && lru.ResidentBytes() > budget) {
+            Expect(false, "budget: over budget at frame " + std::to_string(frame));
+            return;
+        }
+        // Nothing drawn this frame is ever evicted
+        for (const auto& entry : touched) {
+            if (!resident.count(entry.first)) {
+                Expect(false, "budget: texture drawn this frame evicted at frame " + std::to_string(frame));
+                return;
+            }
+        }
+    }
+    Expect(evictions > 0 && lru.Evictions() == evictions, "budget: evictions counted");
+
+    // A lower budget takes effect at the next trim
+    lru.NextFrame();
+    lru.SetBudget(budget / 4);
+    Trim(lru, resident);
+    Expect(lru.ResidentBytes() <= budget / 4 && lru.ResidentBytes() == Sum(resident), "budget: lowered budget");
+}
+
+// When a single frame draws more than the budget, it all stays until the next frame
+static void TestOverBudgetFrame() {
+    TextureLru lru(4 * TEXTURE_BYTES);
+    Resident resident;
+    for (uint32_t slot = 0; slot < 10; slot++) Touch(lru, resident, Handle(slot), TextureKind::Thumb, TEXTURE_BYTES);
+    Expect(Trim(lru, resident) == 0 && lru.Count() == 10, "over budget: this frame's textures kept");
+
+    lru.NextFrame();
+    for (uint32_t slot = 0; slot < 2; slot++) Touch(lru, resident, Handle(slot), TextureKind::Thumb, TEXTURE_BYTES);
+    Expect(Trim(lru, resident) == 6 && lru.ResidentBytes() == 4 * TEXTURE_BYTES, "over budget: trimmed the next frame");
+}
+
+// Victims come least recently used first; touching a texture moves it to the back
+static void TestEvictionOrder() {
+    TextureLru lru(100 * TEXTURE_BYTES);
+    for (uint32_t slot = 0; slot < 10; slot++) {
+        lru.NextFrame();
+        lru.Touch(Handle(slot), TextureKind::Thumb, TEXTURE_BYTES);
+    }
+    lru.NextFrame();
+    lru.Touch(Handle(3), TextureKind::Thumb, TEXTURE_BYTES);
+    lru.Touch(Handle(7), TextureKind::Thumb, TEXTURE_BYTES);
+    lru.NextFrame();
+    lru.Touch(Handle(5), TextureKind::Thumb, TEXTURE_BYTES);
+
+    ScreenshotHandle h;
+    TextureKind kind;
+    Expect(!lru.Victim(h, kind), "order: no victim under budget");
+    lru.SetBudget(0);
+    std::vector<uint32_t> order;
+    while (lru.Victim(h, kind) && order.size() < 10) {
+        order.push_back(h.slot);
+        lru.Remove(h, kind);
+    }
+    const std::vector<uint32_t> expected = { 0, 1, 2, 4, 6, 8, 9, 3, 7 };
+    Expect(order == expected, "order: least recently used first, stopping at this frame's");
+    Expect(lru.Count() == 1 && lru.ResidentBytes() == TEXTURE_BYTES, "order: only this frame's texture left");
+}
+
+// Each slot's thumbnail and preview are separate entries: slot * 2 + kind keys never
+// collide with a neighbour's, and a victim names the right kind and handle
+static void TestKinds() {
+    TextureLru lru(100 * TEXTURE_BYTES);
+    ScreenshotHandle zero = Handle(0), one = Handle(1);
+    lru.Touch(zero, TextureKind::Preview, 300);
+    lru.Touch(one, TextureKind::Thumb, 20);
+    lru.Touch(one, TextureKind::Preview, 400);
+    lru.Touch(zero, TextureKind::Thumb, 10);
+    Expect(lru.Count() == 4 && lru.ResidentBytes() == 730, "kinds: four distinct entries");
+
+    lru.Remove(zero, TextureKind::Preview);
+    Expect(lru.Count() == 3 && lru.ResidentBytes() == 430, "kinds: removing slot 0's preview leaves slot 1's thumb");
+    lru.Remove(one, TextureKind::Thumb);
+    Expect(lru.Count() == 2 && lru.ResidentBytes() == 410, "kinds: removing slot 1's thumb leaves the previews");
+
+    lru.NextFrame();
+    lru.SetBudget(0);
+    ScreenshotHandle h;
+    TextureKind kind = TextureKind::Thumb;
+    Expect(lru.Victim(h, kind) && h.slot == 1 && kind == TextureKind::Preview, "kinds: victim is slot 1's preview");
+    lru.Remove(h, kind);
+    Expect(lru.Victim(h, kind) && h.slot == 0 && kind == TextureKind::Thumb, "kinds: then slot 0's thumb");
+    lru.Remove(h, kind);
+    Expect(!lru.Victim(h, kind) && lru.Count() == 0 && lru.ResidentBytes() == 0, "kinds: empty");
+
+    // A victim carries the handle it was last touched with, so the caller frees the
+    // textures of the screenshot that now holds the slot
+    ScreenshotHandle reused = Handle(0);
+    reused.generation = 2;
+    lru.Touch(Handle(0), TextureKind::Thumb, 10);
+    lru.Touch(reused, TextureKind::Thumb, 10);
+    lru.NextFrame();
+    Expect(lru.Count() == 1 && lru.Victim(h, kind) && h == reused, "kinds: victim has the latest handle");
+}
+
+int main() {
+    TestAccounting();
+    TestBudget();
+    TestOverBudgetFrame();
+    TestEvictionOrder();
+    TestKinds();
+
+    if (g_failures) {
+        printf("%d failures\n", g_failures);
+        return 1;
+    }
+    printf("Texture cache: byte accounting, budget, eviction order and keys OK\n");
+    return 0;
+}
@@ -0,0 +1,138 @@
+// RadShot - Thumbnail atlas test
+// Allocates and frees AtlasGrid cells the way the gallery does as thumbnails are created
+// and evicted: cells tile each page without overlap, their UVs match their origins, freed
+// cells come back lowest first before any new cell is issued, and a new page is needed
+// only when more cells are live at once than the pages so far hold.
+//
+// Portable (no Win32 dependencies). Built by tests/CMakeLists.txt.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "frame_decoder.h"
+#include "thumb_atlas.h"
+
+static int g_failures = 0;
+
+static void Expect(bool ok, const std::string& what) {
+    if (ok) return;
+    if (g_failures < 20) printf("FAIL %s\n", what.c_str());
+    g_failures++;
+}
+
+// Every cell of a page lies inside it, on the grid, and no two overlap
+static void TestLayout() {
+    AtlasGrid grid(ATLAS_PAGE_SIZE, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    const int columns = ATLAS_PAGE_SIZE / DISPLAY_WIDTH, rows = ATLAS_PAGE_SIZE / DISPLAY_HEIGHT;
+    Expect(grid.CellsPerPage() == columns * rows, "layout: cells per page");
+    Expect(grid.Pages() == 0 && grid.Used() == 0, "layout: empty grid has no pages");
+
+    std::vector<bool> taken(columns * rows, false);
+    bool inside = true, unique = true, uvMatch = true;
+    for (int i = 0; i < grid.CellsPerPage(); i++) {
+        uint32_t cell = grid.Alloc();
+        Expect(cell == (uint32_t)i + 1, "layout: fresh cells issued in order");
+        int x, y;
+        grid.Origin(cell, x, y);
+        inside = inside && grid.Page(cell) == 0 && x % DISPLAY_WIDTH == 0 && y % DISPLAY_HEIGHT == 0 &&
+                 x >= 0 && y >= 0 && x + DISPLAY_WIDTH <= ATLAS_PAGE_SIZE && y + DISPLAY_HEIGHT <= ATLAS_PAGE_SIZE;
+        if (!inside) break;
+        int index = (y / DISPLAY_HEIGHT) * columns + x / DISPLAY_WIDTH;
+        unique = unique && !taken[index];
+        taken[index] = true;
+
+        float u0, v0, u1, v1;
+        grid.UV(cell, u0, v0, u1, v1);
+        uvMatch = uvMatch && u0 == (float)x / ATLAS_PAGE_SIZE && v0 == (float)y / ATLAS_PAGE_SIZE &&
+                  u1 == (float)(x + DISPLAY_WIDTH) / ATLAS_PAGE_SIZE && v1 == (float)(y + DISPLAY_HEIGHT) / ATLAS_PAGE_SIZE;
+    }
+    Expect(inside, "layout: cells inside the page, on the grid");
+    Expect(unique, "layout: no two cells overlap");
+    Expect(uvMatch, "layout: UVs match origins");
+    Expect(grid.Pages() == 1 && grid.Used() == (size_t)grid.CellsPerPage(), "layout: one full page");
+
+    // The next cell starts a second page, at its top-left
+    uint32_t next = grid.Alloc();
+    int x, y;
+    grid.Origin(next, x, y);
+    Expect(grid.Pages() == 2 && grid.Page(next) == 1 && x == 0 && y == 0, "layout: second page starts at its origin");
+}
+
+static void TestReuse() {
+    AtlasGrid grid(ATLAS_PAGE_SIZE, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    for (int i = 0; i < 20; i++) grid.Alloc();
+
+    // Freed cells come back lowest first, then new ones are issued
+    grid.Free(9);
+    grid.Free(3);
+    grid.Free(15);
+    Expect(grid.Used() == 17, "reuse: used after free");
+    Expect(grid.Alloc() == 3 && grid.Alloc() == 9 && grid.Alloc() == 15, "reuse: lowest freed cell first");
+    Expect(grid.Alloc() == 21 && grid.Used() == 21, "reuse: then a new cell");
+
+    // Cell 0 means "no cell" and is ignored
+    grid.Free(0);
+    Expect(grid.Used() == 21, "reuse: freeing cell 0 ignored");
+
+    // A hole on the first page is filled before one on the second
+    while (grid.Pages() < 2) grid.Alloc();
+    uint32_t secondPage = (uint32_t)grid.CellsPerPage() + 1;
+    grid.Free(secondPage);
+    grid.Free(7);
+    Expect(grid.Alloc() == 7 && grid.Alloc() == secondPage && grid.Pages() == 2, "reuse: first page filled first");
+
+    grid.Clear();
+    Expect(grid.Pages() == 0 && grid.Used() == 0 && grid.Alloc() == 1, "reuse: Clear starts over");
+}
+
+// Thumbnails created and evicted at random: live cells never collide, and the pages only
+// grow to hold the most cells ever live at once
+static void TestChurn() {
+    AtlasGrid grid(ATLAS_PAGE_SIZE, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    std::mt19937 rng(11);
+    std::set<uint32_t> live;
+    size_t peak = 0;
+    for (int op = 0; op < 20000; op++) {
+        // Drifts between a few cells and a few pages' worth
+        bool alloc = live.empty() || rng() % 1000 < (op % 8000 < 4000 ? 550u : 450u);
+        if (alloc) {
+            uint32_t cell = grid.Alloc();
+            if (!live.insert(cell).second) {
+                Expect(false, "churn: cell " + std::to_string(cell) + " handed out twice");
+                return;
+            }
+        } else {
+            auto it = live.begin();
+            std::advance(it, rng() % live.size());
+            grid.Free(*it);
+            live.erase(it);
+        }
+        peak = (std::max)(peak, live.size());
+        size_t pagesNeeded = (peak + grid.CellsPerPage() - 1) / grid.CellsPerPage();
+        if (grid.Used() != live.size() || (size_t)grid.Pages() != pagesNeeded) {
+            Expect(false, "churn: used " + std::to_string(grid.Used()) + ", pages " + std::to_string(grid.Pages()) +
+                   " with " + std::to_string(live.size()) + " live, peak " + std::to_string(peak));
+            return;
+        }
+    }
+    Expect(grid.Pages() > 1, "churn: grew past one page");
+}
+
+int main() {
+    TestLayout();
+    TestReuse();
+    TestChurn();
+
+    if (g_failures) {
+        printf("%d failures\n", g_failures);
+        return 1;
+    }
+    printf("Thumbnail atlas: layout, cell reuse and page growth OK\n");
+    return 0;
+}
@@ -0,0 +1,119 @@
+// RadShot - GPU texture residency
+// Screenshot textures are a cache, not something each screenshot holds for life: every
+// texture drawn (or prefetched) in a frame is touched, and once the total goes over the
+// budget the least recently used ones that weren't touched this frame are evicted.
+// Entries are keyed by store slot and kind and linked through per-key arrays, so touch,
+// remove and picking a victim are all O(1).
+// Portable header; the caller creates and deletes the textures this tracks.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "screenshot_store.h"
+
+constexpr size_t DEFAULT_TEXTURE_BUDGET_MB = 32;
+
+enum class TextureKind : uint32_t { Thumb = 0, Preview = 1 };
+
+class TextureLru {
+public:
+    explicit TextureLru(size_t budgetBytes) : budget_(budgetBytes) {}
+
+    void SetBudget(size_t bytes) { budget_ = bytes; }
+    size_t Budget() const { return budget_; }
+
+    // Starts a new frame: textures touched before this may be evicted
+    void NextFrame() { frame_++; }
+
+    // Marks a texture as used this frame, tracking it if it's new
+    void Touch(ScreenshotHandle h, TextureKind kind, size_t bytes) {
+        uint32_t key = Key(h, kind);
+        if (key >= nodes_.size()) nodes_.resize(key + 2);
+        Node& node = nodes_[key];
+        if (node.linked) {
+            Unlink(key);
+        } else {
+            node.linked = true;
+            node.bytes = bytes;
+            resident_ += bytes;
+            count_++;
+        }
+        node.handle = h;
+        node.frame = frame_;
+        PushFront(key);
+    }
+
+    // Stops tracking a texture (after it has been deleted)
+    void Remove(ScreenshotHandle h, TextureKind kind) {
+        uint32_t key = Key(h, kind);
+        if (key >= nodes_.size() || !nodes_[key].linked) return;
+        Unlink(key);
+        nodes_[key].linked = false;
+        resident_ -= nodes_[key].bytes;
+        count_--;
+    }
+
+    void Clear() {
+        nodes_.clear();
+        head_ = tail_ = NONE;
+        resident_ = 0;
+        count_ = 0;
+    }
+
+    // The texture to evict next: the least recently used one, if the cache is over budget
+    // and it wasn't touched this frame. The caller deletes it and calls Remove.
+    bool Victim(ScreenshotHandle& h, TextureKind& kind) const {
+        if (resident_ <= budget_ || tail_ == NONE || nodes_[tail_].frame == frame_) return false;
+        h = nodes_[tail_].handle;
+        kind = (TextureKind)(tail_ & 1);
+        return true;
+    }
+
+    void CountEviction() { evictions_++; }
+
+    size_t ResidentBytes() const { return resident_; }
+    size_t Count() const { return count_; }
+    uint64_t Evictions() const { return evictions_; }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Node {
+        ScreenshotHandle handle;
+        uint64_t frame = 0;
+        size_t bytes = 0;
+        uint32_t prev = NONE;   // Towards the most recent
+        uint32_t next = NONE;   // Towards the least recent
+        bool linked = false;
+    };
+
+    static uint32_t Key(ScreenshotHandle h, TextureKind kind) { return h.slot * 2 + (uint32_t)kind; }
+
+    void PushFront(uint32_t key) {
+        Node& node = nodes_[key];
+        node.prev = NONE;
+        node.next = head_;
+        if (head_ != NONE) nodes_[head_].prev = key;
+        head_ = key;
+        if (tail_ == NONE) tail_ = key;
+    }
+
+    void Unlink(uint32_t key) {
+        Node& node = nodes_[key];
+        if (node.prev != NONE) nodes_[node.prev].next = node.next; else head_ = node.next;
+        if (node.next != NONE) nodes_[node.next].prev = node.prev; else tail_ = node.prev;
+        node.prev = node.next = NONE;
+    }
+
+    std::vector<Node> nodes_;   // By slot * 2 + kind
+    uint32_t head_ = NONE;
+    uint32_t tail_ = NONE;
+    uint64_t frame_ = 1;
+    size_t budget_;
+    size_t resident_ = 0;
+    size_t count_ = 0;
+    uint64_t evictions_ = 0;
+};
@@ -0,0 +1,85 @@
+// RadShot - Thumbnail atlas
+// Thumbnails are cells of a few large atlas pages instead of one texture each, so the
+// visible gallery samples one or two textures and ImGui can merge consecutive thumbnails
+// into one draw call. Every cell is the same size, so a grid with a free list is the
+// whole allocator; the lowest free cell is reused first to keep neighbours on one page.
+// Portable header: this hands out cells and their coordinates, the caller owns one GPU
+// texture per page.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+constexpr int ATLAS_PAGE_SIZE = 1024;   // 8 x 16 thumbnails (1 MB of GL_R8) per page
+
+class AtlasGrid {
+public:
+    AtlasGrid(int pageSize, int cellWidth, int cellHeight)
+        : page_size_(pageSize), cell_width_(cellWidth), cell_height_(cellHeight),
+          columns_(pageSize / cellWidth), cells_per_page_((pageSize / cellWidth) * (pageSize / cellHeight)) {}
+
+    // Returns a cell id (never 0, so 0 can mean "no cell"). Grows by a page when full;
+    // check Pages() afterwards for a new page to create.
+    uint32_t Alloc() {
+        used_++;
+        if (!free_.empty()) {
+            uint32_t cell = free_.top();
+            free_.pop();
+            return cell;
+        }
+        return ++issued_;
+    }
+
+    void Free(uint32_t cell) {
+        if (cell == 0) return;
+        free_.push(cell);
+        used_--;
+    }
+
+    void Clear() {
+        free_ = FreeList();
+        issued_ = 0;
+        used_ = 0;
+    }
+
+    // Pages needed for every cell issued so far
+    int Pages() const { return (int)((issued_ + cells_per_page_ - 1) / cells_per_page_); }
+    int Page(uint32_t cell) const { return (int)((cell - 1) / cells_per_page_); }
+
+    // Top-left pixel of the cell in its page
+    void Origin(uint32_t cell, int& x, int& y) const {
+        uint32_t index = (cell - 1) % cells_per_page_;
+        x = (int)(index % columns_) * cell_width_;
+        y = (int)(index / columns_) * cell_height_;
+    }
+
+    void UV(uint32_t cell, float& u0, float& v0, float& u1, float& v1) const {
+        int x, y;
+        Origin(cell, x, y);
+        float scale = 1.0f / page_size_;
+        u0 = x * scale;
+        v0 = y * scale;
+        u1 = (x + cell_width_) * scale;
+        v1 = (y + cell_height_) * scale;
+    }
+
+    int PageSize() const { return page_size_; }
+    int CellsPerPage() const { return (int)cells_per_page_; }
+    size_t Used() const { return used_; }
+
+private:
+    using FreeList = std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>>;
+
+    int page_size_;
+    int cell_width_;
+    int cell_height_;
+    uint32_t columns_;
+    uint32_t cells_per_page_;
+    uint32_t issued_ = 0;      // Highest cell id handed out
+    size_t used_ = 0;
+    FreeList free_;
+};
@@ -0,0 +1,392 @@
+// RadShot - RT-4D device simulator
+// Opens a pseudo-terminal and behaves like a screenshot-enabled RT-4D: every
+// SCREENSHOT_CMD (0x41 0x41) is answered with a 1024-byte page-major frame.
+// Link speed, latency, jitter, byte drops, truncated and over-long frames are configurable,
+// so the capture path can be benchmarked and regression-tested without a radio.
+//
+// POSIX only. Build with:
+//     g++ -std=c++14 -O2 -I. -o rt4d_sim tools/rt4d_sim.cpp
+// tests/CMakeLists.txt also builds it for simulator_test.
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_decoder.h"
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+constexpr uint8_t SCREENSHOT_CMD[] = { 0x41, 0x41 };
+constexpr int CHUNK_SIZE = 32;  // Bytes written per paced burst
+
+struct SimConfig {
+    const char* link_path = nullptr;
+    const char* frames_dir = nullptr;
+    uint32_t baud = 115200;     // 0 = unpaced
+    double latency_ms = 2.0;    // Before the first byte of a response
+    double jitter_ms = 0.0;     // Random extra delay per chunk, 0..jitter_ms
+    double drop_rate = 0.0;     // Probability of dropping each byte
+    double truncate_rate = 0.0; // Probability of cutting a response short
+    double overrun_rate = 0.0;  // Probability of trailing junk behind a response
+    bool static_frame = false;
+    bool strict_baud = false;   // Ignore requests unless the host opened the port at `baud`
+    bool verbose = false;
+    uint32_t seed = 1;
+};
+
+struct SimStats {
+    uint64_t commands = 0;
+    uint64_t bytes_sent = 0;
+    uint64_t bytes_dropped = 0;
+    uint64_t truncated = 0;
+    uint64_t overrun = 0;
+    uint64_t wrong_baud = 0;    // Request bytes ignored under --strict-baud
+};
+
+static volatile sig_atomic_t g_quit = 0;
+
+static void OnSignal(int) {
+    g_quit = 1;
+}
+
+static void PrintUsage(const char* argv0) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --link PATH       Symlink the pty slave to PATH (e.g. /tmp/ttyRT4D)\n"
+        "  --baud N          Pace output at N baud, 10 bits per byte; 0 = unpaced (115200)\n"
+        "  --latency MS      Delay before the first byte of a response (2)\n"
+        "  --jitter MS       Random extra delay per %d-byte chunk, 0..MS (0)\n"
+        "  --drop P          Probability of dropping each byte (0)\n"
+        "  --truncate P      Probability of cutting a response short (0)\n"
+        "  --overrun P       Probability of 1..%d junk bytes right behind a response (0)\n"
+        "  --frames DIR      Serve 1024-byte *.bin dumps from DIR in name order, looping\n"
+        "  --static          Serve the same frame every time\n"
+        "  --strict-baud     Only answer when the host port is set to --baud, like a real UART\n"
+        "  --seed N          Random seed (1)\n"
+        "  --verbose         Log every request\n",
+        argv0, CHUNK_SIZE, CHUNK_SIZE);
+}
+
+static bool ParseArgs(int argc, char** argv, SimConfig& cfg) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool takesValue = true;
+
+        if (strcmp(arg, "--link") == 0 && value) cfg.link_path = value;
+        else if (strcmp(arg, "--frames") == 0 && value) cfg.frames_dir = value;
+        else if (strcmp(arg, "--baud") == 0 && value) cfg.baud = (uint32_t)atoi(value);
+        else if (strcmp(arg, "--latency") == 0 && value) cfg.latency_ms = atof(value);
+        else if (strcmp(arg, "--jitter") == 0 && value) cfg.jitter_ms = atof(value);
+        else if (strcmp(arg, "--drop") == 0 && value) cfg.drop_rate = atof(value);
+        else if (strcmp(arg, "--truncate") == 0 && value) cfg.truncate_rate = atof(value);
+        else if (strcmp(arg, "--overrun") == 0 && value) cfg.overrun_rate = atof(value);
+        else if (strcmp(arg, "--seed") == 0 && value) cfg.seed = (uint32_t)atoi(value);
+        else {
+            takesValue = false;
+            if (strcmp(arg, "--static") == 0) cfg.static_frame = true;
+            else if (strcmp(arg, "--strict-baud") == 0) cfg.strict_baud = true;
+            else if (strcmp(arg, "--verbose") == 0) cfg.verbose = true;
+            else return false;
+        }
+        if (takesValue) i++;
+    }
+    return true;
+}
+
+// =============================================================================
+// Frame Sources
+// =============================================================================
+
+static std::vector<std::vector<uint8_t>> LoadFrames(const char* dir) {
+    std::vector<std::string> names;
+    DIR* d = opendir(dir);
+    if (!d) return {};
+    while (dirent* entry = readdir(d)) {
+        size_t len = strlen(entry->d_name);
+        if (len > 4 && strcmp(entry->d_name + len - 4, ".bin") == 0) {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+
+    std::vector<std::vector<uint8_t>> frames;
+    for (const std::string& name : names) {
+        std::string path = std::string(dir) + "/" + name;
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) continue;
+        std::vector<uint8_t> frame(BITMAP_SIZE);
+        size_t n = fread(frame.data(), 1, BITMAP_SIZE, f);
+        bool extra = fgetc(f) != EOF;
+        fclose(f);
+        if (n == BITMAP_SIZE && !extra) {
+            frames.push_back(frame);
+        } else {
+            fprintf(stderr, "Skipping %s: not a %d-byte frame\n", path.c_str(), BITMAP_SIZE);
+        }
+    }
+    return frames;
+}
+
+// Synthetic frame: a diagonal stripe pattern that moves with `index`, plus the
+// index itself in binary across the top page so every frame is distinct.
+static void MakeSyntheticFrame(uint64_t index, uint8_t* frame) {
+    for (int page = 0; page < DISPLAY_HEIGHT / 8; page++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            uint8_t column = 0;
+            for (int bit = 0; bit < 8; bit++) {
+                int y = page * 8 + bit;
+                if (((x + y + (int)index) & 15) < 4) column |= (uint8_t)(1 << bit);
+            }
+            frame[page * DISPLAY_WIDTH + x] = column;
+        }
+    }
+    for (int b = 0; b < 32; b++) {
+        uint8_t bar = ((index >> b) & 1) ? 0xFF : 0x81;
+        for (int x = 0; x < 4; x++) frame[b * 4 + x] = bar;
+    }
+}
+
+// =============================================================================
+// Response Pacing
+// =============================================================================
+
+using Clock = std::chrono::steady_clock;
+
+static void SleepUntil(Clock::time_point t) {
+    std::this_thread::sleep_until(t);
+}
+
+static bool WriteAll(int fd, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n > 0) {
+            data += n;
+            len -= (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EINTR) return false;
+        pollfd pfd = { fd, POLLOUT, 0 };
+        poll(&pfd, 1, 100);
+    }
+    return true;
+}
+
+// A pty has no line rate, but the master sees the speed the host configured on the slave.
+// With --strict-baud a mismatch stands in for the garbled bytes a real UART would receive.
+static bool HostBaudMatches(int master, uint32_t baud) {
+    speed_t want = 0;
+    switch (baud) {
+    case 9600: want = B9600; break;
+    case 19200: want = B19200; break;
+    case 38400: want = B38400; break;
+    case 57600: want = B57600; break;
+    case 115200: want = B115200; break;
+    case 230400: want = B230400; break;
+#ifdef B460800
+    case 460800: want = B460800; break;
+#endif
+#ifdef B921600
+    case 921600: want = B921600; break;
+#endif
+    default: return true;
+    }
+    termios tio;
+    if (tcgetattr(master, &tio) != 0) return true;
+    return cfgetospeed(&tio) == want;
+}
+
+// Sends one response, applying latency, baud pacing, jitter, drops, truncation and overrun.
+static bool SendResponse(int fd, const uint8_t* frame, const SimConfig& cfg,
+                         std::mt19937& rng, SimStats& stats) {
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    uint8_t response[BITMAP_SIZE + CHUNK_SIZE];
+    memcpy(response, frame, BITMAP_SIZE);
+    size_t length = BITMAP_SIZE;
+    if (unit(rng) < cfg.truncate_rate) {
+        length = std::uniform_int_distribution<size_t>(0, BITMAP_SIZE - 1)(rng);
+        stats.truncated++;
+    } else if (unit(rng) < cfg.overrun_rate) {
+        size_t extra = std::uniform_int_distribution<size_t>(1, CHUNK_SIZE)(rng);
+        memset(response + BITMAP_SIZE, 0xA5, extra);
+        length += extra;
+        stats.overrun++;
+    }
+    frame = response;
+
+    auto start = Clock::now() + std::chrono::microseconds((int64_t)(cfg.latency_ms * 1000.0));
+    double jitterTotalUs = 0.0;
+    size_t onWire = 0;  // Bytes the link has spent time on, including dropped ones
+
+    for (size_t pos = 0; pos < length && !g_quit; pos += CHUNK_SIZE) {
+        size_t chunk = std::min((size_t)CHUNK_SIZE, length - pos);
+
+        if (cfg.jitter_ms > 0.0) jitterTotalUs += unit(rng) * cfg.jitter_ms * 1000.0;
+        double wireUs = cfg.baud ? (double)onWire * 10.0 * 1e6 / cfg.baud : 0.0;
+        SleepUntil(start + std::chrono::microseconds((int64_t)(wireUs + jitterTotalUs)));
+
+        uint8_t out[CHUNK_SIZE];
+        size_t kept = 0;
+        for (size_t i = 0; i < chunk; i++) {
+            if (cfg.drop_rate > 0.0 && unit(rng) < cfg.drop_rate) {
+                stats.bytes_dropped++;
+                continue;
+            }
+            out[kept++] = frame[pos + i];
+        }
+        if (kept && !WriteAll(fd, out, kept)) return false;
+        stats.bytes_sent += kept;
+        onWire += chunk;
+    }
+
+    // Hold the line for the time the last chunk takes to transmit
+    if (cfg.baud) {
+        double wireUs = (double)onWire * 10.0 * 1e6 / cfg.baud;
+        SleepUntil(start + std::chrono::microseconds((int64_t)(wireUs + jitterTotalUs)));
+    }
+    return true;
+}
+
+// =============================================================================
+// Entry Point
+// =============================================================================
+
+int main(int argc, char** argv) {
+    SimConfig cfg;
+    if (!ParseArgs(argc, argv, cfg)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    std::vector<std::vector<uint8_t>> frames;
+    if (cfg.frames_dir) {
+        frames = LoadFrames(cfg.frames_dir);
+        if (frames.empty()) {
+            fprintf(stderr, "No frames found in %s\n", cfg.frames_dir);
+            return 1;
+        }
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("posix_openpt");
+        return 1;
+    }
+    const char* slaveName = ptsname(master);
+    if (!slaveName) {
+        perror("ptsname");
+        return 1;
+    }
+
+    // Keep a slave fd open so the master doesn't see hangups between clients,
+    // and make the line raw so nothing is echoed or translated before a client configures it
+    int slave = open(slaveName, O_RDWR | O_NOCTTY);
+    if (slave < 0) {
+        perror("open slave");
+        return 1;
+    }
+    termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    fcntl(master, F_SETFL, O_NONBLOCK);
+
+    if (cfg.link_path) {
+        unlink(cfg.link_path);
+        if (symlink(slaveName, cfg.link_path) != 0) {
+            perror("symlink");
+            return 1;
+        }
+    }
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+
+    printf("RT-4D simulator on %s%s%s (%u baud, %.1f ms latency)\n",
+           slaveName, cfg.link_path ? " -> " : "", cfg.link_path ? cfg.link_path : "",
+           cfg.baud, cfg.latency_ms);
+    fflush(stdout);
+
+    std::mt19937 rng(cfg.seed);
+    SimStats stats;
+    uint64_t frameIndex = 0;
+    int matched = 0;  // Bytes of SCREENSHOT_CMD seen so far
+    uint8_t frame[BITMAP_SIZE];
+
+    while (!g_quit) {
+        pollfd pfd = { master, POLLIN, 0 };
+        if (poll(&pfd, 1, 200) <= 0) continue;
+
+        uint8_t buf[64];
+        ssize_t n = read(master, buf, sizeof(buf));
+        if (n <= 0) {
+            if (n < 0 && (errno == EAGAIN || errno == EINTR || errno == EIO)) continue;
+            break;
+        }
+
+        if (cfg.strict_baud && cfg.baud && !HostBaudMatches(master, cfg.baud)) {
+            stats.wrong_baud += (uint64_t)n;
+            matched = 0;
+            if (cfg.verbose) {
+                printf("ignored %d bytes at the wrong baud rate\n", (int)n);
+                fflush(stdout);
+            }
+            continue;
+        }
+
+        for (ssize_t i = 0; i < n && !g_quit; i++) {
+            matched = buf[i] == SCREENSHOT_CMD[matched] ? matched + 1 :
+                      buf[i] == SCREENSHOT_CMD[0] ? 1 : 0;
+            if (matched < (int)sizeof(SCREENSHOT_CMD)) continue;
+            matched = 0;
+
+            if (!frames.empty()) {
+                memcpy(frame, frames[frameIndex % frames.size()].data(), BITMAP_SIZE);
+            } else {
+                MakeSyntheticFrame(cfg.static_frame ? 0 : frameIndex, frame);
+            }
+            if (!cfg.static_frame) frameIndex++;
+            stats.commands++;
+
+            auto t0 = Clock::now();
+            if (!SendResponse(master, frame, cfg, rng, stats)) {
+                g_quit = 1;
+                break;
+            }
+            if (cfg.verbose) {
+                double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+                printf("request %llu served in %.1f ms\n", (unsigned long long)stats.commands, ms);
+                fflush(stdout);
+            }
+        }
+    }
+
+    if (cfg.link_path) unlink(cfg.link_path);
+    close(slave);
+    close(master);
+
+    printf("%llu requests, %llu bytes sent, %llu dropped, %llu truncated, %llu overrun, %llu wrong-baud bytes\n",
+           (unsigned long long)stats.commands, (unsigned long long)stats.bytes_sent,
+           (unsigned long long)stats.bytes_dropped, (unsigned long long)stats.truncated,
+           (unsigned long long)stats.overrun, (unsigned long long)stats.wrong_baud);
+    return 0;
+}